@@ -11,6 +11,19 @@
 
 // The content is zero or "" when first created.
 
+// With OW_CONDITION_TABLE defined in User_Setup.h the weather main, description and
+// icon Strings are not stored. Only the weather id and a day/night bit per slot are
+// kept, the text is looked up from the id with the conditionMain(), conditionDescription()
+// and conditionIcon() member functions of the OW_Weather class.
+
+// Bytes needed for N day/night bits
+#define OW_BITS(N) (((N) + 7) / 8)
+
+// Day/night bit for slot n, true if night
+inline bool OW_isNight(const uint8_t *night, uint8_t n) {
+  return (night[n >> 3] >> (n & 7)) & 1;
+}
+
 /***************************************************************************************
 ** Description:   Structure for current weather using onecall API
 ***************************************************************************************/
@@ -36,9 +49,13 @@ typedef struct OW_current {
 
   // current.weather
   uint16_t id = 0;
+#ifdef OW_CONDITION_TABLE
+  uint8_t  night[1] = { 0 };  // Day/night bit, see OW_isNight()
+#else
   String   main;
   String   description;
   String   icon;
+#endif
 
 } OW_current;
 
@@ -63,9 +80,13 @@ typedef struct OW_hourly {
 
   // hourly.weather
   uint16_t id[MAX_HOURS] = { 0 };
+#ifdef OW_CONDITION_TABLE
+  uint8_t  night[OW_BITS(MAX_HOURS)] = { 0 };  // Day/night bit per slot, see OW_isNight()
+#else
   String   main[MAX_HOURS];
   String   description[MAX_HOURS];
   String   icon[MAX_HOURS];
+#endif
   float    pop[MAX_HOURS];
   float    rain1h[MAX_HOURS];
 } OW_hourly;
@@ -112,9 +133,13 @@ typedef struct OW_daily {
 
   // hourly.weather
   uint16_t id[MAX_DAYS] = { 0 };
+#ifdef OW_CONDITION_TABLE
+  uint8_t  night[OW_BITS(MAX_DAYS)] = { 0 };  // Day/night bit per slot, see OW_isNight()
+#else
   String   main[MAX_DAYS];
   String   description[MAX_DAYS];
   String   icon[MAX_DAYS];
+#endif
   float    pop[MAX_DAYS];
 
 } OW_daily;
@@ -139,9 +164,13 @@ typedef struct OW_forecast {
   uint8_t  humidity[MAX_3HRS] = { 0 };
 
   uint16_t id[MAX_3HRS] = { 0 };
+#ifdef OW_CONDITION_TABLE
+  uint8_t  night[OW_BITS(MAX_3HRS)] = { 0 };  // Day/night bit per slot, see OW_isNight()
+#else
   String   main[MAX_3HRS];
   String   description[MAX_3HRS];
   String   icon[MAX_3HRS];
+#endif
 
   uint8_t  clouds_all[MAX_3HRS] = { 0 };
 
@@ -165,85 +194,457 @@ typedef struct OW_forecast {
 } OW_forecast;
 
 
-// Structures for minimal set of data points for TFT_eSPI examples to reduce RAM needs
-/*
-typedef struct OW_current {
+/***************************************************************************************
+** Description:   Compact structure for the "forecast" API, about half the RAM
+***************************************************************************************/
+// Values are held as scaled integers, the API does not send more precision than is
+// kept here. Use the accessor functions to get the float values, e.g. forecast->temp(n)
+// The dt_txt Strings are not kept, the same time is in dt.
+typedef struct OW_forecast_compact {
 
-  //float    lat = 0;
-  //float    lon = 0;
-  //String   timezone;
+  // list.Nth 3hr slot
+  uint32_t dt[MAX_3HRS] = { 0 };
 
-  // current
-  uint32_t dt = 0;
-  uint32_t sunrise = 0;
-  uint32_t sunset = 0;
-  float    temp = 0;
-  //float    feels_like = 0;
-  float    pressure = 0;
-  uint8_t  humidity = 0;
-  //float    dew_point = 0;
-  uint8_t  clouds = 0;
-  //uint8_t  uvi = 0;
-  //uint32_t visibility = 0;
-  float    wind_speed = 0;
-  //float    wind_gust = 0;
-  uint16_t wind_deg = 0;
-  //float    rain = 0;
-  //float    snow = 0;
+  // main
+  int16_t  temp_x100[MAX_3HRS] = { 0 };       // Temperature x 100
+  int16_t  feels_like_x100[MAX_3HRS] = { 0 };
+  int16_t  temp_min_x100[MAX_3HRS] = { 0 };
+  int16_t  temp_max_x100[MAX_3HRS] = { 0 };
+  uint16_t pressure[MAX_3HRS] = { 0 };        // hPa
+  uint16_t sea_level[MAX_3HRS] = { 0 };
+  uint16_t grnd_level[MAX_3HRS] = { 0 };
+  uint8_t  humidity[MAX_3HRS] = { 0 };
 
-  // current.weather
-  uint16_t id = 0;
-  String   main;
-  //String   description;
-  //String   icon;
+  uint16_t id[MAX_3HRS] = { 0 };
+#ifdef OW_CONDITION_TABLE
+  uint8_t  night[OW_BITS(MAX_3HRS)] = { 0 };  // Day/night bit per slot, see OW_isNight()
+#else
+  String   main[MAX_3HRS];
+  String   description[MAX_3HRS];
+  String   icon[MAX_3HRS];
+#endif
 
-} OW_current;
+  uint8_t  clouds_all[MAX_3HRS] = { 0 };
 
+  int16_t  wind_speed_x100[MAX_3HRS] = { 0 }; // Wind speed x 100
+  uint16_t wind_deg[MAX_3HRS] = { 0 };
+  int16_t  wind_gust_x100[MAX_3HRS] = { 0 };
 
-typedef struct OW_hourly {
+  uint16_t visibility_dam[MAX_3HRS] = { 0 };  // Visibility in decametres
+  uint8_t  pop_x100[MAX_3HRS] = { 0 };        // Probability of precipitation x 100
 
-} OW_hourly;
+  // city
+  String   city_name = "";
+  int32_t  timezone = 0;
+  uint32_t sunrise = 0;
+  uint32_t sunset = 0;
 
-typedef struct OW_daily {
+  // Accessors for the scaled values
+  float    temp(uint8_t n)       const { return temp_x100[n] * 0.01f; }
+  float    feels_like(uint8_t n) const { return feels_like_x100[n] * 0.01f; }
+  float    temp_min(uint8_t n)   const { return temp_min_x100[n] * 0.01f; }
+  float    temp_max(uint8_t n)   const { return temp_max_x100[n] * 0.01f; }
+  float    wind_speed(uint8_t n) const { return wind_speed_x100[n] * 0.01f; }
+  float    wind_gust(uint8_t n)  const { return wind_gust_x100[n] * 0.01f; }
+  float    pop(uint8_t n)        const { return pop_x100[n] * 0.01f; }
+  uint32_t visibility(uint8_t n) const { return visibility_dam[n] * 10UL; }
 
-  // daily
-  uint32_t dt[MAX_DAYS] = { 0 };  // dt
-  //uint32_t sunrise = 0;
-  //uint32_t sunset = 0;
-  
-  // daily.temp
-  //float    temp_morn[MAX_DAYS] = { 0 };
-  //float    temp_day[MAX_DAYS] = { 0 };
-  //float    temp_eve[MAX_DAYS] = { 0 };
-  //float    temp_night[MAX_DAYS] = { 0 };
-  float    temp_min[MAX_DAYS] = { 0 };
-  float    temp_max[MAX_DAYS] = { 0 };
+} OW_forecast_compact;
 
-  // daily.feels_like
-  //float    feels_like_morn[MAX_DAYS] = { 0 };
-  //float    feels_like_day[MAX_DAYS] = { 0 };
-  //float    feels_like_eve[MAX_DAYS] = { 0 };
-  //float    feels_like_night[MAX_DAYS] = { 0 };
 
-  // daily
-  //float    pressure[MAX_DAYS] = { 0 };
-  //uint8_t  humidity[MAX_DAYS] = { 0 };
-  //float    dew_point[MAX_DAYS] = { 0 };
-  //float    wind_speed[MAX_DAYS] = { 0 };
-  //float    wind_gust[MAX_DAYS] = { 0 };
-  //uint16_t wind_deg[MAX_DAYS] = { 0 };
-  //uint8_t  clouds[MAX_DAYS] = { 0 };
-  //uint8_t  uvi[MAX_DAYS] = { 0 };
-  //uint32_t visibility[MAX_DAYS] = { 0 };
-
-  //float    rain[MAX_DAYS] = { 0 };
-  //float    snow[MAX_DAYS] = { 0 };
+/***************************************************************************************
+** Description:   Record passed to the per slot callback, see OW_Weather::onSlot()
+***************************************************************************************/
+// One "list", "hourly" or "daily" array element. Values not sent by the server for that
+// section are zero, e.g. temp_min is only sent by "list" and "daily". The weather text
+// can be found from the id with the OW_Weather condition functions.
+typedef struct OW_slot {
+  uint8_t  section = 0;    // OW_KEY_LIST, OW_KEY_HOURLY or OW_KEY_DAILY
+  uint16_t index = 0;      // Element number in the section, 0 = first
 
-  // hourly.weather
-  uint16_t id[MAX_DAYS] = { 0 };
-  //String   main[MAX_DAYS];
-  //String   description[MAX_DAYS];
-  //String   icon[MAX_DAYS];
+  uint32_t dt = 0;
+  float    temp = 0;       // daily: temp.day
+  float    temp_min = 0;   // list and daily only
+  float    temp_max = 0;   // list and daily only
+  float    feels_like = 0; // daily: feels_like.day
+  float    pressure = 0;
+  uint8_t  humidity = 0;
+  uint8_t  clouds = 0;     // list: clouds.all
+  float    wind_speed = 0;
+  uint16_t wind_deg = 0;
+  float    wind_gust = 0;
+  float    pop = 0;
+  float    rain = 0;       // list: rain.3h, hourly: rain.1h
+  float    snow = 0;       // list: snow.3h, hourly: snow.1h
+  uint32_t visibility = 0;
+  uint16_t id = 0;
+  uint8_t  night = 0;      // Day/night bit, see OW_isNight()
+} OW_slot;
 
-} OW_daily;
-*/
\ No newline at end of file
+/***************************************************************************************
+** Description:   Field descriptors, used to store, print etc the struct members
+***************************************************************************************/
+// Each struct member that is populated from the JSON message has a descriptor giving
+// the JSON path to the value as key IDs (see Key_Set.h), the value type and where the
+// value is stored. The parser and printWeather() walk the descriptor table, so adding
+// a data point to a struct only needs one OW_FIELD() entry in the table.
+
+// A sketch can define its own struct holding only the values it needs plus a table for
+// it, and pass both to getForecast() with OW_dataSet(). Members not in the struct take
+// no RAM and are skipped by the parser, no library edits are needed, for example:
+//
+//   struct My_forecast {
+//     uint32_t dt[MAX_3HRS];
+//     float    temp[MAX_3HRS];
+//     uint16_t id[MAX_3HRS];
+//     String   description;    // Single value in an array section = first slot only
+//     String   city_name;
+//   };
+//
+//   static constexpr OW_Field myFields[] PROGMEM = {
+//     OW_FIELD(My_forecast, dt,          LIST, LIST,    DT),
+//     OW_FIELD(My_forecast, temp,        LIST, MAIN,    TEMP),
+//     OW_FIELD(My_forecast, id,          LIST, WEATHER, ID),
+//     OW_FIELD(My_forecast, description, LIST, WEATHER, DESCRIPTION),
+//     OW_FIELD(My_forecast, city_name,   CITY, CITY,    NAME),
+//   };
+//
+//   ow.getForecast(OW_dataSet(forecast, myFields), api_key, latitude, ...);
+//
+// Arrays with fewer elements than the server sends keep only the first slots.
+
+// The JSON path is in three parts:
+//   parent = the top level object or array, e.g. "list" (OW_KEY_NONE for root values)
+//   set    = the object holding the value, e.g. "main" in list[n].main.temp
+//            (same as the parent for values directly in the parent or array element)
+//   key    = the name of the name:value pair, e.g. "temp"
+
+// Value storage types
+enum OW_Type : uint8_t {
+  OW_U8 = 0,
+  OW_U16,
+  OW_U32,
+  OW_I32,
+  OW_F32,
+  OW_STR,
+  OW_BIT,       // Day/night bit from the "icon" value, packed 8 slots per byte
+  OW_I16_X100,  // int16_t holding value x 100
+  OW_U8_X100,   // uint8_t holding value x 100
+  OW_U16_DIV10, // uint16_t holding value / 10
+  OW_TEXT       // const char * to text held in an OW_Arena, see setArena()
+};
+
+template <typename T> struct OW_TypeOf;
+template <> struct OW_TypeOf<uint8_t>  { static constexpr uint8_t id = OW_U8;  };
+template <> struct OW_TypeOf<uint16_t> { static constexpr uint8_t id = OW_U16; };
+template <> struct OW_TypeOf<uint32_t> { static constexpr uint8_t id = OW_U32; };
+template <> struct OW_TypeOf<int32_t>  { static constexpr uint8_t id = OW_I32; };
+template <> struct OW_TypeOf<float>    { static constexpr uint8_t id = OW_F32; };
+template <> struct OW_TypeOf<String>   { static constexpr uint8_t id = OW_STR; };
+template <> struct OW_TypeOf<const char *> { static constexpr uint8_t id = OW_TEXT; };
+
+typedef struct OW_Field {
+  uint8_t  parent;  // OW_Key of the top level object or array
+  uint8_t  set;     // OW_Key of the object holding the value
+  uint8_t  key;     // OW_Key of the value
+  uint8_t  type;    // OW_Type of the struct member
+  uint16_t offset;  // Byte offset of the member in the struct
+  uint8_t  size;    // Byte size of one value, this is the array stride
+  uint8_t  count;   // Number of array elements, 1 for a single value
+} OW_Field;
+
+// A struct instance and the descriptor table for it
+typedef struct OW_DataSet {
+  void           *data;
+  const OW_Field *fields;
+  uint8_t         fieldCount;
+} OW_DataSet;
+
+// Element type of struct member M (the member type if not an array)
+#define OW_ELEMENT(S, M) std::remove_extent<decltype(S::M)>::type
+
+// Descriptor for struct S member M, found at JSON path PARENT/SET/KEY (OW_Key names
+// without the OW_KEY_ prefix)
+#define OW_FIELD(S, M, PARENT, SET, KEY) \
+  { OW_KEY_##PARENT, OW_KEY_##SET, OW_KEY_##KEY, OW_TypeOf<OW_ELEMENT(S, M)>::id, \
+    (uint16_t)offsetof(S, M), (uint8_t)sizeof(OW_ELEMENT(S, M)), \
+    (uint8_t)(sizeof(S::M) / sizeof(OW_ELEMENT(S, M))) }
+
+// As OW_FIELD() but storing the value as OW_Type TYPE, used for the scaled integer types
+#define OW_FIELD_TYPE(S, M, TYPE, PARENT, SET, KEY) \
+  { OW_KEY_##PARENT, OW_KEY_##SET, OW_KEY_##KEY, TYPE, \
+    (uint16_t)offsetof(S, M), (uint8_t)sizeof(OW_ELEMENT(S, M)), \
+    (uint8_t)(sizeof(S::M) / sizeof(OW_ELEMENT(S, M))) }
+
+// Descriptor for a day/night bit array M holding COUNT slots, set from the weather icon
+// name, e.g. "10n" is night
+#define OW_FIELD_NIGHT(S, M, COUNT, PARENT, SET) \
+  { OW_KEY_##PARENT, OW_KEY_##SET, OW_KEY_ICON, OW_BIT, \
+    (uint16_t)offsetof(S, M), 0, (uint8_t)(COUNT) }
+
+#define OW_FIELD_COUNT(T) ((uint8_t)(sizeof(T) / sizeof(OW_Field)))
+
+// Pair a struct with its descriptor table for getForecast() and printWeather(), an
+// empty OW_dataSet() excludes that section from the request
+template <size_t N>
+inline OW_DataSet OW_dataSet(void *data, const OW_Field (&fields)[N]) {
+  return { data, fields, (uint8_t)N };
+}
+
+inline OW_DataSet OW_dataSet() {
+  return { nullptr, nullptr, 0 };
+}
+
+/***************************************************************************************
+** Description:   Descriptor tables for the structs above
+***************************************************************************************/
+static constexpr OW_Field OW_currentFields[] PROGMEM = {
+  OW_FIELD(OW_current, dt,          CURRENT, CURRENT, DT),
+  OW_FIELD(OW_current, sunrise,     CURRENT, CURRENT, SUNRISE),
+  OW_FIELD(OW_current, sunset,      CURRENT, CURRENT, SUNSET),
+  OW_FIELD(OW_current, temp,        CURRENT, CURRENT, TEMP),
+  OW_FIELD(OW_current, feels_like,  CURRENT, CURRENT, FEELS_LIKE),
+  OW_FIELD(OW_current, pressure,    CURRENT, CURRENT, PRESSURE),
+  OW_FIELD(OW_current, humidity,    CURRENT, CURRENT, HUMIDITY),
+  OW_FIELD(OW_current, dew_point,   CURRENT, CURRENT, DEW_POINT),
+  OW_FIELD(OW_current, clouds,      CURRENT, CURRENT, CLOUDS),
+  OW_FIELD(OW_current, uvi,         CURRENT, CURRENT, UVI),
+  OW_FIELD(OW_current, visibility,  CURRENT, CURRENT, VISIBILITY),
+  OW_FIELD(OW_current, wind_speed,  CURRENT, CURRENT, WIND_SPEED),
+  OW_FIELD(OW_current, wind_gust,   CURRENT, CURRENT, WIND_GUST),
+  OW_FIELD(OW_current, wind_deg,    CURRENT, CURRENT, WIND_DEG),
+  OW_FIELD(OW_current, rain,        CURRENT, CURRENT, RAIN),
+  OW_FIELD(OW_current, snow,        CURRENT, CURRENT, SNOW),
+
+  OW_FIELD(OW_current, id,          CURRENT, WEATHER, ID),
+#ifdef OW_CONDITION_TABLE
+  OW_FIELD_NIGHT(OW_current, night, 1, CURRENT, WEATHER),
+#else
+  OW_FIELD(OW_current, main,        CURRENT, WEATHER, MAIN),
+  OW_FIELD(OW_current, description, CURRENT, WEATHER, DESCRIPTION),
+  OW_FIELD(OW_current, icon,        CURRENT, WEATHER, ICON),
+#endif
+};
+
+static constexpr OW_Field OW_hourlyFields[] PROGMEM = {
+  OW_FIELD(OW_hourly, dt,           HOURLY, HOURLY, DT),
+  OW_FIELD(OW_hourly, temp,         HOURLY, HOURLY, TEMP),
+  OW_FIELD(OW_hourly, feels_like,   HOURLY, HOURLY, FEELS_LIKE),
+  OW_FIELD(OW_hourly, pressure,     HOURLY, HOURLY, PRESSURE),
+  OW_FIELD(OW_hourly, humidity,     HOURLY, HOURLY, HUMIDITY),
+  OW_FIELD(OW_hourly, dew_point,    HOURLY, HOURLY, DEW_POINT),
+  OW_FIELD(OW_hourly, clouds,       HOURLY, HOURLY, CLOUDS),
+  OW_FIELD(OW_hourly, wind_speed,   HOURLY, HOURLY, WIND_SPEED),
+  OW_FIELD(OW_hourly, wind_gust,    HOURLY, HOURLY, WIND_GUST),
+  OW_FIELD(OW_hourly, wind_deg,     HOURLY, HOURLY, WIND_DEG),
+  OW_FIELD(OW_hourly, rain,         HOURLY, HOURLY, RAIN),
+  OW_FIELD(OW_hourly, snow,         HOURLY, HOURLY, SNOW),
+
+  OW_FIELD(OW_hourly, id,           HOURLY, WEATHER, ID),
+#ifdef OW_CONDITION_TABLE
+  OW_FIELD_NIGHT(OW_hourly, night, MAX_HOURS, HOURLY, WEATHER),
+#else
+  OW_FIELD(OW_hourly, main,         HOURLY, WEATHER, MAIN),
+  OW_FIELD(OW_hourly, description,  HOURLY, WEATHER, DESCRIPTION),
+  OW_FIELD(OW_hourly, icon,         HOURLY, WEATHER, ICON),
+#endif
+  OW_FIELD(OW_hourly, pop,          HOURLY, HOURLY, POP),
+  OW_FIELD(OW_hourly, rain1h,       HOURLY, RAIN, 1H),
+};
+
+static constexpr OW_Field OW_dailyFields[] PROGMEM = {
+  OW_FIELD(OW_daily, dt,               DAILY, DAILY, DT),
+  OW_FIELD(OW_daily, sunrise,          DAILY, DAILY, SUNRISE),
+  OW_FIELD(OW_daily, sunset,           DAILY, DAILY, SUNSET),
+  OW_FIELD(OW_daily, moonrise,         DAILY, DAILY, MOONRISE),
+  OW_FIELD(OW_daily, moonset,          DAILY, DAILY, MOONSET),
+
+  OW_FIELD(OW_daily, temp_morn,        DAILY, TEMP, MORN),
+  OW_FIELD(OW_daily, temp_day,         DAILY, TEMP, DAY),
+  OW_FIELD(OW_daily, temp_eve,         DAILY, TEMP, EVE),
+  OW_FIELD(OW_daily, temp_night,       DAILY, TEMP, NIGHT),
+  OW_FIELD(OW_daily, temp_min,         DAILY, TEMP, MIN),
+  OW_FIELD(OW_daily, temp_max,         DAILY, TEMP, MAX),
+
+  OW_FIELD(OW_daily, feels_like_morn,  DAILY, FEELS_LIKE, MORN),
+  OW_FIELD(OW_daily, feels_like_day,   DAILY, FEELS_LIKE, DAY),
+  OW_FIELD(OW_daily, feels_like_eve,   DAILY, FEELS_LIKE, EVE),
+  OW_FIELD(OW_daily, feels_like_night, DAILY, FEELS_LIKE, NIGHT),
+
+  OW_FIELD(OW_daily, pressure,         DAILY, DAILY, PRESSURE),
+  OW_FIELD(OW_daily, humidity,         DAILY, DAILY, HUMIDITY),
+  OW_FIELD(OW_daily, dew_point,        DAILY, DAILY, DEW_POINT),
+  OW_FIELD(OW_daily, wind_speed,       DAILY, DAILY, WIND_SPEED),
+  OW_FIELD(OW_daily, wind_gust,        DAILY, DAILY, WIND_GUST),
+  OW_FIELD(OW_daily, wind_deg,         DAILY, DAILY, WIND_DEG),
+  OW_FIELD(OW_daily, clouds,           DAILY, DAILY, CLOUDS),
+  OW_FIELD(OW_daily, uvi,              DAILY, DAILY, UVI),
+  OW_FIELD(OW_daily, visibility,       DAILY, DAILY, VISIBILITY),
+
+  OW_FIELD(OW_daily, rain,             DAILY, DAILY, RAIN),
+  OW_FIELD(OW_daily, snow,             DAILY, DAILY, SNOW),
+
+  OW_FIELD(OW_daily, id,               DAILY, WEATHER, ID),
+#ifdef OW_CONDITION_TABLE
+  OW_FIELD_NIGHT(OW_daily, night, MAX_DAYS, DAILY, WEATHER),
+#else
+  OW_FIELD(OW_daily, main,             DAILY, WEATHER, MAIN),
+  OW_FIELD(OW_daily, description,      DAILY, WEATHER, DESCRIPTION),
+  OW_FIELD(OW_daily, icon,             DAILY, WEATHER, ICON),
+#endif
+  OW_FIELD(OW_daily, pop,              DAILY, DAILY, POP),
+};
+
+static constexpr OW_Field OW_forecastFields[] PROGMEM = {
+  OW_FIELD(OW_forecast, dt,          LIST, LIST, DT),
+
+  OW_FIELD(OW_forecast, temp,        LIST, MAIN, TEMP),
+  OW_FIELD(OW_forecast, feels_like,  LIST, MAIN, FEELS_LIKE),
+  OW_FIELD(OW_forecast, temp_min,    LIST, MAIN, TEMP_MIN),
+  OW_FIELD(OW_forecast, temp_max,    LIST, MAIN, TEMP_MAX),
+  OW_FIELD(OW_forecast, pressure,    LIST, MAIN, PRESSURE),
+  OW_FIELD(OW_forecast, sea_level,   LIST, MAIN, SEA_LEVEL),
+  OW_FIELD(OW_forecast, grnd_level,  LIST, MAIN, GRND_LEVEL),
+  OW_FIELD(OW_forecast, humidity,    LIST, MAIN, HUMIDITY),
+
+  OW_FIELD(OW_forecast, id,          LIST, WEATHER, ID),
+#ifdef OW_CONDITION_TABLE
+  OW_FIELD_NIGHT(OW_forecast, night, MAX_3HRS, LIST, WEATHER),
+#else
+  OW_FIELD(OW_forecast, main,        LIST, WEATHER, MAIN),
+  OW_FIELD(OW_forecast, description, LIST, WEATHER, DESCRIPTION),
+  OW_FIELD(OW_forecast, icon,        LIST, WEATHER, ICON),
+#endif
+
+  OW_FIELD(OW_forecast, clouds_all,  LIST, CLOUDS, ALL),
+
+  OW_FIELD(OW_forecast, wind_speed,  LIST, WIND, SPEED),
+  OW_FIELD(OW_forecast, wind_deg,    LIST, WIND, DEG),
+  OW_FIELD(OW_forecast, wind_gust,   LIST, WIND, GUST),
+
+  OW_FIELD(OW_forecast, visibility,  LIST, LIST, VISIBILITY),
+  OW_FIELD(OW_forecast, pop,         LIST, LIST, POP),
+  OW_FIELD(OW_forecast, dt_txt,      LIST, LIST, DT_TXT),
+
+  OW_FIELD(OW_forecast, city_name,   CITY, CITY, NAME),
+  OW_FIELD(OW_forecast, timezone,    CITY, CITY, TIMEZONE),
+  OW_FIELD(OW_forecast, sunrise,     CITY, CITY, SUNRISE),
+  OW_FIELD(OW_forecast, sunset,      CITY, CITY, SUNSET),
+};
+
+static constexpr OW_Field OW_forecastCompactFields[] PROGMEM = {
+  OW_FIELD(OW_forecast_compact, dt,                           LIST, LIST, DT),
+
+  OW_FIELD_TYPE(OW_forecast_compact, temp_x100,       OW_I16_X100, LIST, MAIN, TEMP),
+  OW_FIELD_TYPE(OW_forecast_compact, feels_like_x100, OW_I16_X100, LIST, MAIN, FEELS_LIKE),
+  OW_FIELD_TYPE(OW_forecast_compact, temp_min_x100,   OW_I16_X100, LIST, MAIN, TEMP_MIN),
+  OW_FIELD_TYPE(OW_forecast_compact, temp_max_x100,   OW_I16_X100, LIST, MAIN, TEMP_MAX),
+  OW_FIELD(OW_forecast_compact, pressure,                     LIST, MAIN, PRESSURE),
+  OW_FIELD(OW_forecast_compact, sea_level,                    LIST, MAIN, SEA_LEVEL),
+  OW_FIELD(OW_forecast_compact, grnd_level,                   LIST, MAIN, GRND_LEVEL),
+  OW_FIELD(OW_forecast_compact, humidity,                     LIST, MAIN, HUMIDITY),
+
+  OW_FIELD(OW_forecast_compact, id,                           LIST, WEATHER, ID),
+#ifdef OW_CONDITION_TABLE
+  OW_FIELD_NIGHT(OW_forecast_compact, night, MAX_3HRS, LIST, WEATHER),
+#else
+  OW_FIELD(OW_forecast_compact, main,                         LIST, WEATHER, MAIN),
+  OW_FIELD(OW_forecast_compact, description,                  LIST, WEATHER, DESCRIPTION),
+  OW_FIELD(OW_forecast_compact, icon,                         LIST, WEATHER, ICON),
+#endif
+
+  OW_FIELD(OW_forecast_compact, clouds_all,                   LIST, CLOUDS, ALL),
+
+  OW_FIELD_TYPE(OW_forecast_compact, wind_speed_x100, OW_I16_X100, LIST, WIND, SPEED),
+  OW_FIELD(OW_forecast_compact, wind_deg,                     LIST, WIND, DEG),
+  OW_FIELD_TYPE(OW_forecast_compact, wind_gust_x100,  OW_I16_X100, LIST, WIND, GUST),
+
+  OW_FIELD_TYPE(OW_forecast_compact, visibility_dam,  OW_U16_DIV10, LIST, LIST, VISIBILITY),
+  OW_FIELD_TYPE(OW_forecast_compact, pop_x100,        OW_U8_X100,  LIST, LIST, POP),
+
+  OW_FIELD(OW_forecast_compact, city_name,                    CITY, CITY, NAME),
+  OW_FIELD(OW_forecast_compact, timezone,                     CITY, CITY, TIMEZONE),
+  OW_FIELD(OW_forecast_compact, sunrise,                      CITY, CITY, SUNRISE),
+  OW_FIELD(OW_forecast_compact, sunset,                       CITY, CITY, SUNSET),
+};
+
+// Values for the OW_slot record passed to the per slot callback
+static constexpr OW_Field OW_slotFields[] PROGMEM = {
+  OW_FIELD(OW_slot, dt,         LIST, LIST,    DT),
+  OW_FIELD(OW_slot, temp,       LIST, MAIN,    TEMP),
+  OW_FIELD(OW_slot, temp_min,   LIST, MAIN,    TEMP_MIN),
+  OW_FIELD(OW_slot, temp_max,   LIST, MAIN,    TEMP_MAX),
+  OW_FIELD(OW_slot, feels_like, LIST, MAIN,    FEELS_LIKE),
+  OW_FIELD(OW_slot, pressure,   LIST, MAIN,    PRESSURE),
+  OW_FIELD(OW_slot, humidity,   LIST, MAIN,    HUMIDITY),
+  OW_FIELD(OW_slot, clouds,     LIST, CLOUDS,  ALL),
+  OW_FIELD(OW_slot, wind_speed, LIST, WIND,    SPEED),
+  OW_FIELD(OW_slot, wind_deg,   LIST, WIND,    DEG),
+  OW_FIELD(OW_slot, wind_gust,  LIST, WIND,    GUST),
+  OW_FIELD(OW_slot, pop,        LIST, LIST,    POP),
+  OW_FIELD(OW_slot, rain,       LIST, RAIN,    3H),
+  OW_FIELD(OW_slot, snow,       LIST, SNOW,    3H),
+  OW_FIELD(OW_slot, visibility, LIST, LIST,    VISIBILITY),
+  OW_FIELD(OW_slot, id,         LIST, WEATHER, ID),
+  OW_FIELD_NIGHT(OW_slot, night, 1, LIST, WEATHER),
+
+  OW_FIELD(OW_slot, dt,         HOURLY, HOURLY,  DT),
+  OW_FIELD(OW_slot, temp,       HOURLY, HOURLY,  TEMP),
+  OW_FIELD(OW_slot, feels_like, HOURLY, HOURLY,  FEELS_LIKE),
+  OW_FIELD(OW_slot, pressure,   HOURLY, HOURLY,  PRESSURE),
+  OW_FIELD(OW_slot, humidity,   HOURLY, HOURLY,  HUMIDITY),
+  OW_FIELD(OW_slot, clouds,     HOURLY, HOURLY,  CLOUDS),
+  OW_FIELD(OW_slot, wind_speed, HOURLY, HOURLY,  WIND_SPEED),
+  OW_FIELD(OW_slot, wind_deg,   HOURLY, HOURLY,  WIND_DEG),
+  OW_FIELD(OW_slot, wind_gust,  HOURLY, HOURLY,  WIND_GUST),
+  OW_FIELD(OW_slot, pop,        HOURLY, HOURLY,  POP),
+  OW_FIELD(OW_slot, rain,       HOURLY, RAIN,    1H),
+  OW_FIELD(OW_slot, snow,       HOURLY, SNOW,    1H),
+  OW_FIELD(OW_slot, visibility, HOURLY, HOURLY,  VISIBILITY),
+  OW_FIELD(OW_slot, id,         HOURLY, WEATHER, ID),
+  OW_FIELD_NIGHT(OW_slot, night, 1, HOURLY, WEATHER),
+
+  OW_FIELD(OW_slot, dt,         DAILY, DAILY,      DT),
+  OW_FIELD(OW_slot, temp,       DAILY, TEMP,       DAY),
+  OW_FIELD(OW_slot, temp_min,   DAILY, TEMP,       MIN),
+  OW_FIELD(OW_slot, temp_max,   DAILY, TEMP,       MAX),
+  OW_FIELD(OW_slot, feels_like, DAILY, FEELS_LIKE, DAY),
+  OW_FIELD(OW_slot, pressure,   DAILY, DAILY,      PRESSURE),
+  OW_FIELD(OW_slot, humidity,   DAILY, DAILY,      HUMIDITY),
+  OW_FIELD(OW_slot, clouds,     DAILY, DAILY,      CLOUDS),
+  OW_FIELD(OW_slot, wind_speed, DAILY, DAILY,      WIND_SPEED),
+  OW_FIELD(OW_slot, wind_deg,   DAILY, DAILY,      WIND_DEG),
+  OW_FIELD(OW_slot, wind_gust,  DAILY, DAILY,      WIND_GUST),
+  OW_FIELD(OW_slot, pop,        DAILY, DAILY,      POP),
+  OW_FIELD(OW_slot, rain,       DAILY, DAILY,      RAIN),
+  OW_FIELD(OW_slot, snow,       DAILY, DAILY,      SNOW),
+  OW_FIELD(OW_slot, visibility, DAILY, DAILY,      VISIBILITY),
+  OW_FIELD(OW_slot, id,         DAILY, WEATHER,    ID),
+  OW_FIELD_NIGHT(OW_slot, night, 1, DAILY, WEATHER),
+};
+
+// Minimal set of data points for TFT_eSPI examples, selected by partialDataSet(true)
+static constexpr OW_Field OW_currentPartialFields[] PROGMEM = {
+  OW_FIELD(OW_current, dt,          CURRENT, CURRENT, DT),
+  OW_FIELD(OW_current, sunrise,     CURRENT, CURRENT, SUNRISE),
+  OW_FIELD(OW_current, sunset,      CURRENT, CURRENT, SUNSET),
+  OW_FIELD(OW_current, temp,        CURRENT, CURRENT, TEMP),
+  OW_FIELD(OW_current, pressure,    CURRENT, CURRENT, PRESSURE),
+  OW_FIELD(OW_current, humidity,    CURRENT, CURRENT, HUMIDITY),
+  OW_FIELD(OW_current, clouds,      CURRENT, CURRENT, CLOUDS),
+  OW_FIELD(OW_current, wind_speed,  CURRENT, CURRENT, WIND_SPEED),
+  OW_FIELD(OW_current, wind_deg,    CURRENT, CURRENT, WIND_DEG),
+
+  OW_FIELD(OW_current, id,          CURRENT, WEATHER, ID),
+#ifndef OW_CONDITION_TABLE
+  OW_FIELD(OW_current, main,        CURRENT, WEATHER, MAIN),
+  OW_FIELD(OW_current, description, CURRENT, WEATHER, DESCRIPTION),
+#endif
+};
+
+static constexpr OW_Field OW_dailyPartialFields[] PROGMEM = {
+  OW_FIELD(OW_daily, dt,       DAILY, DAILY, DT),
+  OW_FIELD(OW_daily, temp_min, DAILY, TEMP, MIN),
+  OW_FIELD(OW_daily, temp_max, DAILY, TEMP, MAX),
+  OW_FIELD(OW_daily, id,       DAILY, WEATHER, ID),
+};
@@ -0,0 +1,82 @@
+// The JSON key names recognised by the library are mapped to a compact ID once, when
+// the parser reports the key, so values can then be dispatched with a switch statement
+// rather than a long chain of String comparisons.
+
+// The IDs are the index of the key name in the OW_keyNames[] table in OpenWeather.cpp.
+// That table is searched with a binary chop so the names MUST be kept in ASCII (strcmp)
+// order and this enum MUST list the keys in the same order as the table.
+
+#ifndef Key_Set_h
+#define Key_Set_h
+
+#define OW_KEY_LEN 16 // Maximum key name length + 1 for the null terminator
+
+/***************************************************************************************
+** Description:   Key ID enumeration, order matches OW_keyNames[]
+***************************************************************************************/
+enum OW_Key : uint8_t {
+  OW_KEY_1H = 0,
+  OW_KEY_3H,
+  OW_KEY_ALERTS,
+  OW_KEY_ALL,
+  OW_KEY_CITY,
+  OW_KEY_CLOUDS,
+  OW_KEY_COORD,
+  OW_KEY_CURRENT,
+  OW_KEY_DAILY,
+  OW_KEY_DAY,
+  OW_KEY_DEG,
+  OW_KEY_DESCRIPTION,
+  OW_KEY_DEW_POINT,
+  OW_KEY_DT,
+  OW_KEY_DT_TXT,
+  OW_KEY_EVE,
+  OW_KEY_FEELS_LIKE,
+  OW_KEY_GRND_LEVEL,
+  OW_KEY_GUST,
+  OW_KEY_HOURLY,
+  OW_KEY_HUMIDITY,
+  OW_KEY_ICON,
+  OW_KEY_ID,
+  OW_KEY_LAT,
+  OW_KEY_LIST,
+  OW_KEY_LON,
+  OW_KEY_MAIN,
+  OW_KEY_MAX,
+  OW_KEY_MIN,
+  OW_KEY_MINUTELY,
+  OW_KEY_MOONRISE,
+  OW_KEY_MOONSET,
+  OW_KEY_MORN,
+  OW_KEY_NAME,
+  OW_KEY_NIGHT,
+  OW_KEY_POP,
+  OW_KEY_PRESSURE,
+  OW_KEY_RAIN,
+  OW_KEY_SEA_LEVEL,
+  OW_KEY_SNOW,
+  OW_KEY_SPEED,
+  OW_KEY_SUNRISE,
+  OW_KEY_SUNSET,
+  OW_KEY_TEMP,
+  OW_KEY_TEMP_MAX,
+  OW_KEY_TEMP_MIN,
+  OW_KEY_TIMEZONE,
+  OW_KEY_TIMEZONE_OFFSET,
+  OW_KEY_UVI,
+  OW_KEY_VISIBILITY,
+  OW_KEY_WEATHER,
+  OW_KEY_WIND,
+  OW_KEY_WIND_DEG,
+  OW_KEY_WIND_GUST,
+  OW_KEY_WIND_SPEED,
+
+  OW_KEY_COUNT,                  // Number of keys in the table
+  OW_KEY_UNKNOWN = OW_KEY_COUNT, // Key is not used by the library
+  OW_KEY_NONE                    // No key, e.g. the root object of the document
+};
+
+// The wanted key masks in the OW_Weather class have one bit per key
+static_assert(OW_KEY_COUNT <= 64, "Too many keys for the 64 bit key masks");
+
+#endif
@@ -26,6 +26,22 @@
 
 #include "OpenWeather.h"
 
+#if defined(OW_TLS_SESSION) && defined(OW_SAVE_TLS_SESSION)
+  #include <FS.h>
+#endif
+
+#ifdef OW_POSIX_CLIENT
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <netdb.h>
+  #include <netinet/in.h>
+  #include <netinet/tcp.h>
+  #include <poll.h>
+  #include <sys/ioctl.h>
+  #include <sys/socket.h>
+  #include <unistd.h>
+#endif
+
 
 /***************************************************************************************
 ** Function name:           getForecast (using onecall API)
@@ -37,898 +53,3609 @@
 //          for the connection, when set true BearSSL will be used.
 // ESP32:   Secure parameter has no affect.
 bool OW_Weather::getForecast(OW_current *current, OW_hourly *hourly, OW_daily *daily,
-                             String api_key, String latitude, String longitude,
+                             String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
                              String units, String language, bool secure) {
 
-  data_set = "";
-  hourly_index = 0;
-  daily_index = 0;
-  Secure = secure;
-  oneCall = true;
+  if (partialSet) {
+    return getForecast(OW_dataSet(current, OW_currentPartialFields), OW_dataSet(),
+                       OW_dataSet(daily, OW_dailyPartialFields),
+                       api_key, latitude, longitude, units, language, secure);
+  }
 
-  // Local copies of structure pointers, the structures are filled during parsing
-  this->current  = current;
-  this->hourly   = hourly;
-  this->daily    = daily;
+  return getForecast(OW_dataSet(current, OW_currentFields), OW_dataSet(hourly, OW_hourlyFields),
+                     OW_dataSet(daily, OW_dailyFields),
+                     api_key, latitude, longitude, units, language, secure);
+}
 
-  // Exclude some info by passing fn a NULL pointer to reduce memory needed
-  String exclude = ",alerts";
-  if (!current)  exclude += ",current";
-  if (!hourly)   exclude += ",hourly";
-  if (!daily)    exclude += ",daily";
+/***************************************************************************************
+** Function name:           getForecast (using onecall API and sketch defined structs)
+** Description:             Setup the weather forecast request
+***************************************************************************************/
+// Each OW_DataSet is a sketch struct plus the OW_FIELD() descriptor table listing the
+// members to populate. Use OW_dataSet() (no arguments) to exclude a section.
+bool OW_Weather::getForecast(OW_DataSet current, OW_DataSet hourly, OW_DataSet daily,
+                             String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                             String units, String language, bool secure) {
 
-  // One call API now subscription
-  String url = "https://api.openweathermap.org/data/2.5/onecall?lat=" + latitude + "&lon=" + longitude + "&exclude=minutely" + exclude + "&units=" + units + "&lang=" + language + "&appid=" + api_key;
+  // The structs of a non-blocking fetch in progress must not be replaced
+  if (fetchBusy()) return false;
 
   // Send GET request and feed the parser
-  bool result = parseRequest(url);
+  bool result = oneCallUrl(current, hourly, daily, api_key.c_str(), latitude.c_str(), longitude.c_str(),
+                           units.c_str(), language.c_str(), secure) && request();
 
-  // Null out pointers to prevent crashes
-  this->current  = nullptr;
-  this->hourly   = nullptr;
-  this->daily    = nullptr;
+  // Forget pointers to prevent crashes
+  dataSetCount = 0;
 
   return result;
 }
 
+/***************************************************************************************
+** Function name:           oneCallUrl
+** Description:             Setup the structs to populate, build the onecall API url
+***************************************************************************************/
+bool OW_Weather::oneCallUrl(OW_DataSet current, OW_DataSet hourly, OW_DataSet daily,
+                            const char *api_key, const char *latitude, const char *longitude,
+                            const char *units, const char *language, bool secure) {
+
+  Secure = secure;
+  oneCall = true;
+
+  // Local copies of structure pointers and their descriptor tables, the structures
+  // are filled during parsing
+  dataSetCount = 0;
+  addDataSet(current);
+  addDataSet(hourly);
+  addDataSet(daily);
+
+  if (!*latitude || !*longitude) {
+    OW_STATUS_PRINTF("No location given\n");
+    return false;
+  }
+
+  // One call API now subscription
+  OW_RequestBuilder url(requestUrl, sizeof(requestUrl));
+  url.add("/data/2.5/onecall?lat=").addEncoded(latitude);
+  url.add("&lon=").addEncoded(longitude);
+
+  // Exclude some info by passing fn a NULL pointer to reduce memory needed
+  url.add("&exclude=minutely,alerts");
+  if (!current.data)  url.add(",current");
+  if (!hourly.data && !slotCallback) url.add(",hourly");
+  if (!daily.data  && !slotCallback) url.add(",daily");
+
+  addQuery(url, units, language, api_key);
+  return url.fits();
+}
+
 /***************************************************************************************
 ** Function name:           getForecast (using forecast API)
 ** Description:             Setup the weather forecast request
 ***************************************************************************************/
-bool OW_Weather::getForecast(OW_forecast *forecast, String api_key, 
-                             String latitude, String longitude,
+bool OW_Weather::getForecast(OW_forecast *forecast, String api_key,
+                             const OW_Coordinate &latitude, const OW_Coordinate &longitude,
                              String units, String language, bool secure)
 {
-  data_set = "";
-  forecast_index = 0;
-  Secure = secure;
-  oneCall = false;
+  return getForecast(OW_dataSet(forecast, OW_forecastFields),
+                     api_key, latitude, longitude, units, language, secure);
+}
 
-  // Local copies of structure pointers, the structures are filled during parsing
-  this->forecast  = forecast;
+/***************************************************************************************
+** Function name:           getForecast (using forecast API and compact struct)
+** Description:             Setup the weather forecast request
+***************************************************************************************/
+bool OW_Weather::getForecast(OW_forecast_compact *forecast, String api_key,
+                             const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                             String units, String language, bool secure)
+{
+  return getForecast(OW_dataSet(forecast, OW_forecastCompactFields),
+                     api_key, latitude, longitude, units, language, secure);
+}
 
-  // 5 day forecast every 3 hours from request time
-  String url = "https://api.openweathermap.org/data/2.5/forecast?lat=" + latitude + "&lon=" + longitude + "&units=" + units + "&lang=" + language + "&appid=" + api_key;
+/***************************************************************************************
+** Function name:           getForecast (using forecast API and sketch defined struct)
+** Description:             Setup the weather forecast request
+***************************************************************************************/
+bool OW_Weather::getForecast(OW_DataSet forecast, String api_key,
+                             const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                             String units, String language, bool secure)
+{
+  if (fetchBusy()) return false;
 
   // Send GET request and feed the parser
-  bool result = parseRequest(url);
+  bool result = forecastUrl(forecast, api_key.c_str(), latitude.c_str(), longitude.c_str(),
+                            units.c_str(), language.c_str(), secure) && request();
 
-  // Null out pointers to prevent crashes
-  this->forecast  = nullptr;
+  // Forget pointer to prevent crashes
+  dataSetCount = 0;
 
   return result;
 }
+
 /***************************************************************************************
-** Function name:           partialDataSet
-** Description:             Set requested data set to partial (true) or full (false)
+** Function name:           forecastUrl
+** Description:             Setup the struct to populate, build the forecast API url
 ***************************************************************************************/
-void OW_Weather::partialDataSet(bool partialSet) {
-  
-  this->partialSet = partialSet;
-}
+bool OW_Weather::forecastUrl(OW_DataSet forecast, const char *api_key,
+                             const char *latitude, const char *longitude,
+                             const char *units, const char *language, bool secure)
+{
+  Secure = secure;
+  oneCall = false;
 
-#ifdef ESP32 // Decide if ESP32 or ESP8266 parseRequest available
+  // Local copy of structure pointer and descriptor table, the structure is filled
+  // during parsing
+  dataSetCount = 0;
+  addDataSet(forecast);
 
-/***************************************************************************************
-** Function name:           parseRequest (for ESP32)
-** Description:             Fetches the JSON message and feeds to the parser
-***************************************************************************************/
-bool OW_Weather::parseRequest(String url) {
+  if (!*latitude || !*longitude) {
+    OW_STATUS_PRINTF("No location given\n");
+    return false;
+  }
 
-  uint32_t dt = millis();
+  // 5 day forecast every 3 hours from request time
+  OW_RequestBuilder url(requestUrl, sizeof(requestUrl));
+  url.add("/data/2.5/forecast?lat=").addEncoded(latitude);
+  url.add("&lon=").addEncoded(longitude);
 
-  OW_STATUS_PRINTF("\n\nThe connection to server is secure (https). Certificate not checked.\n");
-  WiFiClientSecure client;
-  client.setInsecure(); // Certificate not checked
+  addQuery(url, units, language, api_key);
+  return url.fits();
+}
 
-  const char*  host = "api.openweathermap.org";
-  port = 443;
+/***************************************************************************************
+** Function name:           addQuery, setUrl
+** Description:             Finish the url, or copy a sketch url
+***************************************************************************************/
+void OW_Weather::addQuery(OW_RequestBuilder &url, const char *units, const char *language,
+                          const char *api_key)
+{
+  url.add("&units=").addEncoded(units);
+  url.add("&lang=").addEncoded(language);
+  url.add("&appid=").addEncoded(api_key);
 
-  if (!client.connect(host, port))
-  {
-    OW_STATUS_PRINTF("Connection failed.\n");
-    return false;
+  if (!url.fits()) OW_STATUS_PRINTF("Url too long, see OW_URL_SIZE\n");
+}
+
+// The request line holds the path only (origin-form), the server is sent in the Host
+// header, so the scheme and server are dropped from a full sketch url
+bool OW_Weather::setUrl(const char *url)
+{
+  const char *path = (*url == '/') ? nullptr : strstr(url, "://");
+  if (path) {
+    path = strchr(path + 3, '/');
+    url = path ? path : "/";
   }
 
-  JSON_Decoder parser;
-  parser.setListener(this);
+  OW_RequestBuilder text(requestUrl, sizeof(requestUrl));
+  if (text.add(url).fits()) return true;
 
-  uint32_t timeout = millis();
-  char c = 0;
-  parseOK = false;
+  OW_STATUS_PRINTF("Url too long, see OW_URL_SIZE\n");
+  return false;
+}
 
-#ifdef SHOW_JSON
-  int ccount = 0;
-#endif
-  // Send GET request
-  Serial.println();
-  OW_STATUS_PRINT("Sending GET request to "); OW_STATUS_PRINT(host); OW_STATUS_PRINT(" port "); OW_STATUS_PRINT(port); OW_STATUS_PRINTF("\n");
-  client.print(String("GET ") + url + " HTTP/1.1\r\n" + "Host: " + host + "\r\n" + "Connection: close\r\n\r\n");
+/***************************************************************************************
+** Function name:           getForecasts
+** Description:             Fetch the forecast API for several locations over one connection
+***************************************************************************************/
+// Responses come back in the order the requests were sent, so the structs for the oldest
+// request not yet answered are filled by the next response. results[i].ms holds the time
+// the request was sent until its response is read.
+uint16_t OW_Weather::getForecasts(const OW_Location *locations, OW_Result *results, uint16_t count,
+                                  String api_key, String units, String language, bool secure)
+{
+  if (fetchBusy()) return 0;
 
-  // Pull out any header, X-Forecast-API-Calls: reports current daily API call count
-  while (client.connected())
-  {
-    String line = client.readStringUntil('\n');
-    if (line == "\r") {
-      OW_STATUS_PRINTF("Header end found\n");
-      break;
-    }
+  // The connection is kept open between the requests
+  bool keepOpen = keepAliveOn;
+  keepAliveOn = true;
+  batch = true;
+  Secure = secure;
 
-#ifdef SHOW_HEADER
-    Serial.println(line);
-#endif
+  JSON_Decoder parser;
+  parser.setListener(this);
 
-    if ((millis() - timeout) > 5000UL)
-    {
-      OW_STATUS_PRINTF ("HTTP header timeout\n");
-      client.stop();
-      return false;
-    }
+  for (uint16_t i = 0; i < count; i++) {
+    results[i].ok = false;
+    results[i].status = 0;
+    results[i].ms = 0;
   }
 
-  OW_STATUS_PRINTF("\nParsing JSON\n");
+  uint16_t sent = 0;    // Requests sent on the connection
+  uint16_t done = 0;    // Responses read
+  uint16_t last = count; // Locations that can be requested
+  uint16_t parsed = 0;
+  bool resent = false;  // Request done has been sent again after a lost connection
+
+  while (done < last) {
+
+    // Requests not answered on a closed connection are sent again
+    if (!connection) {
+      sent = done;
+      if (!openServer()) {
+        OW_STATUS_PRINTF("Connection failed.\n");
+        break;
+      }
+    }
 
-  // Parse the JSON data, available() includes yields
-  while ( client.available() > 0 || client.connected())
-  {
-    while(client.available() > 0)
-    {
-      c = client.read();
-      parser.parse(c);
-#ifdef SHOW_JSON
-      if (c == '{' || c == '[' || c == '}' || c == ']') Serial.println();
-      Serial.println(c); if (ccount++ > 100 && c == ',') {ccount = 0; Serial.println();}
-#endif
+    // Keep up to OW_PIPELINE_DEPTH requests waiting for a response
+    while (sent < last && sent - done < OW_PIPELINE_DEPTH) {
+      OW_Coordinate lat(locations[sent].latitude), lon(locations[sent].longitude);
+
+      if (!forecastUrl(results[sent].set, api_key.c_str(), lat.c_str(), lon.c_str(),
+                       units.c_str(), language.c_str(), secure)) {
+        last = sent;
+        break;
+      }
+      if (!sendRequest(connection)) break;
+      results[sent++].ms = millis();
+    }
+    if (done == last) break;
+
+    // The request could not be sent, try once more on a new connection
+    if (done == sent) {
+      stop();
+      if (resent) {
+        resent = false;
+        done++;
+      }
+      else resent = true;
+      continue;
     }
 
-    if ((millis() - timeout) > 8000UL)
-    {
-      OW_STATUS_PRINTF("Client timeout during JSON parse\n");
-      parser.reset();
-      client.stop();
-      return false;
+    // The parser fills the structs for the oldest request
+    OW_Result &result = results[done];
+    dataSetCount = 0;
+    addDataSet(result.set);
+    requestStart = result.ms;
+    resetResponse();
+
+    OW_STATUS_PRINTF("Location "); OW_STATUS_PRINT(done); OW_STATUS_PRINTF("\n");
+    bool ok = receive(connection, parser, result.ms, result.ms);
+
+    // No response, the server may have closed the connection, send the request again once
+    if (!ok && !headerFound && !resent) {
+      resent = true;
+      stop();
+      continue;
     }
-    yield();
+    resent = false;
+
+    result.ok = ok;
+    result.status = response.status;
+    result.ms = millis() - result.ms;
+    if (ok) parsed++;
+    done++;
   }
 
-  OW_STATUS_PRINTF("\nDone in "); OW_STATUS_PRINT(millis()-dt); OW_STATUS_PRINTF(" ms\n");
-  Serial.println();
+  // Forget pointers to prevent crashes
+  dataSetCount = 0;
+  batch = false;
+#ifdef OW_GZIP
+  delete inflater;
+  inflater = nullptr;
+#endif
 
-  parser.reset();
+  keepAliveOn = keepOpen;
+  if (!keepAliveOn) stop();
 
-  client.stop();
-  
-  // A message has been parsed, but the data-point correctness is unknown
-  return parseOK;
+  return parsed;
 }
 
-#else // ESP8266 or Arduino RP2040 Nano Connect version
-
 /***************************************************************************************
-** Function name:           parseRequest (for ESP8266)
-** Description:             Fetches the JSON message and feeds to the parser
+** Function name:           beginForecast (onecall API)
+** Description:             Setup a non-blocking weather forecast request, see poll()
 ***************************************************************************************/
-bool OW_Weather::parseRequest(String url) {
-  if (Secure) return parseRequestSecure(&url);
-  else return parseRequestInsecure(&url);
+bool OW_Weather::beginForecast(OW_current *current, OW_hourly *hourly, OW_daily *daily,
+                               String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                               String units, String language, bool secure) {
+
+  if (partialSet) {
+    return beginForecast(OW_dataSet(current, OW_currentPartialFields), OW_dataSet(),
+                         OW_dataSet(daily, OW_dailyPartialFields),
+                         api_key, latitude, longitude, units, language, secure);
+  }
+
+  return beginForecast(OW_dataSet(current, OW_currentFields), OW_dataSet(hourly, OW_hourlyFields),
+                       OW_dataSet(daily, OW_dailyFields),
+                       api_key, latitude, longitude, units, language, secure);
 }
 
-bool OW_Weather::parseRequestSecure(String* url) {
+bool OW_Weather::beginForecast(OW_DataSet current, OW_DataSet hourly, OW_DataSet daily,
+                               String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                               String units, String language, bool secure) {
 
-  uint32_t dt = millis();
+  if (fetchBusy()) return false;
 
-  const char*  host = "api.openweathermap.org";
+  if (oneCallUrl(current, hourly, daily, api_key.c_str(), latitude.c_str(), longitude.c_str(),
+                 units.c_str(), language.c_str(), secure) && beginFetch()) return true;
 
-  #if (defined(ARDUINO_ARCH_MBED) || defined(ARDUINO_ARCH_RP2040)) && !defined(ARDUINO_RASPBERRY_PI_PICO_W)
-  WiFiSSLClient client;
-  #else
-  // Must use namespace:: to select BearSSL
-  BearSSL::WiFiClientSecure client;
-  client.setInsecure(); // Certificate not checked
-  #endif
-  port = 443;
+  dataSetCount = 0;
+  return false;
+}
 
-  if (!client.connect(host, port))
-  {
-    OW_STATUS_PRINTF("Connection failed.\n");
-    return false;
-  }
-  JSON_Decoder parser;
-  parser.setListener(this);
+/***************************************************************************************
+** Function name:           beginForecast (forecast API)
+** Description:             Setup a non-blocking weather forecast request, see poll()
+***************************************************************************************/
+bool OW_Weather::beginForecast(OW_forecast *forecast, String api_key,
+                               const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                               String units, String language, bool secure)
+{
+  return beginForecast(OW_dataSet(forecast, OW_forecastFields),
+                       api_key, latitude, longitude, units, language, secure);
+}
 
-  uint32_t timeout = millis();
-  char c = 0;
-  parseOK = false;
+bool OW_Weather::beginForecast(OW_forecast_compact *forecast, String api_key,
+                               const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                               String units, String language, bool secure)
+{
+  return beginForecast(OW_dataSet(forecast, OW_forecastCompactFields),
+                       api_key, latitude, longitude, units, language, secure);
+}
 
-  #ifdef SHOW_JSON
-  int ccount = 0;
-  #endif
+bool OW_Weather::beginForecast(OW_DataSet forecast, String api_key,
+                               const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                               String units, String language, bool secure)
+{
+  if (fetchBusy()) return false;
 
-  #ifdef ESP8266
-  OW_STATUS_PRINTF("\nThe connection to server is using BearSSL in insecure mode (certificates not checked).\n");
-  #endif
+  if (forecastUrl(forecast, api_key.c_str(), latitude.c_str(), longitude.c_str(),
+                  units.c_str(), language.c_str(), secure) && beginFetch()) return true;
 
-  // Send GET request
-  Serial.println();
-  OW_STATUS_PRINTF("Sending GET request to api.openweathermap.org...\n");
-  Serial.println();
-  client.print(String("GET ") + *url + " HTTP/1.1\r\n" + "Host: " + host + "\r\n" + "Connection: close\r\n\r\n");
-  Serial.println();
+  dataSetCount = 0;
+  return false;
+}
 
-  // Pull out any header, X-Forecast-API-Calls: reports current daily API call count
-  while (client.available() || client.connected())
-  {
-    String line = client.readStringUntil('\n');
-    if (line == "\r") {
-      OW_STATUS_PRINTF("Header end found\n");
-      break;
-    }
+/***************************************************************************************
+** Function name:           partialDataSet
+** Description:             Set requested data set to partial (true) or full (false)
+***************************************************************************************/
+// Only the values are reduced, the structs still reserve RAM for every member. Use a
+// sketch defined struct and OW_FIELD() table to reduce the RAM needed as well.
+void OW_Weather::partialDataSet(bool partialSet) {
+  
+  this->partialSet = partialSet;
+}
 
-    OW_STATUS_PRINT(line); OW_STATUS_PRINTF("\n");
+/***************************************************************************************
+** Function name:           addDataSet
+** Description:             Add a struct to be populated by the parser
+***************************************************************************************/
+void OW_Weather::addDataSet(const OW_DataSet &set) {
 
-    if ((millis() - timeout) > 5000UL)
-    {
-      OW_STATUS_PRINTF ("HTTP header timeout\n");
-      client.stop();
-      return false;
-    }
-  }
+  if (!set.data || dataSetCount >= OW_MAX_DATA_SETS) return;
 
+  dataSet[dataSetCount++] = set;
 
-  // Parse the JSON data, available() includes yields
-  while (client.available() || client.connected())
-  {
-    while (client.available())
-    {
-      c = client.read();
-      parser.parse(c);
-  #ifdef SHOW_JSON
-      if (c == '{' || c == '[' || c == '}' || c == ']') Serial.println();
-      Serial.print(c); if (ccount++ > 100 && c == ',') {ccount = 0; Serial.println();}
-  #endif
-    }
+  // Text pointers are set to "" so they are safe to print if no value is received
+  for (uint8_t i = 0; i < set.fieldCount; i++) {
+    OW_Field field;
+    memcpy_P(&field, &set.fields[i], sizeof(OW_Field));
+    if (field.type != OW_TEXT) continue;
 
-    if ((millis() - timeout) > 8000UL)
-    {
-      OW_STATUS_PRINTF ("JSON client timeout\n");
-      parser.reset();
-      client.stop();
-      return false;
+    for (uint8_t n = 0; n < field.count; n++) {
+      *(const char **)((uint8_t *)set.data + field.offset + n * field.size) = "";
     }
   }
+}
 
-  Serial.println();
-  OW_STATUS_PRINTF("\nDone in "); OW_STATUS_PRINT(millis()-dt); OW_STATUS_PRINTF(" ms\n");
+/***************************************************************************************
+** Function name:           onSlot
+** Description:             Set the function called as each array section element ends
+***************************************************************************************/
+void OW_Weather::onSlot(OW_SlotCallback callback) {
 
-  parser.reset();
+  slotCallback = callback;
+}
 
-  client.stop();
-  
-  // A message has been parsed without error but the data-point correctness is unknown
-  return parseOK;
+/***************************************************************************************
+** Function name:           setArena
+** Description:             Set the arena used to hold text values
+***************************************************************************************/
+void OW_Weather::setArena(OW_Arena *arena) {
+
+  this->arena = arena;
 }
 
-bool OW_Weather::parseRequestInsecure(String* url) {
+/***************************************************************************************
+** Function name:           printWeather
+** Description:             Print the struct values to the serial port
+***************************************************************************************/
+void OW_Weather::printWeather(OW_current *current) {
+  printWeather(OW_dataSet(current, OW_currentFields));
+}
 
-  uint32_t dt = millis();
+void OW_Weather::printWeather(OW_hourly *hourly) {
+  printWeather(OW_dataSet(hourly, OW_hourlyFields));
+}
 
-  const char*  host = "api.openweathermap.org";
+void OW_Weather::printWeather(OW_daily *daily) {
+  printWeather(OW_dataSet(daily, OW_dailyFields));
+}
 
-  // AXTLS used (insecure)
-  WiFiClient client;
-  port = 80;
- 
-  if (!client.connect(host, port))
-  {
-    OW_STATUS_PRINTF("Connection failed.\n");
-    return false;
-  }
-  JSON_Decoder parser;
-  parser.setListener(this);
+void OW_Weather::printWeather(OW_forecast *forecast) {
+  printWeather(OW_dataSet(forecast, OW_forecastFields));
+}
 
-  uint32_t timeout = millis();
-  char c = 0;
-  parseOK = false;
+void OW_Weather::printWeather(OW_forecast_compact *forecast) {
+  printWeather(OW_dataSet(forecast, OW_forecastCompactFields));
+}
 
-  #ifdef SHOW_JSON
-  int ccount = 0;
-  #endif
+void OW_Weather::printWeather(OW_DataSet set) {
+  printDataSet(set.data, set.fields, set.fieldCount);
+}
 
-  OW_STATUS_PRINTF("\nThe connection to server is INSECURE (using AXTLS).\n");
+/***************************************************************************************
+** Function name:           parseRequest
+** Description:             Fetches the JSON message and feeds to the parser
+***************************************************************************************/
+// ESP32 always uses a secure connection
+bool OW_Weather::parseRequest(String url) {
 
-  // Send GET request
-  OW_STATUS_PRINTF("Sending GET request to api.openweathermap.org...\n");
-  client.print(String("GET ") + *url + " HTTP/1.1\r\n" + "Host: " + host + "\r\n" + "Connection: close\r\n\r\n");
+  // The response state is in use by a non-blocking fetch
+  if (fetchBusy()) return false;
 
-  // Pull out any header, X-Forecast-API-Calls: reports current daily API call count
-  while (client.available() || client.connected())
-  {
-    String line = client.readStringUntil('\n');
-    if (line == "\r") {
-      OW_STATUS_PRINTF("Header end found\n");
-      break;
-    }
+  return setUrl(url.c_str()) && request();
+}
 
-    OW_STATUS_PRINT(line); OW_STATUS_PRINTF("\n");
+/***************************************************************************************
+** Function name:           request
+** Description:             Fetch the url, trying again if it fails
+***************************************************************************************/
+bool OW_Weather::request() {
 
-    if ((millis() - timeout) > 5000UL)
-    {
-      OW_STATUS_PRINTF("HTTP header timeout\n");
-      client.stop();
-      return false;
-    }
-  }
+  requestStart = millis();
+  retryCount = 0;
 
+  while (true) {
+    bool result = fetch();
 
-  // Parse the JSON data, available() includes yields
-  while (client.available() || client.connected())
-  {
-    while (client.available())
-    {
-      c = client.read();
-      parser.parse(c);
-  #ifdef SHOW_JSON
-      if (c == '{' || c == '[' || c == '}' || c == ']') Serial.println();
-      Serial.print(c); if (ccount++ > 100 && c == ',') {ccount = 0; Serial.println();}
-  #endif
+    // A kept open connection closed by the server gives no response, so try a new one
+    if (!result && reusedConnection && !headerFound) {
+      OW_STATUS_PRINTF("Reconnecting\n");
+      result = fetch();
     }
 
-    if ((millis() - timeout) > 8000UL)
-    {
-      OW_STATUS_PRINTF("JSON client timeout\n");
-      parser.reset();
-      client.stop();
-      return false;
-    }
+    uint32_t wait;
+    if (result || !retryDelay(wait)) return result;
+    delay(wait);
   }
-
-  OW_STATUS_PRINTF("\nDone in "); OW_STATUS_PRINT(millis()-dt); OW_STATUS_PRINTF(" ms\n");
-
-  parser.reset();
-
-  client.stop();
-  
-  // A message has been parsed without error but the data-point correctness is unknown
-  return parseOK;
 }
 
- #endif // ESP32 or ESP8266 parseRequest
+/***************************************************************************************
+** Function name:           setTimeouts, setRetry
+** Description:             Set the request timeouts and the retry policy
+***************************************************************************************/
+void OW_Weather::setTimeouts(const OW_Timeouts &timeouts)
+{
+  this->timeouts = timeouts;
+}
 
+void OW_Weather::setRetry(uint8_t retries, uint32_t backoff, uint32_t maxBackoff)
+{
+  retryLimit = retries;
+  retryBackoff = backoff;
+  retryMaxBackoff = maxBackoff;
+}
 
 /***************************************************************************************
-** Function name:           key etc
-** Description:             These functions are called while parsing the JSON message
+** Function name:           retryDelay
+** Description:             Decide if a failed request is tried again, and when
 ***************************************************************************************/
-void OW_Weather::key(const char *key) {
+// The wait doubles for each retry up to the limit, and half of it is random so devices
+// that failed together do not all retry together. A client error response, e.g. 401
+// for a bad API key, is not retried as it would fail again.
+bool OW_Weather::retryDelay(uint32_t &wait)
+{
+  uint16_t status = response.status;
+  bool clientError = status >= 400 && status < 500 && status != 408 && status != 429;
+  if (retryCount >= retryLimit || clientError) return false;
+
+  uint32_t cap = retryMaxBackoff;
+  if (retryCount < 31 && (retryBackoff << retryCount) >> retryCount == retryBackoff) {
+    uint32_t backoff = retryBackoff << retryCount;
+    if (backoff < cap) cap = backoff;
+  }
+  wait = cap / 2 + random(cap / 2 + 1);
 
-  currentKey = key;
+  // No time to wait and try again before the deadline
+  if (timeouts.deadline && (millis() - requestStart) + wait >= timeouts.deadline) return false;
 
-#ifdef SHOW_CALLBACK
-  Serial.println("\n>>> Key >>>" + (String)key);
-#endif
+  retryCount++;
+  stats.retries++;
+  OW_STATUS_PRINTF("Retry "); OW_STATUS_PRINT(retryCount); OW_STATUS_PRINTF(" in ");
+  OW_STATUS_PRINT(wait); OW_STATUS_PRINTF(" ms\n");
+  return true;
 }
 
-void OW_Weather::startDocument() {
+/***************************************************************************************
+** Function name:           timedOut, timeLeft
+** Description:             Check the phase timeouts against the request deadline
+***************************************************************************************/
+// true if limit ms have passed since the time given, or the request deadline has passed
+bool OW_Weather::timedOut(uint32_t since, uint32_t limit)
+{
+  uint32_t now = millis();
+  if (now - since > limit) return true;
 
-  currentParent = currentKey =   currentSet = "";
-  objectLevel = 0;
-  valuePath = "";
+  return timeouts.deadline && (now - requestStart) > timeouts.deadline;
+}
+
+// limit, or the time to the request deadline if less
+uint32_t OW_Weather::timeLeft(uint32_t limit)
+{
+  if (!timeouts.deadline) return limit;
+
+  uint32_t used = millis() - requestStart;
+  if (used >= timeouts.deadline) return 1;
+  uint32_t left = timeouts.deadline - used;
+  return left < limit ? left : limit;
+}
+
+/***************************************************************************************
+** Function name:           parseRequestSecure, parseRequestInsecure
+** Description:             Fetches the JSON message using a https or http connection
+***************************************************************************************/
+// ESP32 always uses a secure connection
+bool OW_Weather::parseRequestSecure(String* url) {
+
+  Secure = true;
+  return setUrl(url->c_str()) && fetch();
+}
+
+bool OW_Weather::parseRequestInsecure(String* url) {
+
+  Secure = false;
+  return setUrl(url->c_str()) && fetch();
+}
+
+/***************************************************************************************
+** Function name:           fetch
+** Description:             Fetches the JSON message and feeds to the parser
+***************************************************************************************/
+bool OW_Weather::fetch() {
+
+  uint32_t dt = millis();
+
+  Client *client = openServer();
+  if (!client)
+  {
+    OW_STATUS_PRINTF("Connection failed.\n");
+    return false;
+  }
+
+  JSON_Decoder parser;
+  parser.setListener(this);
+
+  uint32_t timeout = millis();
+  resetResponse();
+
+  // Send GET request
+  Serial.println();
+  OW_STATUS_PRINTF("Sending GET request to "); OW_STATUS_PRINT(host); OW_STATUS_PRINTF(" port "); OW_STATUS_PRINT(port); OW_STATUS_PRINTF("\n");
+  if (!sendRequest(client)) {
+    releaseClient(client, false);
+    return false;
+  }
+
+  return receive(client, parser, dt, timeout);
+}
+
+/***************************************************************************************
+** Function name:           receive
+** Description:             Read the response and feed the JSON body to the parser
+***************************************************************************************/
+// start is the time the fetch began, sent the time the request was sent
+bool OW_Weather::receive(Client *client, JSON_Decoder &parser, uint32_t start, uint32_t sent) {
+
+  uint32_t timeout = sent;
+  uint8_t buf[OW_READ_BUFFER_SIZE]; // Block read buffer for the JSON body
+
+  // Read the response header, the body is only parsed if the request succeeded
+  if (!readHeader(client, timeout)) return false;
+
+  OW_STATUS_PRINTF("\nParsing JSON\n");
+
+  // Parse the JSON data, available() includes yields
+  while (!dataComplete && !bodyDone() && (client->available() > 0 || client->connected()))
+  {
+    int n;
+    while (!dataComplete && (n = readBody(client, buf, sizeof(buf))) > 0) {
+      feedParser(parser, buf, n);
+      timeout = millis(); // A slow message is not timed out while it is arriving
+    }
+
+    if (timedOut(timeout, timeouts.idle))
+    {
+      OW_STATUS_PRINTF("JSON client timeout\n");
+      parser.reset();
+      releaseClient(client, false);
+      return false;
+    }
+    yield();
+  }
+
+  // A message cut short is a failed parse, unless all wanted values were received
+  if (depth != 0 && !dataComplete) parseOK = false;
+
+  printReceiveStatus();
+  OW_STATUS_PRINTF("\nDone in "); OW_STATUS_PRINT(millis()-start); OW_STATUS_PRINTF(" ms\n");
+  Serial.println();
+
+  parser.reset();
+
+  releaseClient(client, true);
+
+  // A message has been parsed without error but the data-point correctness is unknown
+  return parseOK;
+}
+
+/***************************************************************************************
+** Function name:           beginRequest
+** Description:             Start a non-blocking fetch, poll() then does each step
+***************************************************************************************/
+bool OW_Weather::beginRequest(String url)
+{
+  if (fetchBusy()) return false;
+
+  if (setUrl(url.c_str()) && beginFetch()) return true;
+
+  dataSetCount = 0;
+  return false;
+}
+
+bool OW_Weather::beginFetch()
+{
+  // The parser state must last from one poll() to the next
+  if (!fetchParser) fetchParser = new (std::nothrow) JSON_Decoder;
+  if (!fetchParser) {
+    dataSetCount = 0;
+    fetchState = OW_FETCH_ERROR;
+    return false;
+  }
+  fetchParser->setListener(this);
+
+  requestStart = millis();
+  retryCount = 0;
+  fetchRetried = false;
+  fetchState = OW_FETCH_CONNECT;
+  return true;
+}
+
+/***************************************************************************************
+** Function name:           poll
+** Description:             Do the next step of a non-blocking fetch
+***************************************************************************************/
+// Each call does one step: connect, send the request, read the header bytes available,
+// read and parse one block of the body, or read one block of the unwanted end of the
+// body. Only the connect step can take long, the TCP connect and TLS handshake are done
+// in one call and wait for the server, up to the connect timeout (see setTimeouts()).
+uint8_t OW_Weather::poll()
+{
+  // The connection has gone if stop() was called during the fetch
+  if (fetchState == OW_FETCH_DRAIN && !connection) return endFetch(true, false);
+  if (fetchState >= OW_FETCH_SEND && fetchState <= OW_FETCH_BODY && !connection) return endFetch(false);
+
+  switch (fetchState) {
+
+    case OW_FETCH_CONNECT:
+      if (!openServer()) {
+        OW_STATUS_PRINTF("Connection failed.\n");
+        return endFetch(false);
+      }
+      resetResponse();
+      fetchState = OW_FETCH_SEND;
+      return OW_POLL_IN_PROGRESS;
+
+    case OW_FETCH_SEND:
+      OW_STATUS_PRINTF("Sending GET request to "); OW_STATUS_PRINT(host); OW_STATUS_PRINTF("\n");
+      if (!sendRequest(connection)) return endFetch(false);
+      fetchTimer = millis();
+      fetchState = OW_FETCH_HEADER;
+      return OW_POLL_IN_PROGRESS;
+
+    case OW_FETCH_HEADER:
+      for (int n = 0; n < OW_READ_BUFFER_SIZE && connection->available() > 0; n++) {
+        int c = connection->read();
+        if (c < 0) break;
+#ifdef SHOW_HEADER
+        Serial.write((uint8_t)c);
+#endif
+        if (headerByte(c)) {
+          headerFound = true;
+          break;
+        }
+      }
+
+      if (!headerFound) {
+        if (connection->available() > 0 || connection->connected()) {
+          if (!timedOut(fetchTimer, timeouts.header)) return OW_POLL_IN_PROGRESS;
+          OW_STATUS_PRINTF("HTTP header timeout\n");
+          releaseClient(connection, false);
+          return endFetch(false);
+        }
+
+        // A kept open connection closed by the server gives no response, so try a new one
+        if (reusedConnection && !fetchRetried) {
+          OW_STATUS_PRINTF("Reconnecting\n");
+          releaseClient(connection, false);
+          fetchRetried = true;
+          fetchState = OW_FETCH_CONNECT;
+          return OW_POLL_IN_PROGRESS;
+        }
+      }
+
+      if (!checkResponse(connection)) return endFetch(false);
+      OW_STATUS_PRINTF("\nParsing JSON\n");
+      fetchState = OW_FETCH_BODY;
+      return OW_POLL_IN_PROGRESS;
+
+    case OW_FETCH_BODY:
+    {
+      uint8_t buf[OW_READ_BUFFER_SIZE]; // Block read buffer for the JSON body
+      int n = readBody(connection, buf, sizeof(buf));
+      if (n > 0) {
+        feedParser(*fetchParser, buf, n);
+        fetchTimer = millis(); // A slow message is not timed out while it is arriving
+      }
+
+      if (dataComplete || bodyDone() || (connection->available() <= 0 && !connection->connected())) {
+        // All wanted values received, the rest of the body is read in the next polls so
+        // a kept open connection can be used again
+        if (!bodyDone() && connection->connected() && keepAliveOn && !response.close &&
+            (response.contentLength || chunkState) && chunkState != OW_CHUNK_ERROR) {
+          fetchState = OW_FETCH_DRAIN;
+          return OW_POLL_IN_PROGRESS;
+        }
+        return endFetch(true);
+      }
+
+      if (timedOut(fetchTimer, timeouts.idle)) {
+        OW_STATUS_PRINTF("JSON client timeout\n");
+        releaseClient(connection, false);
+        return endFetch(false);
+      }
+      return OW_POLL_IN_PROGRESS;
+    }
+
+    case OW_FETCH_DRAIN:
+    {
+      uint8_t buf[OW_READ_BUFFER_SIZE]; // Body bytes not wanted, dropped
+      if (readBody(connection, buf, sizeof(buf)) > 0) fetchTimer = millis();
+
+      if (bodyDone()) return endFetch(true);
+
+      // The values are parsed, but the connection can not be used again
+      if ((connection->available() <= 0 && !connection->connected()) ||
+          chunkState == OW_CHUNK_ERROR || timedOut(fetchTimer, timeouts.idle)) {
+        return endFetch(true, false);
+      }
+      return OW_POLL_IN_PROGRESS;
+    }
+
+    case OW_FETCH_BACKOFF:
+      if (millis() - fetchTimer < retryWait) return OW_POLL_IN_PROGRESS;
+      fetchRetried = false;
+      fetchState = OW_FETCH_CONNECT;
+      return OW_POLL_IN_PROGRESS;
+
+    case OW_FETCH_DONE:
+      return OW_POLL_DONE;
+
+    default: // OW_FETCH_IDLE or OW_FETCH_ERROR
+      return OW_POLL_ERROR;
+  }
+}
+
+/***************************************************************************************
+** Function name:           fetchBusy
+** Description:             true if a non-blocking fetch is in progress
+***************************************************************************************/
+bool OW_Weather::fetchBusy()
+{
+  if (fetchState < OW_FETCH_CONNECT) return false;
+
+  OW_STATUS_PRINTF("Fetch in progress\n");
+  return true;
+}
+
+/***************************************************************************************
+** Function name:           endFetch
+** Description:             Finish a non-blocking fetch, returns the poll() value
+***************************************************************************************/
+// If the body has been read (parsed true) the client is released here, otherwise it
+// has already been released. reuse is false if the connection can not be kept open.
+uint8_t OW_Weather::endFetch(bool parsed, bool reuse)
+{
+  if (parsed) {
+    // A message cut short is a failed parse, unless all wanted values were received
+    if (depth != 0 && !dataComplete) parseOK = false;
+
+    printReceiveStatus();
+    OW_STATUS_PRINTF("\nDone in "); OW_STATUS_PRINT(millis()-requestStart); OW_STATUS_PRINTF(" ms\n");
+
+    releaseClient(connection, reuse);
+  }
+  else parseOK = false;
+
+  // Wait in the OW_FETCH_BACKOFF state, then try again
+  if (!parseOK && retryDelay(retryWait)) {
+    fetchParser->reset();
+    fetchTimer = millis();
+    fetchState = OW_FETCH_BACKOFF;
+    return OW_POLL_IN_PROGRESS;
+  }
+
+  // Return the parser memory, and forget the struct pointers
+  delete fetchParser;
+  fetchParser = nullptr;
+  dataSetCount = 0;
+
+  fetchState = parseOK ? OW_FETCH_DONE : OW_FETCH_ERROR;
+  return parseOK ? OW_POLL_DONE : OW_POLL_ERROR;
+}
+
+/***************************************************************************************
+** Function name:           openServer
+** Description:             Connect to the server with the transport in use
+***************************************************************************************/
+// The sketch client set by setClient() is used if there is one, otherwise a WiFi client
+// of the type needed by the processor and the secure setting. The client is kept by the
+// class until the message has been read, so the blocking and non-blocking fetches are
+// the same from here on.
+Client *OW_Weather::openServer()
+{
+  if (transport) {
+    port = serverPort ? serverPort : (Secure ? 443 : 80);
+    return openTransport();
+  }
+
+#ifdef ESP32
+  OW_STATUS_PRINTF("\n\nThe connection to server is secure (https). Certificate not checked.\n");
+  port = serverPort ? serverPort : 443;
+  return openClient<WiFiClientSecure>();
+#else
+  if (!Secure) {
+    OW_STATUS_PRINTF("\nThe connection to server is INSECURE (using AXTLS).\n");
+    port = serverPort ? serverPort : 80;
+    return openClient<WiFiClient>();
+  }
+
+  port = serverPort ? serverPort : 443;
+  #if (defined(ARDUINO_ARCH_MBED) || defined(ARDUINO_ARCH_RP2040)) && !defined(ARDUINO_RASPBERRY_PI_PICO_W)
+  return openClient<WiFiSSLClient>();
+  #else
+  #ifdef ESP8266
+  OW_STATUS_PRINTF("\nThe connection to server is using BearSSL in insecure mode (certificates not checked).\n");
+  #endif
+  // Must use namespace:: to select BearSSL
+  return openClient<BearSSL::WiFiClientSecure>();
+  #endif
+#endif
+}
+
+/***************************************************************************************
+** Function name:           setServer, setClient
+** Description:             Select the server and the client used to connect to it
+***************************************************************************************/
+void OW_Weather::setServer(const char *host, uint16_t port)
+{
+  stop();
+  this->host = host;
+  serverPort = port;
+}
+
+void OW_Weather::setClient(Client *client)
+{
+  stop();
+  transport = client;
+}
+
+void OW_Weather::setDnsCache(OW_DnsCache *cache)
+{
+  dnsCache = cache;
+}
+
+/***************************************************************************************
+** Function name:           sendRequest
+** Description:             Send the GET request
+***************************************************************************************/
+// The request is built on the stack instead of with String concatenation, so no heap
+// memory is used, and it is sent in one write
+bool OW_Weather::sendRequest(Client *client)
+{
+  char buffer[OW_URL_SIZE + 160];
+  OW_RequestBuilder text(buffer, sizeof(buffer));
+
+  text.add("GET ").add(requestUrl).add(" HTTP/1.1\r\n");
+  text.add("Host: ").add(host.c_str());
+  if (port != (Secure ? 443 : 80)) text.add(':').addNumber(port, 0);
+  text.add("\r\n");
+  text.add(acceptEncoding());
+  text.add("Connection: ").add(keepAliveOn ? "keep-alive" : "close").add("\r\n\r\n");
+
+  if (!text.fits()) {
+    OW_STATUS_PRINTF("Request too long\n");
+    return false;
+  }
+
+  return client->write((const uint8_t *)buffer, text.length()) == text.length();
+}
+
+/***************************************************************************************
+** Function name:           keepAlive, stop
+** Description:             Keep the server connection open between requests, or close it
+***************************************************************************************/
+void OW_Weather::keepAlive(bool enable) {
+
+  keepAliveOn = enable;
+  if (!enable) stop();
+}
+
+void OW_Weather::stop() {
+
+  if (!connection) return;
+
+  connection->stop();
+  connectionFree(connection);
+  connection = nullptr;
+}
+
+OW_Weather::~OW_Weather() {
+
+  stop();
+  delete fetchParser;
+#ifdef OW_TLS_SESSION
+  delete tlsSession;
+#endif
+}
+
+// Certificates are not checked
+static inline void OW_setInsecure(Client &) { }
+#if !(defined(ARDUINO_ARCH_MBED) || defined(ARDUINO_ARCH_RP2040)) || defined(ARDUINO_RASPBERRY_PI_PICO_W)
+static inline void OW_setInsecure(WiFiClientSecure &client) { client.setInsecure(); }
+#endif
+
+// Connect to an address, a TLS client is given the name too for the server name (SNI)
+static inline int OW_connect(Client &client, IPAddress ip, const char *, uint16_t port) {
+  return client.connect(ip, port);
+}
+#ifdef ESP32
+static inline int OW_connect(WiFiClientSecure &client, IPAddress ip, const char *host, uint16_t port) {
+  return client.connect(ip, port, host, nullptr, nullptr, nullptr);
+}
+#endif
+
+// false if the client can not send the server name when connecting to an address
+static inline bool OW_byAddress(Client &) { return true; }
+#ifdef OW_TLS_SESSION
+static inline bool OW_byAddress(BearSSL::WiFiClientSecure &) { return false; }
+#endif
+#if (defined(ARDUINO_ARCH_MBED) || defined(ARDUINO_ARCH_RP2040)) && !defined(ARDUINO_RASPBERRY_PI_PICO_W)
+static inline bool OW_byAddress(WiFiSSLClient &) { return false; }
+#endif
+
+#ifdef OW_TLS_SESSION
+// Offer the session to a TLS client, returns false if not a TLS client
+static inline bool OW_setSession(Client &, BearSSL::Session *) { return false; }
+static inline bool OW_setSession(BearSSL::WiFiClientSecure &client, BearSSL::Session *session) {
+  client.setSession(session);
+  return true;
+}
+#endif
+
+/***************************************************************************************
+** Function name:           openClient
+** Description:             Connect to the server, returns the client or nullptr if failed
+***************************************************************************************/
+// The client is created for the request and deleted by releaseClient(), unless it is
+// kept open by keepAlive(true). Then the open connection is reused, so the TLS handshake
+// is only done when needed.
+template <typename T>
+Client *OW_Weather::openClient()
+{
+  if (reuseConnection()) return connection;
+
+  T *client = new (std::nothrow) T;
+  if (!client) return nullptr;
+
+  OW_setInsecure(*client);
+  if (!connectClient(*client, host.c_str(), port)) {
+    delete client;
+    return nullptr;
+  }
+
+  connection = client;
+  connectionFree = [](Client *c) { delete static_cast<T *>(c); };
+  connectionPort = port;
+  return connection;
+}
+
+// The sketch client is never deleted, only stopped
+Client *OW_Weather::openTransport()
+{
+  if (reuseConnection()) return connection;
+
+  if (!connectClient(*transport, host.c_str(), port)) return nullptr;
+
+  connection = transport;
+  connectionFree = [](Client *) { };
+  connectionPort = port;
+  return connection;
+}
+
+// true if the kept open connection can be used for the request, if not it is closed
+bool OW_Weather::reuseConnection()
+{
+  reusedConnection = false;
+
+  if (connection && connectionPort == port && connection->connected()) {
+    OW_STATUS_PRINTF("Reusing open connection\n");
+    reusedConnection = true;
+    return true;
+  }
+
+  stop();
+  return false;
+}
+
+/***************************************************************************************
+** Function name:           connectClient
+** Description:             Connect a new client and update the statistics
+***************************************************************************************/
+// A BearSSL client is given the cached session, it is resumed if the server still holds
+// it, which is seen as an unchanged session ID after the handshake.
+template <typename T>
+bool OW_Weather::connectClient(T &client, const char *host, uint16_t port)
+{
+#ifdef OW_TLS_SESSION
+  if (!tlsSession) tlsSession = new BearSSL::Session;
+  bool tls = OW_setSession(client, tlsSession);
+
+  br_ssl_session_parameters *params = tlsSession->getSession();
+  uint8_t idLength = params->session_id_len;
+  uint8_t id[sizeof(params->session_id)];
+  memcpy(id, params->session_id, sizeof(id));
+#endif
+
+  // The clients use the Stream timeout for the TCP connect and TLS handshake
+  static_cast<Client &>(client).setTimeout(timeLeft(timeouts.connect));
+
+  uint32_t dt = millis();
+  bool connected;
+  IPAddress ip;
+  if (dnsCache && OW_byAddress(client)) {
+    bool cached = dnsCache->find(host, ip);
+    connected = (cached || dnsCache->resolve(host, ip)) && OW_connect(client, ip, host, port);
+
+    // The server may have moved, look the name up again
+    if (!connected && cached) {
+      dnsCache->invalidate(host);
+      connected = dnsCache->resolve(host, ip) && OW_connect(client, ip, host, port);
+    }
+  }
+  else connected = client.connect(host, port);
+  stats.connectMs = millis() - dt;
+  stats.resumed = false;
+  if (!connected) return false;
+
+  stats.connects++;
+#ifdef OW_TLS_SESSION
+  stats.resumed = tls && idLength && params->session_id_len == idLength &&
+                  memcmp(id, params->session_id, idLength) == 0;
+  if (stats.resumed) stats.resumes++;
+#endif
+
+  OW_STATUS_PRINTF("Connected in "); OW_STATUS_PRINT(stats.connectMs);
+  OW_STATUS_PRINTF(stats.resumed ? " ms, TLS session resumed\n" : " ms\n");
+  return true;
+}
+
+#ifdef OW_TLS_SESSION
+/***************************************************************************************
+** Function name:           clearSession
+** Description:             Forget the TLS session, the next connect does a full handshake
+***************************************************************************************/
+void OW_Weather::clearSession()
+{
+  if (tlsSession) memset(tlsSession->getSession(), 0, sizeof(br_ssl_session_parameters));
+}
+
+#ifdef OW_SAVE_TLS_SESSION
+/***************************************************************************************
+** Function name:           saveSession, loadSession
+** Description:             Keep the TLS session in a file for use after a restart
+***************************************************************************************/
+bool OW_Weather::saveSession(fs::FS &fs, const char *path)
+{
+  if (!tlsSession || !tlsSession->getSession()->session_id_len) return false;
+
+  fs::File file = fs.open(path, "w");
+  if (!file) return false;
+
+  size_t n = file.write((const uint8_t *)tlsSession->getSession(), sizeof(br_ssl_session_parameters));
+  file.close();
+
+  return n == sizeof(br_ssl_session_parameters);
+}
+
+bool OW_Weather::loadSession(fs::FS &fs, const char *path)
+{
+  fs::File file = fs.open(path, "r");
+  if (!file) return false;
+
+  if (!tlsSession) tlsSession = new BearSSL::Session;
+  br_ssl_session_parameters *params = tlsSession->getSession();
+
+  bool ok = (file.size() == sizeof(br_ssl_session_parameters)) &&
+            (file.read((uint8_t *)params, sizeof(br_ssl_session_parameters)) == sizeof(br_ssl_session_parameters));
+  file.close();
+
+  if (!ok) clearSession();
+  return ok;
+}
+#endif // OW_SAVE_TLS_SESSION
+#endif // OW_TLS_SESSION
+
+/***************************************************************************************
+** Function name:           releaseClient
+** Description:             Close the connection, unless it can be kept open
+***************************************************************************************/
+void OW_Weather::releaseClient(Client *client, bool reuse)
+{
+  // A bad body can not be read to its end, and fails the request even if the JSON parsed
+  bool bad = (chunkState == OW_CHUNK_ERROR);
+#ifdef OW_GZIP
+  if (inflater && inflater->failed()) bad = true;
+#endif
+  if (bad) {
+    reuse = false;
+    parseOK = false;
+  }
+
+  if (client != connection) client->stop();
+
+  // Only a message with a known length can be read to its end, ready for the next one
+  else if (!(reuse && keepAliveOn && !response.close && (response.contentLength || chunkState) && drainBody(client))) stop();
+
+#ifdef OW_GZIP
+  // The check value is at the end of the body, so may only be read by drainBody()
+  if (!bad && inflater && inflater->failed()) {
+    parseOK = false;
+    stop();
+  }
+#endif
+
+#ifdef OW_GZIP
+  // Return the inflate window to the heap, getForecasts() keeps it for the next response
+  if (!batch) {
+    delete inflater;
+    inflater = nullptr;
+  }
+#endif
+}
+
+/***************************************************************************************
+** Function name:           resetResponse
+** Description:             Clear the response state before a request
+***************************************************************************************/
+void OW_Weather::resetResponse()
+{
+  parseOK = false;
+  dataComplete = false;
+  documentEnd = false;
+  skipMode = OW_SKIP_OFF;
+  bytesReceived = 0;
+  bodyRead = 0;
+  headerFound = false;
+  response = OW_Response();
+  headerState = OW_HEADER_STATUS;
+  chunkState = OW_CHUNK_OFF;
+  chunkSize = 0;
+}
+
+/***************************************************************************************
+** Function name:           readHeader
+** Description:             Read the response header, the body follows if true returned
+***************************************************************************************/
+// Bytes are read one at a time so the body is left in the client for the block reads.
+// A failed request is not parsed, the client is released here.
+bool OW_Weather::readHeader(Client *client, uint32_t timeout)
+{
+  while (client->available() > 0 || client->connected())
+  {
+    while (client->available() > 0) {
+      int c = client->read();
+      if (c < 0) break;
+#ifdef SHOW_HEADER
+      Serial.write((uint8_t)c);
+#endif
+      if (headerByte(c)) {
+        headerFound = true;
+        break;
+      }
+    }
+    if (headerFound) break;
+
+    if (timedOut(timeout, timeouts.header))
+    {
+      OW_STATUS_PRINTF("HTTP header timeout\n");
+      releaseClient(client, false);
+      return false;
+    }
+    yield();
+  }
+
+  return checkResponse(client);
+}
+
+/***************************************************************************************
+** Function name:           checkResponse
+** Description:             Check for a 200 response header, release the client if not
+***************************************************************************************/
+bool OW_Weather::checkResponse(Client *client)
+{
+  // A kept open connection may have been closed by the server while idle
+  if (!headerFound)
+  {
+    OW_STATUS_PRINTF("No response header\n");
+    releaseClient(client, false);
+    return false;
+  }
+
+  OW_STATUS_PRINTF("Header end found, status "); OW_STATUS_PRINT(response.status); OW_STATUS_PRINTF("\n");
+
+  // The body of an error response is not JSON weather data, it is read (if the length
+  // is known) only so a kept open connection can be used again
+  if (response.status != 200)
+  {
+    OW_STATUS_PRINTF("Request failed\n");
+    releaseClient(client, true);
+    return false;
+  }
+
+  return true;
+}
+
+/***************************************************************************************
+** Function name:           headerByte
+** Description:             Response header parser, true returned at the end of the header
+***************************************************************************************/
+// The header is parsed a byte at a time with no line buffer, field names and the value
+// tokens that matter are short so are matched in the fixed size headerToken buffer.
+bool OW_Weather::headerByte(uint8_t c)
+{
+  if (c == '\r') return false;
+
+  if (c == '\n') {
+    if (headerState == OW_HEADER_VALUE) headerValue(0);
+    // A blank line ends the header
+    else if (headerState == OW_HEADER_NAME && headerPos == 0) headerState = OW_HEADER_END;
+
+    if (headerState != OW_HEADER_END) {
+      headerState = OW_HEADER_NAME;
+      headerPos = 0;
+      return false;
+    }
+
+    // Transfer-Encoding overrides any Content-Length (RFC 9112 6.3)
+    if (response.chunked) {
+      response.contentLength = 0;
+      chunkState = OW_CHUNK_SIZE;
+    }
+#ifdef OW_GZIP
+    if (inflater) inflater->begin(response.encoding);
+#endif
+    return true;
+  }
+
+  switch (headerState) {
+
+    case OW_HEADER_STATUS: // "HTTP/1.1 200 OK", the code follows the first space
+      if (c == ' ') headerState = OW_HEADER_CODE;
+      break;
+
+    case OW_HEADER_CODE:
+      if (c >= '0' && c <= '9') response.status = response.status * 10 + (c - '0');
+      else if (response.status) headerState = OW_HEADER_SKIP;
+      break;
+
+    case OW_HEADER_NAME:
+      if (c != ':') {
+        if (headerPos < OW_HEADER_TOKEN - 1) headerToken[headerPos] = tolower(c);
+        if (headerPos < 255) headerPos++;
+        break;
+      }
+      headerField = OW_HDR_NONE;
+      if (headerPos < OW_HEADER_TOKEN) {
+        headerToken[headerPos] = 0;
+        if      (!strcmp(headerToken, "content-length"))    headerField = OW_HDR_LENGTH;
+        else if (!strcmp(headerToken, "transfer-encoding")) headerField = OW_HDR_TRANSFER;
+        else if (!strcmp(headerToken, "content-encoding"))  headerField = OW_HDR_ENCODING;
+        else if (!strcmp(headerToken, "connection"))        headerField = OW_HDR_CONNECTION;
+        else if (!strcmp(headerToken, "etag"))              headerField = OW_HDR_ETAG;
+        else if (!strcmp(headerToken, "last-modified"))     headerField = OW_HDR_MODIFIED;
+        else if (!strcmp(headerToken, "cache-control"))     headerField = OW_HDR_CACHE;
+      }
+      headerState = headerField ? OW_HEADER_VALUE : OW_HEADER_SKIP;
+      headerPos = 0;
+      break;
+
+    case OW_HEADER_VALUE:
+      headerValue(c);
+      break;
+
+    default: // OW_HEADER_SKIP or OW_HEADER_END
+      break;
+  }
+
+  return false;
+}
+
+/***************************************************************************************
+** Function name:           headerValue
+** Description:             Collect a header field value, c = 0 at the end of the line
+***************************************************************************************/
+// Token lists such as "Cache-Control: no-cache, max-age=600" are matched one token at
+// a time, at each ',' or ';' and at the end of the line.
+void OW_Weather::headerValue(uint8_t c)
+{
+  // Text values are copied as sent, less leading spaces and truncated to fit
+  if (headerField == OW_HDR_ETAG || headerField == OW_HDR_MODIFIED) {
+    char  *text = (headerField == OW_HDR_ETAG) ? response.etag : response.lastModified;
+    size_t size = (headerField == OW_HDR_ETAG) ? sizeof(response.etag) : sizeof(response.lastModified);
+    if (c == 0 || (c == ' ' && headerPos == 0)) return;
+    if (headerPos < size - 1) {
+      text[headerPos++] = c;
+      text[headerPos] = 0;
+    }
+    return;
+  }
+
+  if (headerField == OW_HDR_LENGTH) {
+    if (c >= '0' && c <= '9') response.contentLength = response.contentLength * 10 + (c - '0');
+    return;
+  }
+
+  if (c != 0 && c != ',' && c != ';') {
+    if (c == ' ') return;
+    if (headerPos < OW_HEADER_TOKEN - 1) headerToken[headerPos] = tolower(c);
+    if (headerPos < 255) headerPos++;
+    return;
+  }
+
+  // End of a token, a token too long for the buffer is not one that is matched
+  bool fits = headerPos < OW_HEADER_TOKEN;
+  headerToken[fits ? headerPos : 0] = 0;
+  headerPos = 0;
+
+  switch (headerField) {
+    case OW_HDR_TRANSFER:
+      if (!strcmp(headerToken, "chunked")) response.chunked = true;
+      break;
+    case OW_HDR_ENCODING:
+      if (!strcmp(headerToken, "gzip")) response.encoding = OW_INFLATE_GZIP;
+      else if (!strcmp(headerToken, "deflate")) response.encoding = OW_INFLATE_ZLIB;
+      break;
+    case OW_HDR_CONNECTION:
+      if (!strcmp(headerToken, "close")) response.close = true;
+      break;
+    case OW_HDR_CACHE:
+      if (!strcmp(headerToken, "no-cache") || !strcmp(headerToken, "no-store")) response.noCache = true;
+      else if (!strncmp(headerToken, "max-age=", 8)) response.maxAge = strtoul(headerToken + 8, nullptr, 10);
+      break;
+  }
+}
+
+/***************************************************************************************
+** Function name:           acceptEncoding
+** Description:             Request header line for a compressed response, if supported
+***************************************************************************************/
+// The inflate window is taken from the heap before the request is sent, a compressed
+// response is only asked for if the window is available.
+const char *OW_Weather::acceptEncoding()
+{
+#ifdef OW_GZIP
+  if (!inflater) {
+    inflater = new (std::nothrow) OW_Inflate;
+    if (inflater && !inflater->allocate()) {
+      delete inflater;
+      inflater = nullptr;
+    }
+  }
+  if (inflater) return "Accept-Encoding: gzip\r\n";
+#endif
+
+  return "";
+}
+
+/***************************************************************************************
+** Function name:           readBody, bodyDone, inflateBody, readRaw, rawDone, drainBody
+** Description:             Read the message body, ending at Content-Length if sent
+***************************************************************************************/
+// A kept open connection is not closed by the server at the end of the message, so the
+// body is framed by Content-Length, the last chunk, or by the end of the JSON document.
+// Chunked and compressed bodies are decoded here, so only JSON bytes are returned.
+int OW_Weather::readBody(Client *client, uint8_t *buf, size_t size)
+{
+#ifdef OW_GZIP
+  if (inflater && inflater->active()) return inflateBody(client, buf, size);
+#endif
+
+  return readRaw(client, buf, size);
+}
+
+bool OW_Weather::bodyDone()
+{
+#ifdef OW_GZIP
+  // A bad compressed body is abandoned
+  if (inflater && inflater->active()) return inflater->failed() || (inflater->finished() && rawDone());
+#endif
+
+  return rawDone();
+}
+
+#ifdef OW_GZIP
+int OW_Weather::inflateBody(Client *client, uint8_t *buf, size_t size)
+{
+  while (!bodyDone()) {
+    // The compressed data ends with the body, or when the server closes the connection
+    bool last = rawDone() || (client->available() <= 0 && !client->connected());
+
+    size_t n = inflater->read(buf, size, last);
+    if (n > 0) return n;
+
+    // Anything after the compressed data, e.g. the last chunk, is read and discarded
+    if (inflater->finished()) {
+      if (readRaw(client, buf, size) <= 0) return 0;
+      continue;
+    }
+
+    size_t space;
+    uint8_t *in = inflater->inputSpace(space);
+    int r = readRaw(client, in, space);
+    if (r > 0) {
+      inflater->add(r);
+      continue;
+    }
+
+    // The body ended without more compressed data, e.g. at chunk trailers, so read()
+    // is called again with last set to end the stream or find it cut short
+    if (!last && (rawDone() || (client->available() <= 0 && !client->connected()))) continue;
+    return 0;
+  }
+
+  return 0;
+}
+#endif
+
+int OW_Weather::readRaw(Client *client, uint8_t *buf, size_t size)
+{
+  while (!rawDone()) {
+    int n = client->available();
+    if (n > (int)size) n = size;
+    if (response.contentLength && (uint32_t)n > response.contentLength - bodyRead) n = response.contentLength - bodyRead;
+
+    // A chunked body is not read past its end, so a pipelined response (see getForecasts())
+    // is left in the client. Chunk data is followed by at least 7 bytes: the CRLF, the
+    // shortest size line "0\r\n" and the final CRLF. Size lines are read a byte at a time.
+    if (chunkState == OW_CHUNK_DATA) {
+      if ((uint32_t)n > chunkSize + 7) n = chunkSize + 7;
+    }
+    else if (chunkState != OW_CHUNK_OFF && n > 1) n = 1;
+    if (n <= 0) return 0;
+
+    n = client->read(buf, n);
+    if (n <= 0) return 0;
+    bodyRead += n;
+
+    if (chunkState == OW_CHUNK_OFF) return n;
+
+    // Block may hold only chunk size lines, if so read the next one
+    n = dechunk(buf, n);
+    if (n > 0) return n;
+  }
+
+  return 0;
+}
+
+bool OW_Weather::rawDone()
+{
+  if (chunkState != OW_CHUNK_OFF) return chunkState >= OW_CHUNK_END;
+  if (response.contentLength) return bodyRead >= response.contentLength;
+#ifdef OW_GZIP
+  // The JSON ends before the check value, so a compressed body ends with the stream
+  if (inflater && inflater->active()) return inflater->finished();
+#endif
+  return documentEnd;
+}
+
+/***************************************************************************************
+** Function name:           dechunk
+** Description:             Remove chunked transfer encoding in place
+***************************************************************************************/
+// The state is kept in class members so chunk size lines can span read blocks. Chunk
+// data is moved down over the size lines, so the returned bytes start at buf.
+size_t OW_Weather::dechunk(uint8_t *buf, size_t len)
+{
+  uint8_t *out = buf;
+  const uint8_t *in = buf;
+  const uint8_t *end = buf + len;
+
+  while (in < end) {
+    if (chunkState == OW_CHUNK_DATA) {
+      size_t n = end - in;
+      if (n > chunkSize) n = chunkSize;
+      memmove(out, in, n);
+      out += n;
+      in += n;
+      chunkSize -= n;
+      if (chunkSize == 0) chunkState = OW_CHUNK_DATA_END;
+      continue;
+    }
+
+    uint8_t c = *in++;
+
+    switch (chunkState) {
+      case OW_CHUNK_SIZE:
+        if (c == '\n') chunkState = chunkSize ? OW_CHUNK_DATA : OW_CHUNK_TRAILER;
+        else if (c == ';') chunkState = OW_CHUNK_EXT;
+        else if (c == '\r' || c == ' ' || c == '\t') break;
+        else {
+          uint8_t v = (c >= '0' && c <= '9') ? c - '0' : (c | 0x20) - 'a' + 10;
+          if (v > 15 || (chunkSize >> 24)) { chunkState = OW_CHUNK_ERROR; return out - buf; }
+          chunkSize = (chunkSize << 4) | v;
+        }
+        break;
+
+      case OW_CHUNK_EXT:
+        if (c == '\n') chunkState = chunkSize ? OW_CHUNK_DATA : OW_CHUNK_TRAILER;
+        break;
+
+      case OW_CHUNK_DATA_END:
+        if (c == '\n') chunkState = OW_CHUNK_SIZE;
+        break;
+
+      case OW_CHUNK_TRAILER:
+        if (c == '\n') chunkState = OW_CHUNK_END;
+        else if (c != '\r') chunkState = OW_CHUNK_TRAILER_LINE;
+        break;
+
+      case OW_CHUNK_TRAILER_LINE:
+        if (c == '\n') chunkState = OW_CHUNK_TRAILER;
+        break;
+
+      default: // OW_CHUNK_END or OW_CHUNK_ERROR, ignore anything after the body
+        return out - buf;
+    }
+  }
+
+  return out - buf;
+}
+
+// Read and discard the rest of a message stopped early, returns false if the connection
+// closes or the body stops arriving. This blocks, it is called by releaseClient() after a
+// parse and for the body of a non-200 response. Each wait for more of the body is up to
+// the idle timeout, and never past the request deadline.
+bool OW_Weather::drainBody(Client *client)
+{
+  uint8_t buf[64];
+  uint32_t timer = millis();
+  uint32_t limit = timeLeft(timeouts.idle);
+
+  while (!bodyDone()) {
+    if (readBody(client, buf, sizeof(buf)) > 0) {
+      timer = millis(); // A slow message is not timed out while it is arriving
+      limit = timeLeft(timeouts.idle);
+      continue;
+    }
+    if (!client->connected() || (millis() - timer) >= limit) return false;
+    yield();
+  }
+
+  return true;
+}
+
+/***************************************************************************************
+** Function name:           feedParser
+** Description:             Pass a block of the received JSON message to the parser
+***************************************************************************************/
+// Values that are not wanted are skipped here without calling the parser, then a "0"
+// placeholder is passed to the parser in their place so it stays in step.
+void OW_Weather::feedParser(JSON_Decoder &parser, const uint8_t *buf, size_t len)
+{
+  const uint8_t *start = buf;
+  const uint8_t *end = buf + len;
+
+  while (buf < end && !dataComplete)
+  {
+    if (skipMode >= OW_SKIP_VALUE) {
+      buf = skipBytes(buf, end);
+      if (skipMode == OW_SKIP_DONE) {
+        parser.parse('0');
+        skipMode = OW_SKIP_OFF;
+      }
+      continue;
+    }
+
+    char c = (char)*buf++;
+    parser.parse(c);
+
+    // Unwanted key found, skip its value once the ':' has been passed to the parser
+    if (skipMode == OW_SKIP_KEY && c == ':') skipMode = OW_SKIP_VALUE;
+
+#ifdef SHOW_JSON
+    static int ccount = 0;
+    if (c == '{' || c == '[' || c == '}' || c == ']') Serial.println();
+    Serial.print(c); if (ccount++ > 100 && c == ',') {ccount = 0; Serial.println();}
+#endif
+  }
+
+  bytesReceived += buf - start;
+}
+
+/***************************************************************************************
+** Description:   Word at a time (SWAR) tests for the bytes that end a skip scan
+***************************************************************************************/
+// Non-zero if any byte in the word is zero
+#define OW_ZERO_BYTE(w) (((w) - 0x01010101UL) & ~(w) & 0x80808080UL)
+// Non-zero if any byte in the word equals c
+#define OW_HAS_BYTE(w, c) OW_ZERO_BYTE((w) ^ (0x01010101UL * (uint8_t)(c)))
+
+// Any of { } [ ] or " in the word, OR with 0x20 maps [ to { and ] to }
+static inline uint32_t OW_structByte(uint32_t w) {
+  uint32_t v = w | 0x20202020UL;
+  return OW_HAS_BYTE(v, '{') | OW_HAS_BYTE(v, '}') | OW_HAS_BYTE(w, '"');
+}
+
+// Any of " or \ in the word
+static inline uint32_t OW_stringByte(uint32_t w) {
+  return OW_HAS_BYTE(w, '"') | OW_HAS_BYTE(w, '\\');
+}
+
+/***************************************************************************************
+** Function name:           skipBytes
+** Description:             Skip over an unwanted value, returns pointer to next byte
+***************************************************************************************/
+// The scan state is kept in class members so a value can span several read blocks.
+// Objects and arrays are skipped by counting braces and brackets outside of strings,
+// four bytes are tested at a time until one that may end the scan is found.
+const uint8_t *OW_Weather::skipBytes(const uint8_t *buf, const uint8_t *end)
+{
+  if (skipMode == OW_SKIP_VALUE) {
+    while (buf < end && *buf <= ' ') buf++; // Whitespace before value
+    if (buf >= end) return buf;
+
+    uint8_t c = *buf;
+    skipDepth = 0;
+    skipInString = false;
+    skipEscape = false;
+
+    if (c == '{' || c == '[') { skipDepth = 1; buf++; skipMode = OW_SKIP_NESTED; }
+    else if (c == '"')        { skipInString = true; buf++; skipMode = OW_SKIP_NESTED; }
+    else skipMode = OW_SKIP_SCALAR;
+  }
+
+  // Number, true, false or null, ends at the next delimiter
+  if (skipMode == OW_SKIP_SCALAR) {
+    while (buf < end) {
+      uint8_t c = *buf;
+      if (c == ',' || c == '}' || c == ']' || c <= ' ') { skipMode = OW_SKIP_DONE; break; }
+      buf++;
+    }
+    return buf;
+  }
+
+  // Object, array, string or the rest of an array (OW_SKIP_ARRAY_END)
+  while (buf < end) {
+    if (!skipEscape) {
+      while ((((uintptr_t)buf & 3) == 0) && (end - buf) >= 4) {
+        uint32_t w;
+        memcpy(&w, __builtin_assume_aligned(buf, 4), 4);
+        if (skipInString ? OW_stringByte(w) : OW_structByte(w)) break;
+        buf += 4;
+      }
+      if (buf >= end) break;
+    }
+
+    uint8_t c = *buf++;
+
+    if (skipInString) {
+      if (skipEscape) skipEscape = false;
+      else if (c == '\\') skipEscape = true;
+      else if (c == '"') {
+        skipInString = false;
+        if (skipDepth == 0) { skipMode = OW_SKIP_DONE; break; }
+      }
+    }
+    else if (c == '"') skipInString = true;
+    else if (c == '{' || c == '[') skipDepth++;
+    else if (c == '}' || c == ']') {
+      if (--skipDepth == 0) {
+        // The end of a partly skipped array is left for the parser
+        if (skipMode == OW_SKIP_ARRAY_END) { skipMode = OW_SKIP_OFF; buf--; }
+        else skipMode = OW_SKIP_DONE;
+        break;
+      }
+    }
+  }
+
+  return buf;
+}
+
+/***************************************************************************************
+** Function name:           printReceiveStatus
+** Description:             Report the JSON message bytes received and any bytes skipped
+***************************************************************************************/
+void OW_Weather::printReceiveStatus()
+{
+  // Bytes sent by the server, i.e. before any inflate
+  uint32_t received = bytesReceived;
+#ifdef OW_GZIP
+  if (inflater && inflater->active()) received = bodyRead;
+#endif
+
+  OW_STATUS_PRINTF("\nJSON bytes received: "); OW_STATUS_PRINT(bytesReceived);
+  if (received != bytesReceived) { OW_STATUS_PRINTF(", compressed "); OW_STATUS_PRINT(received); }
+  if (response.contentLength) { OW_STATUS_PRINTF(" of "); OW_STATUS_PRINT(response.contentLength); }
+  OW_STATUS_PRINTF("\n");
+
+  if (dataComplete) {
+    OW_STATUS_PRINTF("All requested data received, connection closed early");
+    if (response.contentLength > received) {
+      OW_STATUS_PRINTF(", "); OW_STATUS_PRINT(response.contentLength - received);
+      OW_STATUS_PRINTF(" bytes not downloaded");
+    }
+    OW_STATUS_PRINTF("\n");
+  }
+}
+
+/***************************************************************************************
+** Description:   Key names in ASCII order, the index is the OW_Key ID in Key_Set.h
+***************************************************************************************/
+static const char OW_keyNames[OW_KEY_COUNT][OW_KEY_LEN] PROGMEM = {
+  "1h", "3h", "alerts", "all", "city", "clouds", "coord", "current", "daily", "day", "deg",
+  "description", "dew_point", "dt", "dt_txt", "eve", "feels_like", "grnd_level",
+  "gust", "hourly", "humidity", "icon", "id", "lat", "list", "lon", "main", "max",
+  "min", "minutely", "moonrise", "moonset", "morn", "name", "night", "pop",
+  "pressure", "rain", "sea_level", "snow", "speed", "sunrise", "sunset", "temp",
+  "temp_max", "temp_min", "timezone", "timezone_offset", "uvi", "visibility",
+  "weather", "wind", "wind_deg", "wind_gust", "wind_speed"
+};
+
+/***************************************************************************************
+** Function name:           keyId
+** Description:             Binary search of the key table, returns the key ID
+***************************************************************************************/
+uint8_t OW_Weather::keyId(const char *key) {
+
+  uint8_t lo = 0;
+  uint8_t hi = OW_KEY_COUNT;
+
+  while (lo < hi) {
+    uint8_t mid = (lo + hi) >> 1;
+    int cmp = strcmp_P(key, OW_keyNames[mid]);
+    if (cmp == 0) return mid;
+    if (cmp < 0) hi = mid;
+    else lo = mid + 1;
+  }
+
+  return OW_KEY_UNKNOWN;
+}
+
+/***************************************************************************************
+** Function name:           wantKey
+** Description:             Check if the value of a key holds a wanted value
+***************************************************************************************/
+// The value is wanted if a descriptor table lists the key, or if it is an object or
+// array that holds a listed value, e.g. "weather" when weather.main is listed. The key
+// masks are made by initSections() so the check is quick.
+bool OW_Weather::wantKey(uint8_t key) {
+
+  // Sketch is using parseRequest() without data sets, so do not skip anything
+  if (dataSetCount == 0 && !slotCallback) return true;
+
+  if (key >= OW_KEY_COUNT) return false;
+
+  uint8_t parent = parentKey();
+
+  // Location values are held by this class
+  if (oneCall) {
+    if (parent == OW_KEY_NONE &&
+       (key == OW_KEY_LAT || key == OW_KEY_LON || key == OW_KEY_TIMEZONE_OFFSET)) return true;
+  }
+  else if (parent == OW_KEY_CITY && (key == OW_KEY_COORD || setKey() == OW_KEY_COORD)) return true;
+
+  // A top level section
+  if (parent == OW_KEY_NONE) return (sectionMask >> key) & 1;
+
+  return (keyMask >> key) & 1;
+}
+
+/***************************************************************************************
+** Function name:           key etc
+** Description:             These functions are called while parsing the JSON message
+***************************************************************************************/
+void OW_Weather::key(const char *key) {
+
+  currentKey = keyId(key);
+
+  // Skip the value if it holds nothing wanted
+  if (!wantKey(currentKey)) {
+    currentKey = OW_KEY_UNKNOWN;
+#ifndef OW_NO_SKIP
+    skipMode = OW_SKIP_KEY;
+#endif
+  }
+
+#ifdef SHOW_CALLBACK
+  Serial.print("\n>>> Key >>>"); Serial.println(key);
+#endif
+}
+
+void OW_Weather::startDocument() {
+
+  currentKey = OW_KEY_NONE;
+  depth = 0;
+  arrayFlags = 0;
   arrayIndex = 0;
-  arrayLevel = 0;
   parseOK = true;
 
-#ifdef SHOW_CALLBACK
-  Serial.print("\n>>> Start document >>>");
-#endif
+  initSections();
+
+#ifdef SHOW_CALLBACK
+  Serial.print("\n>>> Start document >>>");
+#endif
+}
+
+void OW_Weather::endDocument() {
+
+  documentEnd = true;
+  currentKey = OW_KEY_NONE;
+  depth = 0;
+  arrayFlags = 0;
+  arrayIndex = 0;
+
+#ifdef SHOW_CALLBACK
+  Serial.print("\n<<< End document <<<");
+#endif
+}
+
+void OW_Weather::startObject() {
+
+  pushLevel(false);
+
+#ifdef SHOW_CALLBACK
+  Serial.print("\n>>> Start object depth:"); Serial.print(depth);
+  Serial.print(" array index:"); Serial.print(arrayIndex); Serial.print(" >>>");
+#endif
+}
+
+void OW_Weather::endObject() {
+
+  // Closing an element of a top level array, e.g. "list"[n], so move to next slot
+  if (depth == 3 && (arrayFlags & (1 << 1))) {
+    uint8_t section = parentKey();
+    if (slotCallback && (section == OW_KEY_LIST || section == OW_KEY_HOURLY || section == OW_KEY_DAILY)) {
+      slot.section = section;
+      slot.index = arrayIndex;
+      slotCallback(slot);
+    }
+    slot = OW_slot();
+
+    arrayIndex++;
+    slotFilled(section, arrayIndex);
+  }
+
+  // Closing a top level object, e.g. "current"
+  if (depth == 2) sectionDone(parentKey());
+  popLevel();
+
+#ifdef SHOW_CALLBACK
+  Serial.print("\n<<< End object <<<");
+#endif
+}
+
+void OW_Weather::startArray() {
+
+  pushLevel(true);
+
+  // A new top level array, e.g. "hourly", so start at first slot
+  if (depth == 2) {
+    arrayIndex = 0;
+    slot = OW_slot();
+  }
+
+#ifdef SHOW_CALLBACK
+  Serial.print("\n>>> Start array depth:"); Serial.print(depth); Serial.print(" >>>");
+#endif
+}
+
+void OW_Weather::endArray() {
+
+  // Closing a top level array, e.g. "hourly"
+  if (depth == 2) sectionDone(parentKey());
+  popLevel();
+
+#ifdef SHOW_CALLBACK
+  Serial.print("\n<<< End array <<<");
+#endif
+}
+
+/***************************************************************************************
+** Function name:           pushLevel, popLevel
+** Description:             Track the key ID that opened each object or array level
+***************************************************************************************/
+void OW_Weather::pushLevel(bool isArray) {
+
+  if (depth < OW_MAX_DEPTH) {
+    uint8_t id = currentKey;
+
+    // Array members have no key, so they inherit the key of the array
+    if (depth > 0 && (arrayFlags & (1 << (depth - 1)))) id = keyStack[depth - 1];
+    keyStack[depth] = id;
+
+    if (isArray) arrayFlags |=  (1 << depth);
+    else         arrayFlags &= ~(1 << depth);
+  }
+  depth++;
+}
+
+void OW_Weather::popLevel() {
+
+  if (depth > 0) depth--;
+  currentKey = OW_KEY_NONE;
+}
+
+/***************************************************************************************
+** Function name:           initSections
+** Description:             List the top level sections that still hold wanted values
+***************************************************************************************/
+// The sections are taken from the descriptor tables, with the number of array slots
+// wanted. Once every section is complete (and the onecall location values are in)
+// the rest of the message is not needed, so the connection can be closed early.
+void OW_Weather::initSections() {
+
+  sectionCount = 0;
+  rootPending = 0;
+  dataComplete = false;
+  sectionMask = 0;
+  keyMask = 0;
+
+  // Nothing to track if the sketch is using its own listener for parseRequest(), and
+  // every slot is wanted if there is a per slot callback
+  trackSections = (dataSetCount > 0) && !slotCallback;
+  if (dataSetCount == 0 && !slotCallback) return;
+
+  if (oneCall) rootPending = OW_ROOT_LAT | OW_ROOT_LON | OW_ROOT_TIMEZONE;
+  else {
+    addSection(OW_KEY_CITY, 1); // Location values are in the "city" object
+    sectionMask = 1ULL << OW_KEY_CITY;
+  }
+
+  for (uint8_t s = 0; s < dataSetCount; s++) addFields(dataSet[s].fields, dataSet[s].fieldCount);
+
+  if (slotCallback) addFields(OW_slotFields, OW_FIELD_COUNT(OW_slotFields));
+}
+
+/***************************************************************************************
+** Function name:           addFields
+** Description:             Add the sections and keys in a descriptor table
+***************************************************************************************/
+void OW_Weather::addFields(const OW_Field *fields, uint8_t fieldCount) {
+
+  for (uint8_t i = 0; i < fieldCount; i++) {
+    OW_Field field;
+    memcpy_P(&field, &fields[i], sizeof(OW_Field));
+    addSection(field.parent, field.count);
+
+    // Keys with wanted values, used by wantKey() to decide what to skip
+    if (field.parent < OW_KEY_COUNT) sectionMask |= 1ULL << field.parent;
+    if (field.set    < OW_KEY_COUNT) keyMask     |= 1ULL << field.set;
+    if (field.key    < OW_KEY_COUNT) keyMask     |= 1ULL << field.key;
+  }
+}
+
+/***************************************************************************************
+** Function name:           addSection
+** Description:             Add a section to the list, or update the slots wanted
+***************************************************************************************/
+void OW_Weather::addSection(uint8_t key, uint16_t slots) {
+
+  if (key == OW_KEY_NONE) return;
+
+  for (uint8_t i = 0; i < sectionCount; i++) {
+    if (sectionKey[i] == key) {
+      if (slots > sectionSlots[i]) sectionSlots[i] = slots;
+      return;
+    }
+  }
+
+  // Too many sections to track, so read the whole message
+  if (sectionCount >= OW_MAX_SECTIONS) { trackSections = false; return; }
+
+  sectionKey[sectionCount]   = key;
+  sectionSlots[sectionCount] = slots;
+  sectionCount++;
+}
+
+/***************************************************************************************
+** Function name:           slotFilled, sectionDone
+** Description:             Remove completed sections from the list
+***************************************************************************************/
+void OW_Weather::slotFilled(uint8_t key, uint16_t slots) {
+
+  // Slots beyond the struct arrays are still wanted by a per slot callback
+  if (!trackSections) return;
+
+  for (uint8_t i = 0; i < sectionCount; i++) {
+    if (sectionKey[i] == key) {
+      if (slots >= sectionSlots[i]) {
+        sectionDone(key);
+#ifndef OW_NO_SKIP
+        // Skip the remaining array members
+        skipMode = OW_SKIP_ARRAY_END;
+        skipDepth = 1;
+        skipInString = false;
+        skipEscape = false;
+#endif
+      }
+      return;
+    }
+  }
+}
+
+void OW_Weather::sectionDone(uint8_t key) {
+
+  for (uint8_t i = 0; i < sectionCount; i++) {
+    if (sectionKey[i] == key) {
+      sectionCount--;
+      sectionKey[i]   = sectionKey[sectionCount];
+      sectionSlots[i] = sectionSlots[sectionCount];
+      break;
+    }
+  }
+
+  checkComplete();
+}
+
+/***************************************************************************************
+** Function name:           checkComplete
+** Description:             Flag when all wanted values have been received
+***************************************************************************************/
+void OW_Weather::checkComplete() {
+
+  dataComplete = trackSections && (sectionCount == 0) && (rootPending == 0);
+}
+
+void OW_Weather::whitespace(char c) {
+  c = c; // Avoid warning
+}
+
+void OW_Weather::error( const char *message ) {
+  Serial.print("\nParse error message: ");
+  Serial.print(message);
+  parseOK = false;
+}
+
+/***************************************************************************************
+** Description:   Powers of ten that are exact in a float, for the decimal conversion
+***************************************************************************************/
+static const float OW_pow10[] PROGMEM = {
+  1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f
+};
+
+/***************************************************************************************
+** Function name:           toInt
+** Description:             Convert a JSON number string to an integer (no copy)
+***************************************************************************************/
+// Any fraction is truncated, as the String toInt() function did.
+int32_t OW_Weather::toInt(const char *val) {
+
+  bool neg = (*val == '-');
+  if (neg) val++;
+
+  uint32_t n = 0;
+  while (*val >= '0' && *val <= '9') n = n * 10 + (*val++ - '0');
+
+  return neg ? -(int32_t)n : (int32_t)n;
+}
+
+/***************************************************************************************
+** Function name:           toFloat
+** Description:             Convert a JSON number string to a float (no copy)
+***************************************************************************************/
+// The digits are collected as an integer mantissa and scaled with a single float
+// divide. The mantissa (<= 2^24) and the power of ten (<= 1e9) are both exact in a
+// float, so the one correctly rounded divide gives the same result as strtof().
+// Exponent notation and very long numbers fall back to strtof().
+// The float path is kept for float members: a fixed point result would still need the
+// divide by the power of ten to become a float, and an integer divide is a library call
+// too on processors without a hardware divider (ESP8266). Scaled integer members are
+// converted in fixed point, see toScaled().
+float OW_Weather::toFloat(const char *val) {
+
+  const char *start = val;
+  bool neg = (*val == '-');
+  if (neg) val++;
+
+  uint32_t m = 0;
+  uint8_t  digits = 0;
+  uint8_t  frac = 0;
+
+  while (*val >= '0' && *val <= '9') {
+    m = m * 10 + (*val++ - '0');
+    if (++digits > 9) return strtof(start, nullptr);
+  }
+
+  if (*val == '.') {
+    val++;
+    while (*val >= '0' && *val <= '9') {
+      m = m * 10 + (*val++ - '0');
+      frac++;
+      if (++digits > 9) return strtof(start, nullptr);
+    }
+  }
+
+  if (*val != 0 || m > (1UL << 24)) return strtof(start, nullptr);
+
+  float f = (float)m;
+  if (frac) f /= pgm_read_float(&OW_pow10[frac]);
+
+  return neg ? -f : f;
+}
+
+/***************************************************************************************
+** Function name:           toScaled
+** Description:             Convert a JSON number string to a rounded, scaled integer
+***************************************************************************************/
+// The value times 10^shift (shift -1 to 8) in fixed point: the decimal point is moved
+// in the digit string and one more digit kept to round half away from zero, so "1.005"
+// scaled by 100 is exactly 101 (a float multiply gives 100.4999). Exponent notation
+// falls back to the float conversion.
+int32_t OW_Weather::toScaled(const char *val, int8_t shift, int32_t min, int32_t max)
+{
+  const char *start = val;
+  bool neg = (*val == '-');
+  if (neg) val++;
+
+  // n is the value times 10^(shift + 1), truncated, big is set if it does not fit
+  uint32_t n = 0;
+  int8_t   keep = shift + 1; // Fraction digits still wanted
+  bool     big = false;
+  const char *digits = val;
+
+  for (; *val >= '0' && *val <= '9'; val++) {
+    if (n > 429496728) big = true;
+    else n = n * 10 + (*val - '0');
+  }
+
+  if (val != digits && *val == '.') {
+    for (val++; *val >= '0' && *val <= '9'; val++) {
+      if (keep > 0) {
+        if (n > 429496728) big = true;
+        else n = n * 10 + (*val - '0');
+        keep--;
+      }
+    }
+  }
+
+  if (*val != 0 || val == digits) {
+    float f = toFloat(start);
+    for (; shift > 0; shift--) f *= 10.0f;
+    if (shift < 0) f /= 10.0f;
+
+    if (!(f > min)) return min; // Also NaN
+    if (f >= max) return max;
+    return (int32_t)(f < 0 ? f - 0.5f : f + 0.5f);
+  }
+
+  for (; keep > 0; keep--) {
+    if (n > 429496729) big = true;
+    else n *= 10;
+  }
+
+  // Round, then apply the sign and limits
+  n = (n + 5) / 10;
+  if (neg) return (big || n > (uint32_t)-(int64_t)min) ? min : (int32_t)-(int64_t)n;
+  return (big || n > (uint32_t)max) ? max : (int32_t)n;
+}
+
+/***************************************************************************************
+** Function name:           value
+** Description:             Stores the parsed data in the structures for sketch access
+***************************************************************************************/
+void OW_Weather::value(const char *val)
+{
+  uint8_t parent = parentKey();
+
+  // Location values are held by this class
+  if (oneCall) {
+    if (parent == OW_KEY_NONE) {
+      switch (currentKey) {
+        case OW_KEY_LAT:             lat = toFloat(val); rootPending &= ~OW_ROOT_LAT; break;
+        case OW_KEY_LON:             lon = toFloat(val); rootPending &= ~OW_ROOT_LON; break;
+        case OW_KEY_TIMEZONE_OFFSET: timezone = val;     rootPending &= ~OW_ROOT_TIMEZONE; break;
+      }
+      checkComplete();
+      return;
+    }
+  }
+  else if (parent == OW_KEY_CITY && setKey() == OW_KEY_COORD) {
+    switch (currentKey) {
+      case OW_KEY_LAT: lat = toFloat(val); break;
+      case OW_KEY_LON: lon = toFloat(val); break;
+    }
+    return;
+  }
+
+  OW_Field field;
+  bool inArray = (depth > 1 && (arrayFlags & (1 << 1)));
+
+  // Values for the per slot callback record
+  if (slotCallback && inArray &&
+      findField(OW_slotFields, OW_FIELD_COUNT(OW_slotFields), parent, field)) {
+    storeField(&slot, field, 0, val);
+  }
+
+  // Find the descriptor for the value and store it in the struct
+  for (uint8_t s = 0; s < dataSetCount; s++) {
+    if (!findField(dataSet[s].fields, dataSet[s].fieldCount, parent, field)) continue;
+
+    // Values in a top level array, e.g. "list", are stored in the matching slot,
+    // slots beyond the member array size are dropped
+    uint16_t index = inArray ? arrayIndex : 0;
+    if (index < field.count) storeField(dataSet[s].data, field, index, val);
+    return;
+  }
+}
+
+/***************************************************************************************
+** Function name:           findField
+** Description:             Find the descriptor for the current value in a table
+***************************************************************************************/
+bool OW_Weather::findField(const OW_Field *fields, uint8_t fieldCount, uint8_t parent, OW_Field &field)
+{
+  for (uint8_t i = 0; i < fieldCount; i++) {
+    if (pgm_read_byte(&fields[i].key) != currentKey) continue;
+
+    memcpy_P(&field, &fields[i], sizeof(OW_Field));
+    if (field.parent == parent && field.set == setKey()) return true;
+  }
+
+  return false;
+}
+
+/***************************************************************************************
+** Function name:           storeField
+** Description:             Store a value in slot index of a struct member
+***************************************************************************************/
+void OW_Weather::storeField(void *data, const OW_Field &field, uint16_t index, const char *val)
+{
+  uint8_t *member = (uint8_t *)data + field.offset;
+
+  if (field.type == OW_BIT) storeNight(member, index, val);
+  else storeValue(member + index * field.size, field.type, val);
+}
+
+/***************************************************************************************
+** Function name:           storeValue
+** Description:             Convert and store a value of the given type
+***************************************************************************************/
+void OW_Weather::storeValue(void *member, uint8_t type, const char *val)
+{
+  switch (type) {
+    case OW_U8:  *(uint8_t  *)member = (uint8_t)toInt(val);  break;
+    case OW_U16: *(uint16_t *)member = (uint16_t)toInt(val); break;
+    case OW_U32: *(uint32_t *)member = (uint32_t)toInt(val); break;
+    case OW_I32: *(int32_t  *)member = toInt(val);           break;
+    case OW_F32: *(float    *)member = toFloat(val);         break;
+    case OW_STR: *(String   *)member = val;                  break;
+
+    // Scaled integers, rounded and limited to the type range
+    case OW_I16_X100: *(int16_t  *)member = (int16_t)toScaled(val, 2, -32768, 32767); break;
+    case OW_U8_X100:  *(uint8_t  *)member = (uint8_t)toScaled(val, 2, 0, 255);        break;
+    case OW_U16_DIV10: *(uint16_t *)member = (uint16_t)toScaled(val, -1, 0, 65535);      break;
+
+    // Text is held in the arena, "" if there is no arena or it is full
+    case OW_TEXT: {
+      const char *text = arena ? arena->intern(val) : nullptr;
+      *(const char **)member = text ? text : "";
+      break;
+    }
+  }
+}
+
+/***************************************************************************************
+** Function name:           storeNight
+** Description:             Set the day/night bit for a slot from the weather icon name
+***************************************************************************************/
+// Icon names end in "d" for day or "n" for night, e.g. "10n"
+void OW_Weather::storeNight(uint8_t *night, uint16_t index, const char *val)
+{
+  uint8_t mask = 1 << (index & 7);
+  night += index >> 3;
+
+  size_t len = strlen(val);
+  if (len && val[len - 1] == 'n') *night |= mask;
+  else *night &= ~mask;
+}
+
+/***************************************************************************************
+** Function name:           printDataSet
+** Description:             Print struct values to serial port using descriptor table
+***************************************************************************************/
+void OW_Weather::printDataSet(const void *data, const OW_Field *fields, uint8_t fieldCount)
+{
+  if (!data) return;
+
+  // Single values first, then the array values slot by slot
+  uint8_t slots = 0;
+  for (uint8_t i = 0; i < fieldCount; i++) {
+    OW_Field field;
+    memcpy_P(&field, &fields[i], sizeof(OW_Field));
+    if (field.count == 1) printField(data, field, 0);
+    else if (field.count > slots) slots = field.count;
+  }
+
+  for (uint8_t n = 0; n < slots; n++) {
+    bool header = false;
+    for (uint8_t i = 0; i < fieldCount; i++) {
+      OW_Field field;
+      memcpy_P(&field, &fields[i], sizeof(OW_Field));
+      if (field.count == 1 || n >= field.count) continue;
+      if (!header) {
+        Serial.println();
+        Serial.print((const __FlashStringHelper *)OW_keyNames[field.parent]);
+        Serial.print(' '); Serial.println(n);
+        header = true;
+      }
+      printField(data, field, n);
+    }
+  }
+  Serial.println();
+}
+
+/***************************************************************************************
+** Function name:           printField
+** Description:             Print "set.key : value" for one struct value
+***************************************************************************************/
+void OW_Weather::printField(const void *data, const OW_Field &field, uint8_t index)
+{
+  uint8_t len = 0;
+
+  if (field.set != field.parent) {
+    Serial.print((const __FlashStringHelper *)OW_keyNames[field.set]);
+    Serial.print('.');
+    len = strlen_P(OW_keyNames[field.set]) + 1;
+  }
+  Serial.print((const __FlashStringHelper *)OW_keyNames[field.key]);
+  len += strlen_P(OW_keyNames[field.key]);
+
+  while (len++ < 20) Serial.print(' ');
+  Serial.print(": ");
+
+  if (field.type == OW_BIT) {
+    Serial.println(OW_isNight((const uint8_t *)data + field.offset, index) ? "night" : "day");
+    return;
+  }
+
+  const uint8_t *member = (const uint8_t *)data + field.offset + index * field.size;
+  switch (field.type) {
+    case OW_U8:  Serial.println(*(const uint8_t  *)member); break;
+    case OW_U16: Serial.println(*(const uint16_t *)member); break;
+    case OW_U32: Serial.println(*(const uint32_t *)member); break;
+    case OW_I32: Serial.println(*(const int32_t  *)member); break;
+    case OW_F32: Serial.println(*(const float    *)member); break;
+    case OW_STR: Serial.println(*(const String   *)member); break;
+
+    case OW_I16_X100:  Serial.println(*(const int16_t  *)member * 0.01f); break;
+    case OW_U8_X100:   Serial.println(*(const uint8_t  *)member * 0.01f); break;
+    case OW_U16_DIV10: Serial.println(*(const uint16_t *)member * 10UL);  break;
+    case OW_TEXT:      Serial.println(*(const char * const *)member);        break;
+  }
+}
+
+/***************************************************************************************
+** Description:   Weather condition table, English text for each weather id
+***************************************************************************************/
+// See https://openweathermap.org/weather-conditions, the table is in id order for the
+// binary search. The main text is an index into OW_conditionMains[] and the icon is
+// the icon number, the "d" or "n" suffix is added from the day/night bit.
+typedef struct OW_Condition {
+  uint16_t id;
+  uint8_t  main;
+  uint8_t  icon;
+  char     description[32];
+} OW_Condition;
+
+static const char OW_conditionMains[][13] PROGMEM = {
+  "Thunderstorm", "Drizzle", "Rain", "Snow", "Mist", "Smoke", "Haze", "Dust", "Fog",
+  "Sand", "Ash", "Squall", "Tornado", "Clear", "Clouds"
+};
+
+enum { OW_THUNDERSTORM = 0, OW_DRIZZLE, OW_RAIN, OW_SNOW, OW_MIST, OW_SMOKE, OW_HAZE,
+       OW_DUST, OW_FOG, OW_SAND, OW_ASH, OW_SQUALL, OW_TORNADO, OW_CLEAR, OW_CLOUDS };
+
+static const OW_Condition OW_conditions[] PROGMEM = {
+  { 200, OW_THUNDERSTORM, 11, "thunderstorm with light rain" },
+  { 201, OW_THUNDERSTORM, 11, "thunderstorm with rain" },
+  { 202, OW_THUNDERSTORM, 11, "thunderstorm with heavy rain" },
+  { 210, OW_THUNDERSTORM, 11, "light thunderstorm" },
+  { 211, OW_THUNDERSTORM, 11, "thunderstorm" },
+  { 212, OW_THUNDERSTORM, 11, "heavy thunderstorm" },
+  { 221, OW_THUNDERSTORM, 11, "ragged thunderstorm" },
+  { 230, OW_THUNDERSTORM, 11, "thunderstorm with light drizzle" },
+  { 231, OW_THUNDERSTORM, 11, "thunderstorm with drizzle" },
+  { 232, OW_THUNDERSTORM, 11, "thunderstorm with heavy drizzle" },
+
+  { 300, OW_DRIZZLE,  9, "light intensity drizzle" },
+  { 301, OW_DRIZZLE,  9, "drizzle" },
+  { 302, OW_DRIZZLE,  9, "heavy intensity drizzle" },
+  { 310, OW_DRIZZLE,  9, "light intensity drizzle rain" },
+  { 311, OW_DRIZZLE,  9, "drizzle rain" },
+  { 312, OW_DRIZZLE,  9, "heavy intensity drizzle rain" },
+  { 313, OW_DRIZZLE,  9, "shower rain and drizzle" },
+  { 314, OW_DRIZZLE,  9, "heavy shower rain and drizzle" },
+  { 321, OW_DRIZZLE,  9, "shower drizzle" },
+
+  { 500, OW_RAIN, 10, "light rain" },
+  { 501, OW_RAIN, 10, "moderate rain" },
+  { 502, OW_RAIN, 10, "heavy intensity rain" },
+  { 503, OW_RAIN, 10, "very heavy rain" },
+  { 504, OW_RAIN, 10, "extreme rain" },
+  { 511, OW_RAIN, 13, "freezing rain" },
+  { 520, OW_RAIN,  9, "light intensity shower rain" },
+  { 521, OW_RAIN,  9, "shower rain" },
+  { 522, OW_RAIN,  9, "heavy intensity shower rain" },
+  { 531, OW_RAIN,  9, "ragged shower rain" },
+
+  { 600, OW_SNOW, 13, "light snow" },
+  { 601, OW_SNOW, 13, "snow" },
+  { 602, OW_SNOW, 13, "heavy snow" },
+  { 611, OW_SNOW, 13, "sleet" },
+  { 612, OW_SNOW, 13, "light shower sleet" },
+  { 613, OW_SNOW, 13, "shower sleet" },
+  { 615, OW_SNOW, 13, "light rain and snow" },
+  { 616, OW_SNOW, 13, "rain and snow" },
+  { 620, OW_SNOW, 13, "light shower snow" },
+  { 621, OW_SNOW, 13, "shower snow" },
+  { 622, OW_SNOW, 13, "heavy shower snow" },
+
+  { 701, OW_MIST,    50, "mist" },
+  { 711, OW_SMOKE,   50, "smoke" },
+  { 721, OW_HAZE,    50, "haze" },
+  { 731, OW_DUST,    50, "sand/dust whirls" },
+  { 741, OW_FOG,     50, "fog" },
+  { 751, OW_SAND,    50, "sand" },
+  { 761, OW_DUST,    50, "dust" },
+  { 762, OW_ASH,     50, "volcanic ash" },
+  { 771, OW_SQUALL,  50, "squalls" },
+  { 781, OW_TORNADO, 50, "tornado" },
+
+  { 800, OW_CLEAR,  1, "clear sky" },
+  { 801, OW_CLOUDS, 2, "few clouds" },
+  { 802, OW_CLOUDS, 3, "scattered clouds" },
+  { 803, OW_CLOUDS, 4, "broken clouds" },
+  { 804, OW_CLOUDS, 4, "overcast clouds" },
+};
+
+/***************************************************************************************
+** Function name:           findCondition
+** Description:             Binary search of the condition table, nullptr if not found
+***************************************************************************************/
+static const OW_Condition *findCondition(uint16_t id)
+{
+  uint8_t lo = 0;
+  uint8_t hi = sizeof(OW_conditions) / sizeof(OW_Condition);
+
+  while (lo < hi) {
+    uint8_t mid = (lo + hi) >> 1;
+    uint16_t midId = pgm_read_word(&OW_conditions[mid].id);
+    if (midId == id) return &OW_conditions[mid];
+    if (id < midId) hi = mid;
+    else lo = mid + 1;
+  }
+
+  return nullptr;
+}
+
+/***************************************************************************************
+** Function name:           conditionMain, conditionDescription, conditionIcon
+** Description:             Weather condition text for a weather id, "" if not known
+***************************************************************************************/
+const __FlashStringHelper *OW_Weather::conditionMain(uint16_t id)
+{
+  const OW_Condition *condition = findCondition(id);
+  if (!condition) return F("");
+
+  return (const __FlashStringHelper *)OW_conditionMains[pgm_read_byte(&condition->main)];
+}
+
+const __FlashStringHelper *OW_Weather::conditionDescription(uint16_t id)
+{
+  const OW_Condition *condition = findCondition(id);
+  if (!condition) return F("");
+
+  return (const __FlashStringHelper *)condition->description;
+}
+
+// Icon name as sent by the server, e.g. "10n", the text is held until the next call
+const char *OW_Weather::conditionIcon(uint16_t id, bool night)
+{
+  static char icon[4];
+  icon[0] = 0;
+
+  const OW_Condition *condition = findCondition(id);
+  if (!condition) return icon;
+
+  uint8_t n = pgm_read_byte(&condition->icon);
+  icon[0] = '0' + n / 10;
+  icon[1] = '0' + n % 10;
+  icon[2] = night ? 'n' : 'd';
+  icon[3] = 0;
+
+  return icon;
+}
+
+/***************************************************************************************
+** Function name:           OW_Arena
+** Description:             Constructors, take the arena memory once
+***************************************************************************************/
+OW_Arena::OW_Arena(size_t size) {
+
+  base = (uint8_t *)malloc(size);
+  capacity = base ? size : 0;
+  owned = true;
+  peak = 0;
+  reset();
+}
+
+OW_Arena::OW_Arena(void *buffer, size_t size) {
+
+  base = (uint8_t *)buffer;
+  capacity = base ? size : 0;
+  owned = false;
+  peak = 0;
+  reset();
+}
+
+OW_Arena::~OW_Arena() {
+
+  if (owned) free(base);
+}
+
+/***************************************************************************************
+** Function name:           reset
+** Description:             Discard all structs and text, the memory is kept
+***************************************************************************************/
+void OW_Arena::reset() {
+
+  top = 0;
+  for (uint8_t i = 0; i < OW_ARENA_BUCKETS; i++) bucket[i] = 0;
+}
+
+/***************************************************************************************
+** Function name:           alloc
+** Description:             Reserve aligned memory in the arena
+***************************************************************************************/
+void *OW_Arena::alloc(size_t size, size_t align) {
+
+  // Align relative to the address as a sketch buffer may not be aligned
+  size_t start = top + (-(uintptr_t)(base + top) & (align - 1));
+  if (start > capacity || size > capacity - start) return nullptr;
+
+  top = start + size;
+  if (top > peak) peak = top;
+
+  return base + start;
+}
+
+/***************************************************************************************
+** Function name:           intern
+** Description:             Copy text into the arena, sharing identical text
+***************************************************************************************/
+// Each text is stored after the offset + 1 of the next text in the same hash chain.
+// The server sends the same few weather descriptions for many slots so each is only
+// stored once.
+const char *OW_Arena::intern(const char *text) {
+
+  // FNV-1a hash of the text
+  uint32_t hash = 2166136261UL;
+  size_t len = 0;
+  for (const char *p = text; *p; p++, len++) hash = (hash ^ (uint8_t)*p) * 16777619UL;
+  uint8_t b = hash % OW_ARENA_BUCKETS;
+
+  for (size_t entry = bucket[b]; entry; ) {
+    size_t *next = (size_t *)(base + entry - 1);
+    const char *stored = (const char *)(next + 1);
+    if (strcmp(stored, text) == 0) return stored;
+    entry = *next;
+  }
+
+  size_t *next = (size_t *)alloc(sizeof(size_t) + len + 1, sizeof(size_t));
+  if (!next) return nullptr;
+
+  *next = bucket[b];
+  bucket[b] = (uint8_t *)next - base + 1;
+
+  char *stored = (char *)(next + 1);
+  memcpy(stored, text, len + 1);
+
+  return stored;
 }
 
-void OW_Weather::endDocument() {
+/***************************************************************************************
+** Function name:           OW_RequestBuilder
+** Description:             Constructor, the buffer holds an empty string
+***************************************************************************************/
+OW_RequestBuilder::OW_RequestBuilder(char *buffer, size_t size)
+{
+  buf = buffer;
+  this->size = size;
+  len = 0;
+  overflow = size == 0;
+  if (size) buf[0] = 0;
+}
 
-  currentParent = currentKey = "";
-  objectLevel = 0;
-  valuePath = "";
-  arrayIndex = 0;
-  arrayLevel = 0;
+/***************************************************************************************
+** Function name:           add, addEncoded, addNumber
+** Description:             Add text to the buffer, dropped if it does not fit
+***************************************************************************************/
+OW_RequestBuilder &OW_RequestBuilder::add(char c)
+{
+  // Once text is dropped nothing more is added, so a later short text can not follow it
+  if (overflow || len + 1 >= size) {
+    overflow = true;
+    return *this;
+  }
 
-#ifdef SHOW_CALLBACK
-  Serial.print("\n<<< End document <<<");
-#endif
+  buf[len++] = c;
+  buf[len] = 0;
+  return *this;
 }
 
-void OW_Weather::startObject() {
+OW_RequestBuilder &OW_RequestBuilder::add(const char *text)
+{
+  size_t n = strlen(text);
+  if (overflow || len + n >= size) {
+    overflow = true;
+    return *this;
+  }
+
+  memcpy(buf + len, text, n + 1);
+  len += n;
+  return *this;
+}
 
-  if (arrayIndex == 0 && objectLevel == 1) currentParent = currentKey;
-  currentSet = currentKey;
-  objectLevel++;
+// Characters other than letters, digits and -._~ are sent as % and two hex digits
+OW_RequestBuilder &OW_RequestBuilder::addEncoded(const char *text)
+{
+  static const char hex[] = "0123456789ABCDEF";
 
-#ifdef SHOW_CALLBACK
-  Serial.print("\n>>> Start object level:" + (String) objectLevel + " array level:" + (String) arrayLevel + " array index:" + (String) arrayIndex +" >>>");
-#endif
+  for (const uint8_t *c = (const uint8_t *)text; *c; c++) {
+    if (isalnum(*c) || *c == '-' || *c == '.' || *c == '_' || *c == '~') add((char)*c);
+    else add('%').add(hex[*c >> 4]).add(hex[*c & 0xF]);
+  }
+  return *this;
 }
 
-void OW_Weather::endObject() {
+OW_RequestBuilder &OW_RequestBuilder::addNumber(float value, uint8_t decimals)
+{
+  if (decimals > 9) decimals = 9;
+  uint32_t scale = 1;
+  for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+
+  // Rounded to the decimal places, in double so the last place is right. Numbers too
+  // big, infinity and not a number (the comparison is false) are dropped
+  bool neg = value < 0;
+  double scaled = (neg ? -(double)value : (double)value) * scale + 0.5;
+  if (!(scaled < 4294967295.0)) {
+    overflow = true;
+    return *this;
+  }
 
-  if (arrayLevel == 0) currentParent = "";
-  if (arrayLevel == 1  && objectLevel == 2) arrayIndex++;
-  objectLevel--;
-  
+  // No sign for a value that rounds to zero, e.g. -0.00001 is "0.0000"
+  uint32_t n = (uint32_t)scaled;
+  if (neg && n) add('-');
+  char digits[11];
+  uint8_t count = 0;
+  do {
+    digits[count++] = '0' + n % 10;
+    n /= 10;
+  } while (n || count <= decimals);
+
+  while (count) {
+    if (count == decimals) add('.');
+    add(digits[--count]);
+  }
+  return *this;
+}
 
-#ifdef SHOW_CALLBACK
-  Serial.print("\n<<< End object <<<");
+/***************************************************************************************
+** Function name:           OW_Coordinate setNumber
+** Description:             Latitude or longitude as text with 4 decimal places
+***************************************************************************************/
+void OW_Coordinate::setNumber(float value)
+{
+  OW_RequestBuilder(number, sizeof(number)).addNumber(value, 4);
+}
+
+/***************************************************************************************
+** Function name:           OW_DnsCache
+** Description:             Constructor, nullptr selects the built in resolver
+***************************************************************************************/
+#ifdef OW_POSIX_CLIENT
+static bool OW_hostByName(const char *host, IPAddress &ip)
+{
+  struct addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+
+  struct addrinfo *list;
+  if (getaddrinfo(host, nullptr, &hints, &list) != 0) return false;
+
+  const uint8_t *a = (const uint8_t *)&((struct sockaddr_in *)list->ai_addr)->sin_addr;
+  ip = IPAddress(a[0], a[1], a[2], a[3]);
+  freeaddrinfo(list);
+  return true;
+}
+#else
+static bool OW_hostByName(const char *host, IPAddress &ip)
+{
+  return WiFi.hostByName(host, ip) == 1;
+}
 #endif
+
+OW_DnsCache::OW_DnsCache(OW_Resolver resolver, uint32_t ttl)
+{
+  this->resolver = resolver ? resolver : OW_hostByName;
+  this->ttl = ttl;
 }
 
-void OW_Weather::startArray() {
+/***************************************************************************************
+** Function name:           resolve, find
+** Description:             Get the address of a host name
+***************************************************************************************/
+bool OW_DnsCache::resolve(const char *host, IPAddress &ip)
+{
+  if (find(host, ip)) return true;
+
+  lookups++;
+  if (!resolver(host, ip)) return false;
+
+  // Names too long for an entry are looked up every time
+  if (strlen(host) >= OW_DNS_HOST_SIZE) return true;
+
+  // Reuse the entry for the name, or an unused one, or the oldest
+  uint32_t now = millis();
+  OW_DnsEntry *e = entry(host);
+  if (!e) {
+    e = entries;
+    for (OW_DnsEntry &n : entries) {
+      if (!n.host[0]) { e = &n; break; }
+      if (now - n.time > now - e->time) e = &n;
+    }
+  }
+
+  strcpy(e->host, host);
+  e->ip = ip;
+  e->time = now;
+  return true;
+}
 
-  arrayLevel++;
-  valuePath = currentParent + "/" + currentKey; // aka = current Object, e.g. "daily:data"
+bool OW_DnsCache::find(const char *host, IPAddress &ip)
+{
+  OW_DnsEntry *e = entry(host);
+  if (!e || millis() - e->time >= ttl) return false;
 
-#ifdef SHOW_CALLBACK
-  Serial.print("\n>>> Start array " + valuePath + "/" + (String) arrayLevel + "/" + (String) arrayIndex +" >>>");
+  hits++;
+  ip = e->ip;
+  return true;
+}
+
+/***************************************************************************************
+** Function name:           invalidate, clear, entry
+** Description:             Forget cached addresses, find the entry for a name
+***************************************************************************************/
+void OW_DnsCache::invalidate(const char *host)
+{
+  OW_DnsEntry *e = entry(host);
+  if (e) e->host[0] = 0;
+}
+
+void OW_DnsCache::clear()
+{
+  for (OW_DnsEntry &e : entries) e.host[0] = 0;
+}
+
+OW_DnsCache::OW_DnsEntry *OW_DnsCache::entry(const char *host)
+{
+  for (OW_DnsEntry &e : entries) {
+    if (e.host[0] && strcmp(e.host, host) == 0) return &e;
+  }
+  return nullptr;
+}
+
+#ifdef OW_POSIX_CLIENT
+/***************************************************************************************
+** Function name:           connect
+** Description:             Connect a TCP socket, returns 1 if connected
+***************************************************************************************/
+int OW_PosixClient::connect(IPAddress ip, uint16_t port)
+{
+  char host[16];
+  snprintf(host, sizeof(host), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  return connect(host, port);
+}
+
+int OW_PosixClient::connect(const char *host, uint16_t port)
+{
+  stop();
+
+  char service[6];
+  snprintf(service, sizeof(service), "%u", port);
+
+  struct addrinfo hints = {};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  struct addrinfo *list;
+  if (getaddrinfo(host, service, &hints, &list) != 0) return 0;
+
+  // The connect does not block, it is given up after the Stream timeout, which the
+  // library sets to the connect timeout
+  for (struct addrinfo *a = list; a && fd < 0; a = a->ai_next) {
+    fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+    if (fd < 0) continue;
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int result = ::connect(fd, a->ai_addr, a->ai_addrlen);
+    if (result != 0 && errno == EINPROGRESS) {
+      struct pollfd p = { fd, POLLOUT, 0 };
+      int error = 0;
+      socklen_t size = sizeof(error);
+      if (poll(&p, 1, (int)getTimeout()) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &size) == 0 &&
+          error == 0) result = 0;
+    }
+    fcntl(fd, F_SETFL, flags);
+
+    if (result != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  freeaddrinfo(list);
+  if (fd < 0) return 0;
+
+  // The request is sent in one write, so do not hold it back
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
 #endif
+
+  return 1;
 }
 
-void OW_Weather::endArray() {
-  if (arrayLevel > 0) arrayLevel--;
-  if (arrayLevel == 0) arrayIndex = 0;
-  valuePath = "";
+/***************************************************************************************
+** Function name:           write
+** Description:             Send bytes, returns the number sent
+***************************************************************************************/
+size_t OW_PosixClient::write(const uint8_t *buf, size_t size)
+{
+  size_t sent = 0;
 
-#ifdef SHOW_CALLBACK
-  Serial.print("\n<<< End array <<<");
+  while (fd >= 0 && sent < size) {
+#ifdef MSG_NOSIGNAL
+    ssize_t n = send(fd, buf + sent, size - sent, MSG_NOSIGNAL);
+#else
+    ssize_t n = send(fd, buf + sent, size - sent, 0);
 #endif
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    sent += n;
+  }
+
+  return sent;
 }
 
-void OW_Weather::whitespace(char c) {
-  c = c; // Avoid warning
+/***************************************************************************************
+** Function name:           available, read, peek
+** Description:             Read bytes that have arrived, without blocking
+***************************************************************************************/
+int OW_PosixClient::bytesWaiting()
+{
+  int n = 0;
+  if (fd < 0 || ioctl(fd, FIONREAD, &n) != 0) return 0;
+  return n;
 }
 
-void OW_Weather::error( const char *message ) {
-  Serial.print("\nParse error message: ");
-  Serial.print(message);
-  parseOK = false;
+// Like the WiFi clients, which yield in available(), a short wait stops polling loops
+// using all the processor time
+int OW_PosixClient::available()
+{
+  int n = bytesWaiting();
+  if (n > 0 || fd < 0) return n;
+
+  struct pollfd p = { fd, POLLIN, 0 };
+  if (::poll(&p, 1, 1) > 0) n = bytesWaiting();
+  return n;
+}
+
+int OW_PosixClient::read()
+{
+  uint8_t c;
+  return (read(&c, 1) == 1) ? c : -1;
+}
+
+int OW_PosixClient::read(uint8_t *buf, size_t size)
+{
+  if (fd < 0) return -1;
+
+  ssize_t n = recv(fd, buf, size, MSG_DONTWAIT);
+  return (n > 0) ? (int)n : -1;
+}
+
+int OW_PosixClient::peek()
+{
+  uint8_t c;
+  if (fd < 0 || recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) != 1) return -1;
+  return c;
 }
 
 /***************************************************************************************
-** Function name:           value (full or partial data set)
-** Description:             Stores the parsed data in the structures for sketch access
+** Function name:           stop, connected
+** Description:             Close the socket, check the connection is open
 ***************************************************************************************/
-void OW_Weather::value(const char *val)
+void OW_PosixClient::stop()
 {
-  if (oneCall) {
-    if (!partialSet) fullDataSet(val);
-    else partialDataSet(val);
-  }
-  else {
-    forecastDataSet(val);
-  }
-}
-
-/***************************************************************************************
-** Function name:           fullDataSet
-** Description:             Collects full data set
-***************************************************************************************/
-void OW_Weather::fullDataSet(const char *val) {
-
-   String value = val;
-
-  // Start of JSON
-  if (currentParent == "") {
-    if (currentKey == "lat") lat = value.toFloat();
-    if (currentKey == "lon") lon = value.toFloat();
-    if (currentKey == "timezone_offset") timezone = value;
-  }
-
-  // Current forecast - no array index - short path
-  if (currentParent == "current") {
-    data_set = "current";
-    if (currentKey == "dt") current->dt = (uint32_t)value.toInt();
-    else
-    if (currentKey == "sunrise") current->sunrise = (uint32_t)value.toInt();
-    else
-    if (currentKey == "sunset") current->sunset = (uint32_t)value.toInt();
-    else
-    if (currentKey == "temp") current->temp = value.toFloat();
-    else
-    if (currentKey == "feels_like") current->feels_like = value.toFloat();
-    else
-    if (currentKey == "pressure") current->pressure = value.toFloat();
-    else
-    if (currentKey == "humidity") current->humidity = value.toInt();
-    else
-    if (currentKey == "dew_point") current->dew_point = value.toFloat();
-    else
-    if (currentKey == "uvi") current->uvi = value.toFloat();
-    else
-    if (currentKey == "clouds") current->clouds = value.toInt();
-    else
-    if (currentKey == "visibility") current->visibility = value.toInt();
-    else
-    if (currentKey == "wind_speed") current->wind_speed = value.toFloat();
-    else
-    if (currentKey == "wind_gust") current->wind_gust = value.toFloat();
-    else
-    if (currentKey == "wind_deg") current->wind_deg = (uint16_t)value.toInt();
-    else
-    if (currentKey == "rain") current->rain = value.toFloat();
-    else
-    if (currentKey == "snow") current->snow = value.toFloat();
-    else
-
-    if (currentKey == "id") current->id = value.toInt();
-    else
-    if (currentKey == "main") current->main = value;
-    else
-    if (currentKey == "description") current->description = value;
-    else
-    if (currentKey == "icon") current->icon = value;
+  if (fd < 0) return;
 
-    return;
+  close(fd);
+  fd = -1;
+}
+
+// Still connected while received bytes are waiting, even if the server has closed
+uint8_t OW_PosixClient::connected()
+{
+  if (fd < 0) return 0;
+  if (bytesWaiting() > 0) return 1;
+
+  uint8_t c;
+  ssize_t n = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n == 0) return 0;  // Closed by the server
+  return (n > 0 || errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 1 : 0;
+}
+#endif // OW_POSIX_CLIENT
+
+#ifdef OW_WORKER
+/***************************************************************************************
+** Function name:           forecast, oneCall
+** Description:             Set up the request of a background fetch job
+***************************************************************************************/
+void OW_Job::forecast(OW_DataSet forecast, String api_key, String latitude, String longitude,
+                      String units, String language, bool secure)
+{
+  set[0] = forecast;
+  set[1] = OW_dataSet();
+  set[2] = OW_dataSet();
+  oneCallApi = false;
+  apiKey = api_key;
+  lat = latitude;
+  lon = longitude;
+  this->units = units;
+  this->language = language;
+  this->secure = secure;
+  doubleBuffer = nullptr;
+  publish = nullptr;
+}
+
+void OW_Job::oneCall(OW_DataSet current, OW_DataSet hourly, OW_DataSet daily,
+                     String api_key, String latitude, String longitude,
+                     String units, String language, bool secure)
+{
+  forecast(current, api_key, latitude, longitude, units, language, secure);
+  set[1] = hourly;
+  set[2] = daily;
+  oneCallApi = true;
+}
+
+/***************************************************************************************
+** Function name:           wait
+** Description:             Wait for the job to finish, returns false on timeout
+***************************************************************************************/
+bool OW_Job::wait(uint32_t timeout)
+{
+  uint32_t start = millis();
+
+  while (!finished()) {
+    if ((millis() - start) >= timeout) return false;
+    delay(1);
   }
 
-  // Hourly forecast
-  if (currentParent == "hourly") {
-    data_set = "hourly";
-    
-    if (arrayIndex >= MAX_HOURS) return;
-    
-    if (currentKey == "dt") hourly->dt[arrayIndex] = (uint32_t)value.toInt();
-    else
-    if (currentKey == "temp") hourly->temp[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "feels_like") hourly->feels_like[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "pressure") hourly->pressure[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "humidity") hourly->humidity[arrayIndex] = value.toInt();
-    else
-    if (currentKey == "dew_point") hourly->dew_point[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "clouds") hourly->clouds[arrayIndex] = value.toInt();
-    else
-    if (currentKey == "wind_speed") hourly->wind_speed[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "wind_gust") hourly->wind_gust[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "wind_deg") hourly->wind_deg[arrayIndex] = (uint16_t)value.toInt();
-    else
-    if (currentKey == "rain") hourly->rain[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "snow") hourly->snow[arrayIndex] = value.toFloat();
-    else
-
-    if (currentKey == "id") hourly->id[arrayIndex] = value.toInt();
-    else
-    if (currentKey == "main") hourly->main[arrayIndex] = value;
-    else
-    if (currentKey == "description") hourly->description[arrayIndex] = value;
-    else
-    if (currentKey == "icon") hourly->icon[arrayIndex] = value;
-    else
-    if (currentKey == "pop") hourly->pop[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "1h") hourly->rain1h[arrayIndex] = value.toFloat();
+  return true;
+}
 
-    return;
+/***************************************************************************************
+** Function name:           begin, end
+** Description:             Start and stop the worker
+***************************************************************************************/
+bool OW_Worker::begin(uint8_t queueLength)
+{
+  if (started) return true;
+
+  // Jobs usually go to the same server, so the connection is kept open between them
+  ow.keepAlive(true);
+
+#ifdef OW_WORKER_FREERTOS
+  queue = xQueueCreate(queueLength, sizeof(OW_Job *));
+  if (!queue) return false;
+
+  running = true;
+  BaseType_t core = (OW_WORKER_CORE < portNUM_PROCESSORS) ? OW_WORKER_CORE : tskNO_AFFINITY;
+  if (xTaskCreatePinnedToCore(task, "OW_Worker", OW_WORKER_STACK, this,
+                              OW_WORKER_PRIORITY, nullptr, core) != pdPASS) {
+    running = false;
+    vQueueDelete(queue);
+    queue = nullptr;
+    return false;
   }
+#else
+  queueSize = queueLength;
+  thread = std::thread([this] { run(); });
+#endif
 
+  started = true;
+  return true;
+}
 
-  // Daily forecast
-  if (currentParent == "daily") {
-    data_set = "daily";
-    
-    if (arrayIndex >= MAX_DAYS) return;
-    
-    if (currentKey == "dt") daily->dt[arrayIndex] = (uint32_t)value.toInt();
-    else
-    if (currentKey == "sunrise") daily->sunrise[arrayIndex] = (uint32_t)value.toInt();
-    else
-    if (currentKey == "sunset") daily->sunset[arrayIndex] = (uint32_t)value.toInt();
-    else
-    if (currentKey == "moonrise") daily->moonrise[arrayIndex] = (uint32_t)value.toInt();
-    else
-    if (currentKey == "moonset") daily->moonset[arrayIndex] = (uint32_t)value.toInt();
-    else
-    if (currentKey == "pressure") daily->pressure[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "humidity") daily->humidity[arrayIndex] = value.toInt();
-    else
-    if (currentKey == "dew_point") daily->dew_point[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "clouds") daily->clouds[arrayIndex] = value.toInt();
-    else
-    if (currentKey == "wind_speed") daily->wind_speed[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "wind_gust") daily->wind_gust[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "wind_deg") daily->wind_deg[arrayIndex] = (uint16_t)value.toInt();
-    else
-    if (currentKey == "rain") daily->rain[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "snow") daily->snow[arrayIndex] = value.toFloat();
-    else
-
-    if (currentKey == "id") daily->id[arrayIndex] = value.toInt();
-    else
-    if (currentKey == "main") daily->main[arrayIndex] = value;
-    else
-    if (currentKey == "description") daily->description[arrayIndex] = value;
-    else
-    if (currentKey == "icon") daily->icon[arrayIndex] = value;
-    else
-    if (currentKey == "pop") daily->pop[arrayIndex] = value.toFloat();
-
-    if (currentSet == "temp") {
-      if (currentKey == "morn") daily->temp_morn[arrayIndex] = value.toFloat();
-      else
-      if (currentKey == "day") daily->temp_day[arrayIndex] = value.toFloat();
-      else
-      if (currentKey == "eve") daily->temp_eve[arrayIndex] = value.toFloat();
-      else
-      if (currentKey == "night") daily->temp_night[arrayIndex] = value.toFloat();
-      else
-      if (currentKey == "min") daily->temp_min[arrayIndex] = value.toFloat();
-      else
-      if (currentKey == "max") daily->temp_max[arrayIndex] = value.toFloat();
-    }
-
-    if (currentSet == "feels_like") {
-      if (currentKey == "morn") daily->feels_like_morn[arrayIndex] = value.toFloat();
-      else
-      if (currentKey == "day") daily->feels_like_day[arrayIndex] = value.toFloat();
-      else
-      if (currentKey == "eve") daily->feels_like_eve[arrayIndex] = value.toFloat();
-      else
-      if (currentKey == "night") daily->feels_like_night[arrayIndex] = value.toFloat();
-    }
+void OW_Worker::end()
+{
+  if (!started) return;
 
-    return;
+  // A nullptr job stops the worker once the jobs before it are done
+  queueJob(nullptr, true);
+
+#ifdef OW_WORKER_FREERTOS
+  while (running) delay(1);
+  vQueueDelete(queue);
+  queue = nullptr;
+#else
+  thread.join();
+#endif
+
+  started = false;
+}
+
+OW_Worker::~OW_Worker()
+{
+  end();
+}
+
+/***************************************************************************************
+** Function name:           submit
+** Description:             Queue a job for the worker
+***************************************************************************************/
+bool OW_Worker::submit(OW_Job &job)
+{
+  if (!started) return false;
+
+  // A job that is queued or running can not be queued again
+  uint8_t state = job.state.load();
+  if (state == OW_JOB_QUEUED || state == OW_JOB_RUNNING) return false;
+  if (!job.state.compare_exchange_strong(state, OW_JOB_QUEUED)) return false;
+
+  if (queueJob(&job, false)) return true;
+
+  job.state.store(state);
+  return false;
+}
+
+/***************************************************************************************
+** Function name:           run, runJob
+** Description:             Worker loop, fetch and parse each job in turn
+***************************************************************************************/
+void OW_Worker::run()
+{
+  while (OW_Job *job = nextJob()) {
+    job->state.store(OW_JOB_RUNNING);
+    runJob(*job);
   }
 
+  ow.stop();
+}
+
+void OW_Worker::runJob(OW_Job &job)
+{
+  bool ok;
+  if (job.oneCallApi) ok = ow.getForecast(job.set[0], job.set[1], job.set[2], job.apiKey, job.lat,
+                                          job.lon, job.units, job.language, job.secure);
+  else ok = ow.getForecast(job.set[0], job.apiKey, job.lat, job.lon, job.units, job.language, job.secure);
+
+  if (ok && job.publish) job.publish(job.doubleBuffer);
+  job.response = ow.lastResponse();
+
+  // The sketch may reuse or delete the job as soon as the state is set, so it is last
+  if (job.callback) job.callback(job, ok);
+  job.state.store(ok ? OW_JOB_DONE : OW_JOB_ERROR);
 }
 
+#ifdef OW_WORKER_FREERTOS
 /***************************************************************************************
-** Function name:           forecastDataSet
-** Description:             Collects full data set
+** Function name:           task, nextJob, queueJob
+** Description:             FreeRTOS task and job queue
 ***************************************************************************************/
-void OW_Weather::forecastDataSet(const char *val) {
+void OW_Worker::task(void *worker)
+{
+  OW_Worker *self = static_cast<OW_Worker *>(worker);
+  self->run();
+  self->running = false;
+  vTaskDelete(nullptr);
+}
 
-   String value = val;
+OW_Job *OW_Worker::nextJob()
+{
+  OW_Job *job = nullptr;
+  while (xQueueReceive(queue, &job, portMAX_DELAY) != pdTRUE) ;
+  return job;
+}
 
-  // Start of JSON
-  if (currentParent == "") {
-    if (currentKey == "timezone") forecast->timezone = value.toInt();
-    else
-    if (currentKey == "sunrise") forecast->sunrise = (uint32_t)value.toInt();
-    else
-    if (currentKey == "sunset") forecast->sunset = (uint32_t)value.toInt();
+bool OW_Worker::queueJob(OW_Job *job, bool wait)
+{
+  return xQueueSend(queue, &job, wait ? portMAX_DELAY : 0) == pdTRUE;
+}
 
-    return;
+#else
+/***************************************************************************************
+** Function name:           nextJob, queueJob
+** Description:             Thread safe job queue
+***************************************************************************************/
+OW_Job *OW_Worker::nextJob()
+{
+  std::unique_lock<std::mutex> guard(lock);
+  wake.wait(guard, [this] { return !jobs.empty(); });
+
+  OW_Job *job = jobs.front();
+  jobs.pop_front();
+  return job;
+}
+
+// The stop request (wait true) is always queued, so end() can not fail
+bool OW_Worker::queueJob(OW_Job *job, bool wait)
+{
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!wait && jobs.size() >= queueSize) return false;
+    jobs.push_back(job);
   }
 
-  // Loacation
-  if (currentParent == "city") {
-    if (currentKey == "name") forecast->city_name = value;
-    else
-    if (currentKey == "lat") lat = value.toFloat();
-    else
-    if (currentKey == "lon") lon = value.toFloat();
+  wake.notify_one();
+  return true;
+}
+#endif
+#endif // OW_WORKER
+
+#ifdef OW_GZIP
+/***************************************************************************************
+** Description:   Deflate length and distance code tables (RFC 1951)
+***************************************************************************************/
+static const uint16_t OW_lengthBase[29] PROGMEM = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t OW_lengthExtra[29] PROGMEM = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+static const uint16_t OW_distanceBase[30] PROGMEM = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t OW_distanceExtra[30] PROGMEM = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// CRC-32 of each 4 bit value, for the gzip check value
+static const uint32_t OW_crcTable[16] PROGMEM = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+// Order of the code length code lengths in a dynamic block header
+static const uint8_t OW_lengthOrder[19] PROGMEM = {
+  16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
 
-    return;
+/***************************************************************************************
+** Function name:           ~OW_Inflate, allocate, begin
+** Description:             Take and return the window, start a stream
+***************************************************************************************/
+OW_Inflate::~OW_Inflate()
+{
+  delete[] window;
+}
+
+bool OW_Inflate::allocate()
+{
+  if (!window) window = new (std::nothrow) uint8_t[OW_INFLATE_WINDOW];
+  return window != nullptr;
+}
+
+void OW_Inflate::begin(uint8_t format)
+{
+  this->format = format;
+  state = OW_INF_HEADER;
+  outTotal = 0;
+  inPos = inEnd = 0;
+  bitBuf = 0;
+  bitCount = 0;
+  check = (format == OW_INFLATE_GZIP) ? 0xFFFFFFFF : 1;
+}
+
+/***************************************************************************************
+** Function name:           inputSpace
+** Description:             Make room for more compressed bytes
+***************************************************************************************/
+uint8_t *OW_Inflate::inputSpace(size_t &space)
+{
+  if (inPos) {
+    memmove(input, input + inPos, inEnd - inPos);
+    inEnd -= inPos;
+    inPos = 0;
   }
 
-  // 3 hourly forecasts
-  if (currentParent == "list") {
-    data_set = "list";
-    if (arrayIndex >= MAX_3HRS) return;
-
-    if (currentKey == "dt") forecast->dt[arrayIndex] = (uint32_t)value.toInt();
-    else
-    if (currentKey == "temp") forecast->temp[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "temp_min") forecast->temp_min[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "temp_max") forecast->temp_max[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "feels_like") forecast->feels_like[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "pressure") forecast->pressure[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "sea_level") forecast->sea_level[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "grnd_level") forecast->grnd_level[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "humidity") forecast->humidity[arrayIndex] = value.toInt();
-    else
-    if (currentKey == "id") forecast->id[arrayIndex] = value.toInt();
-    else
-    if (currentKey == "main") forecast->main[arrayIndex] = value;
-    else
-    if (currentKey == "description") forecast->description[arrayIndex] = value;
-    else
-    if (currentKey == "icon") forecast->icon[arrayIndex] = value;
-    else
-    if (currentKey == "all") forecast->clouds_all[arrayIndex] = (uint8_t)value.toInt();
-    else
-    if (currentKey == "speed") forecast->wind_speed[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "deg") forecast->wind_deg[arrayIndex] = (uint16_t)value.toInt();
-    else
-    if (currentKey == "gust") forecast->wind_gust[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "visibility") forecast->visibility[arrayIndex] = value.toInt();
-    else
-    if (currentKey == "pop") forecast->pop[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "dt_txt") forecast->dt_txt[arrayIndex] = value;
+  space = sizeof(input) - inEnd;
+  return input + inEnd;
+}
 
-    return;
+/***************************************************************************************
+** Function name:           need, bits
+** Description:             Bit buffer, filled a byte at a time from the input buffer
+***************************************************************************************/
+// Each step checks that all the bits it may use are in the buffer first, so a step is
+// never left half done when the input runs out. At the end of the input the bits left
+// are used, missing bits read as zero.
+bool OW_Inflate::need(uint8_t n)
+{
+  while (bitCount <= 56 && inPos < inEnd) {
+    bitBuf |= (uint64_t)input[inPos++] << bitCount;
+    bitCount += 8;
   }
 
+  return bitCount >= n || (last && bitCount > 0);
+}
+
+uint32_t OW_Inflate::bits(uint8_t n)
+{
+  uint32_t v = (uint32_t)(bitBuf & ((1ULL << n) - 1));
+  bitBuf >>= n;
+  bitCount = (bitCount > n) ? bitCount - n : 0;
+  return v;
 }
 
 /***************************************************************************************
-** Function name:           partialDataSet
-** Description:             Collects partial data set
-***************************************************************************************/
-void OW_Weather::partialDataSet(const char *val) {
-
-   String value = val;
-
-  // Current forecast - no array index - short path
-  if (currentParent == "current") {
-    data_set = "current";
-    if (currentKey == "dt") current->dt = (uint32_t)value.toInt();
-    else
-    if (currentKey == "sunrise") current->sunrise = (uint32_t)value.toInt();
-    else
-    if (currentKey == "sunset") current->sunset = (uint32_t)value.toInt();
-    else
-    if (currentKey == "temp") current->temp = value.toFloat();
-    //else
-    //if (currentKey == "feels_like") current->feels_like = value.toFloat();
-    else
-    if (currentKey == "pressure") current->pressure = value.toFloat();
-    else
-    if (currentKey == "humidity") current->humidity = value.toInt();
-    //else
-    //if (currentKey == "dew_point") current->dew_point = value.toFloat();
-    //else
-    //if (currentKey == "uvi") current->uvi = value.toFloat();
-    else
-    if (currentKey == "clouds") current->clouds = value.toInt();
-    //else
-    //if (currentKey == "visibility") current->visibility = value.toInt();
-    else
-    if (currentKey == "wind_speed") current->wind_speed = value.toFloat();
-    //else
-    //if (currentKey == "wind_gust") current->wind_gust = value.toFloat();
-    else
-    if (currentKey == "wind_deg") current->wind_deg = (uint16_t)value.toInt();
-    //else
-    //if (currentKey == "rain") current->rain = value.toFloat();
-    //else
-    //if (currentKey == "snow") current->snow = value.toFloat();
-
-    else
-    if (currentKey == "id") current->id = value.toInt();
-    else
-    if (currentKey == "main") current->main = value;
-    else
-    if (currentKey == "description") current->description = value;
-    //else
-    //if (currentKey == "icon") current->icon = value;
+** Function name:           build, decode
+** Description:             Canonical Huffman code tables
+***************************************************************************************/
+// The tables hold the number of codes of each length and the symbols in code order,
+// a code is decoded a bit at a time, which needs little RAM.
+void OW_Inflate::build(uint16_t *count, uint16_t *symbol, const uint8_t *lengths, uint16_t n)
+{
+  uint16_t offset[16];
 
-    return;
+  memset(count, 0, 16 * sizeof(uint16_t));
+  for (uint16_t i = 0; i < n; i++) count[lengths[i]]++;
+  count[0] = 0;
+
+  uint16_t sum = 0;
+  for (uint8_t i = 0; i < 16; i++) {
+    offset[i] = sum;
+    sum += count[i];
   }
 
-/*
-  // Hourly forecast
-  if (currentParent == "hourly") {
-    data_set = "hourly";
-    
-    if (arrayIndex >= MAX_HOURS) return;
-    
-    if (currentKey == "dt") hourly->dt[arrayIndex] = (uint32_t)value.toInt();
-    else
-    if (currentKey == "temp") hourly->temp[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "feels_like") hourly->feels_like[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "pressure") hourly->pressure[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "humidity") hourly->humidity[arrayIndex] = value.toInt();
-    else
-    if (currentKey == "dew_point") hourly->dew_point[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "clouds") hourly->clouds[arrayIndex] = value.toInt();
-    else
-    if (currentKey == "wind_speed") hourly->wind_speed[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "wind_gust") hourly->wind_gust[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "wind_deg") hourly->wind_deg[arrayIndex] = (uint16_t)value.toInt();
-    else
-    if (currentKey == "rain") hourly->rain[arrayIndex] = value.toFloat();
-    else
-    if (currentKey == "snow") hourly->snow[arrayIndex] = value.toFloat();
-    else
-
-    if (currentKey == "id") hourly->id[arrayIndex] = value.toInt();
-    else
-    if (currentKey == "main") hourly->main[arrayIndex] = value;
-    else
-    if (currentKey == "description") hourly->description[arrayIndex] = value;
-    else
-    if (currentKey == "icon") hourly->icon[arrayIndex] = value;
+  for (uint16_t i = 0; i < n; i++) {
+    if (lengths[i]) symbol[offset[lengths[i]]++] = i;
+  }
+}
 
-    return;
+int OW_Inflate::decode(const uint16_t *count, const uint16_t *symbol)
+{
+  int sum = 0;
+  int code = 0;
+
+  for (uint8_t len = 1; len < 16; len++) {
+    code = 2 * code + bits(1);
+    sum += count[len];
+    code -= count[len];
+    if (code < 0) return symbol[sum + code];
   }
-*/
-
-  // Daily forecast
-  if (currentParent == "daily") {
-    data_set = "daily";
-    
-    if (arrayIndex >= MAX_DAYS) return;
-    
-    if (currentKey == "dt") daily->dt[arrayIndex] = (uint32_t)value.toInt();
-    else
-    //if (currentKey == "sunrise") daily->sunrise[arrayIndex] = (uint32_t)value.toInt();
-    //else
-    //if (currentKey == "sunset") daily->sunset[arrayIndex] = (uint32_t)value.toInt();
-    //else
-    //if (currentKey == "pressure") daily->pressure[arrayIndex] = value.toFloat();
-    //else
-    //if (currentKey == "humidity") daily->humidity[arrayIndex] = value.toInt();
-    //else
-    //if (currentKey == "dew_point") daily->dew_point[arrayIndex] = value.toFloat();
-    //else
-    //if (currentKey == "clouds") daily->clouds[arrayIndex] = value.toInt();
-    //else
-    //if (currentKey == "wind_speed") daily->wind_speed[arrayIndex] = value.toFloat();
-    //else
-    //if (currentKey == "wind_gust") daily->wind_gust[arrayIndex] = value.toFloat();
-    //else
-    //if (currentKey == "wind_deg") daily->wind_deg[arrayIndex] = (uint16_t)value.toInt();
-    //else
-    //if (currentKey == "rain") daily->rain[arrayIndex] = value.toFloat();
-    //else
-    //if (currentKey == "snow") daily->snow[arrayIndex] = value.toFloat();
-    //else
-
-    if (currentKey == "id") daily->id[arrayIndex] = value.toInt();
-    //else
-    //if (currentKey == "main") daily->main[arrayIndex] = value;
-    //else
-    //if (currentKey == "description") daily->description[arrayIndex] = value;
-    //else
-    //if (currentKey == "icon") daily->icon[arrayIndex] = value;
-
-    if (currentSet == "temp") {
-      //if (currentKey == "morn") daily->temp_morn[arrayIndex] = value.toFloat();
-      //else
-      //if (currentKey == "day") daily->temp_day[arrayIndex] = value.toFloat();
-      //else
-      //if (currentKey == "eve") daily->temp_eve[arrayIndex] = value.toFloat();
-      //else
-      //if (currentKey == "night") daily->temp_night[arrayIndex] = value.toFloat();
-      //else
-      if (currentKey == "min") daily->temp_min[arrayIndex] = value.toFloat();
-      else
-      if (currentKey == "max") daily->temp_max[arrayIndex] = value.toFloat();
-    }
-
-    //if (currentSet == "feels_like") {
-      //if (currentKey == "morn") daily->feels_like_morn[arrayIndex] = value.toFloat();
-      //else
-      //if (currentKey == "day") daily->feels_like_day[arrayIndex] = value.toFloat();
-      //else
-      //if (currentKey == "eve") daily->feels_like_eve[arrayIndex] = value.toFloat();
-      //else
-      //if (currentKey == "night") daily->feels_like_night[arrayIndex] = value.toFloat();
-    //}
 
-    return;
+  return -1; // Bad code
+}
+
+/***************************************************************************************
+** Function name:           updateCheck
+** Description:             Add new output to the gzip CRC-32 or zlib Adler-32 check value
+***************************************************************************************/
+void OW_Inflate::updateCheck()
+{
+  const uint8_t *data = checked;
+  size_t len = outPtr - checked;
+  checked = outPtr;
+
+  if (format == OW_INFLATE_GZIP) {
+    uint32_t crc = check;
+    while (len--) {
+      crc ^= *data++;
+      crc = (crc >> 4) ^ pgm_read_dword(&OW_crcTable[crc & 15]);
+      crc = (crc >> 4) ^ pgm_read_dword(&OW_crcTable[crc & 15]);
+    }
+    check = crc;
+  }
+  else {
+    uint32_t a = check & 0xFFFF;
+    uint32_t b = check >> 16;
+    while (len--) {
+      a = (a + *data++) % 65521;
+      b = (b + a) % 65521;
+    }
+    check = (b << 16) | a;
+  }
+}
+
+/***************************************************************************************
+** Function name:           headerState, stop
+** Description:             Helpers for read()
+***************************************************************************************/
+// gzip header flags: FHCRC 2, FEXTRA 4, FNAME 8, FCOMMENT 16
+uint8_t OW_Inflate::headerState()
+{
+  if (flags & 4)  return OW_INF_EXTRA_LEN;
+  if (flags & 8)  return OW_INF_NAME;
+  if (flags & 16) return OW_INF_COMMENT;
+  if (flags & 2) {
+    flags &= ~2;
+    skip = 2;
+    return OW_INF_SKIP;
+  }
+
+  return OW_INF_BLOCK;
+}
+
+// Called when the stream is bad, or more input is needed. Out of input is an error if
+// no more will be added.
+size_t OW_Inflate::stop(bool error)
+{
+  if (error || last) state = OW_INF_ERROR;
+  updateCheck();
+  return outPtr - outStart;
+}
+
+/***************************************************************************************
+** Function name:           read
+** Description:             Inflate into a buffer, returns the number of bytes output
+***************************************************************************************/
+size_t OW_Inflate::read(uint8_t *out, size_t size, bool last)
+{
+  const uint32_t mask = OW_INFLATE_WINDOW - 1;
+
+  this->last = last;
+  outStart = outPtr = checked = out;
+  outEnd = out + size;
+
+  while (outPtr < outEnd && state < OW_INF_DONE) {
+    switch (state) {
+
+      case OW_INF_HEADER:
+        if (format == OW_INFLATE_GZIP) {
+          if (!need(32)) return stop(false);
+          if (bits(8) != 0x1F || bits(8) != 0x8B || bits(8) != 8) return stop(true);
+          flags = bits(8);
+          skip = 6; // Time, extra flags and OS
+          state = OW_INF_SKIP;
+        }
+        else {
+          if (!need(16)) return stop(false);
+          uint8_t cmf = bits(8);
+          uint8_t flg = bits(8);
+          if ((cmf & 0x0F) != 8 || (flg & 0x20) || ((cmf << 8) | flg) % 31) return stop(true);
+          state = OW_INF_BLOCK;
+        }
+        break;
+
+      case OW_INF_SKIP:
+        while (skip) {
+          if (!need(8)) return stop(false);
+          bits(8);
+          skip--;
+        }
+        state = headerState();
+        break;
+
+      case OW_INF_EXTRA_LEN:
+        if (!need(16)) return stop(false);
+        skip = bits(16);
+        flags &= ~4;
+        state = OW_INF_SKIP;
+        break;
+
+      case OW_INF_NAME:
+      case OW_INF_COMMENT:
+        do {
+          if (!need(8)) return stop(false);
+        } while (bits(8));
+        flags &= (state == OW_INF_NAME) ? ~8 : ~16;
+        state = headerState();
+        break;
+
+      case OW_INF_BLOCK:
+        if (!need(3)) return stop(false);
+        finalBlock = bits(1);
+        switch (bits(2)) {
+          case 0: // Stored, starts at the next byte
+            bits(bitCount & 7);
+            state = OW_INF_STORED_LEN;
+            break;
+          case 1: { // Fixed codes
+            for (uint16_t i = 0; i < 288; i++) lengths[i] = (i < 144) ? 8 : (i < 256) ? 9 : (i < 280) ? 7 : 8;
+            build(litCount, litSymbol, lengths, 288);
+            for (uint16_t i = 0; i < 30; i++) lengths[i] = 5;
+            build(distCount, distSymbol, lengths, 30);
+            state = OW_INF_CODES;
+            break;
+          }
+          case 2: // Dynamic codes
+            state = OW_INF_TABLE;
+            break;
+          default:
+            return stop(true);
+        }
+        break;
+
+      case OW_INF_STORED_LEN: {
+        if (!need(32)) return stop(false);
+        uint16_t len = bits(16);
+        if (len != (uint16_t)~bits(16)) return stop(true);
+        storedLeft = len;
+        state = len ? OW_INF_STORED : (finalBlock ? OW_INF_TRAILER : OW_INF_BLOCK);
+        break;
+      }
+
+      case OW_INF_STORED:
+        while (storedLeft && outPtr < outEnd) {
+          if (!need(8)) return stop(false);
+          uint8_t c = bits(8);
+          window[outTotal++ & mask] = c;
+          *outPtr++ = c;
+          storedLeft--;
+        }
+        if (!storedLeft) state = finalBlock ? OW_INF_TRAILER : OW_INF_BLOCK;
+        break;
+
+      case OW_INF_TABLE:
+        if (!need(14)) return stop(false);
+        codeCount[0] = bits(5) + 257; // Literal/length codes
+        codeCount[1] = bits(5) + 1;   // Distance codes
+        codeCount[2] = bits(4) + 4;   // Code length codes
+        if (codeCount[0] > 286 || codeCount[1] > 30) return stop(true);
+        memset(lengths, 0, 19);
+        index = 0;
+        state = OW_INF_CODE_LENGTHS;
+        break;
+
+      case OW_INF_CODE_LENGTHS:
+        while (index < codeCount[2]) {
+          if (!need(3)) return stop(false);
+          lengths[pgm_read_byte(&OW_lengthOrder[index++])] = bits(3);
+        }
+        // The code length code is held in the distance table until the lengths are read
+        build(distCount, distSymbol, lengths, 19);
+        memset(lengths, 0, sizeof(lengths));
+        index = 0;
+        state = OW_INF_LENGTHS;
+        break;
+
+      case OW_INF_LENGTHS: {
+        uint16_t total = codeCount[0] + codeCount[1];
+        while (index < total) {
+          if (!need(14)) return stop(false);
+          int sym = decode(distCount, distSymbol);
+          if (sym < 0) return stop(true);
+          if (sym < 16) {
+            lengths[index++] = sym;
+            continue;
+          }
+
+          uint8_t  value = 0;
+          uint16_t repeat;
+          if (sym == 16) {
+            if (index == 0) return stop(true);
+            value = lengths[index - 1];
+            repeat = 3 + bits(2);
+          }
+          else if (sym == 17) repeat = 3 + bits(3);
+          else repeat = 11 + bits(7);
+
+          if (index + repeat > total) return stop(true);
+          while (repeat--) lengths[index++] = value;
+        }
+        if (lengths[256] == 0) return stop(true); // No end of block code
+
+        build(litCount, litSymbol, lengths, codeCount[0]);
+        build(distCount, distSymbol, lengths + codeCount[0], codeCount[1]);
+        state = OW_INF_CODES;
+        break;
+      }
+
+      case OW_INF_CODES: {
+        // Longest step: 15 bit code + 5 extra bits + 15 bit distance code + 13 extra bits
+        if (!need(48)) return stop(false);
+        int sym = decode(litCount, litSymbol);
+        if (sym < 0) return stop(true);
+
+        if (sym < 256) {
+          window[outTotal++ & mask] = sym;
+          *outPtr++ = sym;
+          break;
+        }
+
+        if (sym == 256) {
+          state = finalBlock ? OW_INF_TRAILER : OW_INF_BLOCK;
+          break;
+        }
+
+        sym -= 257;
+        if (sym >= 29) return stop(true);
+        copyLength = pgm_read_word(&OW_lengthBase[sym]) + bits(pgm_read_byte(&OW_lengthExtra[sym]));
+
+        int dist = decode(distCount, distSymbol);
+        if (dist < 0 || dist >= 30) return stop(true);
+        copyDistance = pgm_read_word(&OW_distanceBase[dist]) + bits(pgm_read_byte(&OW_distanceExtra[dist]));
+
+        // A reference beyond the window needs a larger OW_INFLATE_WINDOW
+        if (copyDistance > OW_INFLATE_WINDOW || copyDistance > outTotal) return stop(true);
+        state = OW_INF_COPY;
+      }
+      // Fall through
+
+      case OW_INF_COPY:
+        while (copyLength && outPtr < outEnd) {
+          uint8_t c = window[(outTotal - copyDistance) & mask];
+          window[outTotal++ & mask] = c;
+          *outPtr++ = c;
+          copyLength--;
+        }
+        if (!copyLength) state = OW_INF_CODES;
+        break;
+
+      case OW_INF_TRAILER: {
+        bits(bitCount & 7); // Trailer starts at the next byte
+        updateCheck();
+        if (format == OW_INFLATE_GZIP) {
+          // CRC-32 and length, least significant byte first
+          if (!need(64)) return stop(false);
+          if (bits(32) != ~check || bits(32) != outTotal) return stop(true);
+        }
+        else {
+          // Adler-32, most significant byte first
+          if (!need(32)) return stop(false);
+          uint32_t adler = bits(32);
+          adler = (adler >> 24) | ((adler >> 8) & 0xFF00) | ((adler << 8) & 0xFF0000) | (adler << 24);
+          if (adler != check) return stop(true);
+        }
+        state = OW_INF_DONE;
+        break;
+      }
+    }
   }
 
+  updateCheck();
+  return outPtr - outStart;
 }
+#endif
@@ -12,6 +12,105 @@
 #define MAX_ICON_INDEX 11 // Maximum for weather icon index
 #define ICON_RAIN 1       // Index for the rain icon bitmap (bmp file)
 #define NO_VALUE 11       // for precipType default (none)
+#define OW_MAX_DEPTH 8    // Maximum JSON object/array nesting depth tracked by parser
+#define OW_MAX_DATA_SETS 3 // Maximum structs populated by one request
+#define OW_ARENA_BUCKETS 16 // Hash chains used to find identical text in an OW_Arena
+#define OW_MAX_SECTIONS 6  // Maximum top level sections tracked for early end of message
+
+// Skip states for unwanted values (skipMode)
+#define OW_SKIP_OFF       0 // Not skipping, bytes passed to the parser
+#define OW_SKIP_KEY       1 // Unwanted key found, waiting for ':'
+#define OW_SKIP_DONE      2 // Value skipped, placeholder to be passed to the parser
+#define OW_SKIP_VALUE     3 // Waiting for first byte of the value
+#define OW_SKIP_SCALAR    4 // Skipping a number, true, false or null
+#define OW_SKIP_NESTED    5 // Skipping a string, object or array
+#define OW_SKIP_ARRAY_END 6 // Skipping the remaining members of an array
+
+// Chunked transfer encoding states (chunkState)
+#define OW_CHUNK_OFF      0 // Body not chunked
+#define OW_CHUNK_SIZE     1 // Reading the hex chunk size
+#define OW_CHUNK_EXT      2 // Skipping a chunk extension to the end of the size line
+#define OW_CHUNK_DATA     3 // Passing chunk data bytes
+#define OW_CHUNK_DATA_END 4 // Waiting for the CRLF after the chunk data
+#define OW_CHUNK_TRAILER  5 // At the start of a trailer line after the last chunk
+#define OW_CHUNK_TRAILER_LINE 6 // Skipping a trailer line
+#define OW_CHUNK_END      7 // Body complete
+#define OW_CHUNK_ERROR    8 // Bad chunk size, body abandoned
+
+// Response header parse states (headerState)
+#define OW_HEADER_STATUS  0 // Status line, before the status code
+#define OW_HEADER_CODE    1 // Status code digits
+#define OW_HEADER_NAME    2 // Header field name
+#define OW_HEADER_VALUE   3 // Header field value
+#define OW_HEADER_SKIP    4 // Rest of a line not wanted
+#define OW_HEADER_END     5 // Blank line found, the body follows
+
+// Response header fields collected (headerField)
+#define OW_HDR_NONE       0 // Field not wanted
+#define OW_HDR_LENGTH     1 // Content-Length
+#define OW_HDR_TRANSFER   2 // Transfer-Encoding
+#define OW_HDR_ENCODING   3 // Content-Encoding
+#define OW_HDR_CONNECTION 4 // Connection
+#define OW_HDR_ETAG       5 // ETag
+#define OW_HDR_MODIFIED   6 // Last-Modified
+#define OW_HDR_CACHE      7 // Cache-Control
+
+// Non-blocking fetch states (fetchState), see OW_Weather::poll()
+#define OW_FETCH_IDLE     0 // No fetch begun
+#define OW_FETCH_DONE     1 // Finished, parsed OK
+#define OW_FETCH_ERROR    2 // Finished, failed
+#define OW_FETCH_CONNECT  3 // Connecting to the server
+#define OW_FETCH_SEND     4 // Sending the GET request
+#define OW_FETCH_HEADER   5 // Reading the response header
+#define OW_FETCH_BODY     6 // Reading and parsing the JSON body
+#define OW_FETCH_BACKOFF  7 // Waiting to try again after a failure
+#define OW_FETCH_DRAIN    8 // Reading the rest of the body so the connection can be reused
+
+// OW_Weather::poll() return values
+#define OW_POLL_IN_PROGRESS 0 // Call poll() again
+#define OW_POLL_DONE        1 // Structs populated, parsed OK
+#define OW_POLL_ERROR       2 // Fetch failed, or no fetch begun
+
+// Background fetch job states (OW_Job::jobState())
+#define OW_JOB_IDLE       0 // Not submitted
+#define OW_JOB_QUEUED     1 // Waiting for the worker
+#define OW_JOB_RUNNING    2 // Being fetched and parsed
+#define OW_JOB_DONE       3 // Finished, parsed OK
+#define OW_JOB_ERROR      4 // Finished, failed
+
+#define OW_HEADER_TOKEN  20 // Longest header field name or value token matched, plus 1
+#define OW_ETAG_SIZE     48 // ETag value characters kept, plus 1
+#define OW_DATE_SIZE     30 // HTTP date e.g. "Sun, 06 Nov 1994 08:49:37 GMT", plus 1
+
+// Compressed response formats (OW_Inflate::begin())
+#define OW_INFLATE_NONE 0 // Not compressed
+#define OW_INFLATE_GZIP 1 // Content-Encoding: gzip
+#define OW_INFLATE_ZLIB 2 // Content-Encoding: deflate, zlib wrapped
+
+// Inflate states (OW_Inflate)
+#define OW_INF_HEADER       0 // gzip or zlib header
+#define OW_INF_SKIP         1 // Skipping gzip header bytes
+#define OW_INF_EXTRA_LEN    2 // gzip extra field length
+#define OW_INF_NAME         3 // gzip file name, zero terminated
+#define OW_INF_COMMENT      4 // gzip comment, zero terminated
+#define OW_INF_BLOCK        5 // Deflate block header
+#define OW_INF_STORED_LEN   6 // Stored block length
+#define OW_INF_STORED       7 // Stored block bytes
+#define OW_INF_TABLE        8 // Dynamic block code counts
+#define OW_INF_CODE_LENGTHS 9 // Dynamic block code length code lengths
+#define OW_INF_LENGTHS     10 // Dynamic block literal/length and distance code lengths
+#define OW_INF_CODES       11 // Compressed data
+#define OW_INF_COPY        12 // Copying a back reference
+#define OW_INF_TRAILER     13 // gzip or zlib trailer
+#define OW_INF_DONE        14 // Stream complete
+#define OW_INF_ERROR       15 // Bad stream
+
+#define OW_INFLATE_INPUT  256 // Compressed input buffer size
+
+// Onecall location values still to be received (rootPending bits)
+#define OW_ROOT_LAT      0x01
+#define OW_ROOT_LON      0x02
+#define OW_ROOT_TIMEZONE 0x04
 
 #ifndef OpenWeather_h
 #define OpenWeather_h
@@ -23,9 +122,361 @@
 #include <JSON_Listener.h>
 #include <JSON_Decoder.h>
 
+#include <Client.h>
+#include <stddef.h>
+#include <atomic>
+#include <new>
+#include <type_traits>
+
 #include "User_Setup.h"
+#include "Key_Set.h"
 #include "Data_Point_Set.h"
 
+// BearSSL clients can resume a TLS session to shorten the handshake
+#if defined(ESP8266) || defined(ARDUINO_RASPBERRY_PI_PICO_W)
+  #define OW_TLS_SESSION
+  namespace BearSSL { class Session; }
+  #ifdef OW_SAVE_TLS_SESSION
+    namespace fs { class FS; }
+  #endif
+#endif
+
+// Background fetch worker, see OW_Worker. A FreeRTOS task on ESP32, a std::thread when
+// built for a host operating system
+#if defined(ESP32)
+  #define OW_WORKER
+  #define OW_WORKER_FREERTOS
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/queue.h>
+  #include <freertos/task.h>
+#elif defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+  #define OW_WORKER
+  #define OW_WORKER_THREAD
+  #include <condition_variable>
+  #include <deque>
+  #include <mutex>
+  #include <thread>
+#endif
+
+// Client using POSIX sockets, so the library can run on a host computer, see setClient()
+#if defined(__linux__) || defined(__APPLE__)
+  #define OW_POSIX_CLIENT
+#endif
+
+
+/***************************************************************************************
+** Description:   Memory arena for forecast structs and text
+***************************************************************************************/
+// The arena memory is taken once, from a sketch buffer or the heap, and is not returned
+// to the heap until the arena is deleted. reset() discards everything in the arena in
+// one step, so a struct can be created for every update without heap fragmentation.
+// Structs created in an arena must not contain String members, use const char * for
+// text instead (OW_TEXT), the text is then held in the arena too.
+class OW_Arena {
+
+  public:
+    OW_Arena(size_t size);               // Take size bytes from the heap
+    OW_Arena(void *buffer, size_t size); // Use a sketch buffer, e.g. a static array
+    ~OW_Arena();
+
+    // Reserve memory, returns nullptr if the arena is full
+    void *alloc(size_t size, size_t align = sizeof(void *));
+
+    // Create a zeroed struct in the arena, returns nullptr if the arena is full
+    template <typename T> T *create() {
+      static_assert(std::is_trivially_destructible<T>::value,
+                    "Arena structs can not hold String members, use const char *");
+      void *p = alloc(sizeof(T), alignof(T));
+      return p ? new (p) T() : nullptr;
+    }
+
+    // Copy text into the arena, identical text is only stored once.
+    // Returns nullptr if the arena is full
+    const char *intern(const char *text);
+
+    void   reset();                          // Discard all structs and text
+    size_t size()      { return capacity; }  // Arena size in bytes
+    size_t used()      { return top; }       // Bytes in use since the last reset()
+    size_t highWater() { return peak; }      // Most bytes ever in use
+
+  private:
+    uint8_t *base;      // Arena memory
+    size_t   capacity;  // Arena size
+    size_t   top;       // Offset of the next free byte
+    size_t   peak;      // High water mark
+    bool     owned;     // true if taken from the heap by the constructor
+
+    size_t   bucket[OW_ARENA_BUCKETS]; // Offset + 1 of the first text in each hash chain
+};
+
+/***************************************************************************************
+** Description:   Text written into a fixed size buffer, used to build requests
+***************************************************************************************/
+// The request url and header lines are built without String concatenation, so no heap
+// memory is used. Text that does not fit is dropped and fits() returns false.
+class OW_RequestBuilder {
+
+  public:
+    OW_RequestBuilder(char *buffer, size_t size);
+
+    OW_RequestBuilder &add(const char *text);
+    OW_RequestBuilder &add(char c);
+    OW_RequestBuilder &addEncoded(const char *text);        // URL encoded, e.g. "%20" for a space
+    OW_RequestBuilder &addNumber(float value, uint8_t decimals);
+
+    bool   fits()   { return !overflow; }
+    size_t length() { return len; }
+
+  private:
+    char  *buf;
+    size_t size;
+    size_t len;
+    bool   overflow;
+};
+
+// Host name resolver, returns true and sets ip if the name is found, see OW_DnsCache
+typedef bool (*OW_Resolver)(const char *host, IPAddress &ip);
+
+/***************************************************************************************
+** Description:   Cache of host name addresses, so a name is not looked up every time
+***************************************************************************************/
+// An address is used for OW_DNS_TTL ms after it is looked up, then it is looked up again.
+// The same cache can be given to OW_Weather with setDnsCache() and used by the sketch,
+// e.g. for the NTP server, if they run in the same task (it has no lock).
+// The resolver is WiFi.hostByName(), or getaddrinfo() on a host computer, a sketch
+// resolver can be given instead, e.g. to test with a fixed address.
+class OW_DnsCache {
+
+  public:
+    OW_DnsCache(OW_Resolver resolver = nullptr, uint32_t ttl = OW_DNS_TTL);
+
+    // Get the address from the cache, or look it up if not cached or too old
+    bool resolve(const char *host, IPAddress &ip);
+
+    // Get the address from the cache only, false if not cached or too old
+    bool find(const char *host, IPAddress &ip);
+
+    // Forget the address, e.g. after a failed connect to it
+    void invalidate(const char *host);
+    void clear();
+
+    uint16_t hits = 0;    // Addresses found in the cache
+    uint16_t lookups = 0; // Addresses looked up with the resolver
+
+  private:
+    typedef struct OW_DnsEntry {
+      char      host[OW_DNS_HOST_SIZE] = ""; // Empty if the entry is not in use
+      IPAddress ip;
+      uint32_t  time = 0;                    // millis() when looked up
+    } OW_DnsEntry;
+
+    OW_DnsEntry *entry(const char *host);
+
+    OW_Resolver resolver;
+    uint32_t    ttl;
+    OW_DnsEntry entries[OW_DNS_ENTRIES];
+};
+
+/***************************************************************************************
+** Description:   Double buffered struct, readers always see a complete forecast
+***************************************************************************************/
+// The parser fills the back buffer, then publish() makes it the front buffer with one
+// atomic store, so a failed or part parsed response is never seen by readers. Readers
+// (e.g. display code on another core or task) hold a snapshot between acquire() and
+// release(), beginWrite() waits until no reader holds the buffer it is about to reuse.
+//
+//   OW_DoubleBuffer<OW_forecast> weather;
+//
+//   Writer:  ow.getForecast(weather, api_key, ...); // Publishes only if parsed OK
+//
+//   Reader:  const OW_forecast *forecast = weather.acquire();
+//            ... use forecast ...
+//            weather.release(forecast);
+//
+// Two structs are held, so the RAM used is 2 x sizeof(T) plus the heap taken by any
+// String members, e.g. over 8 kbytes for OW_forecast with the default MAX_DAYS of 5.
+template <typename T> class OW_DoubleBuffer {
+
+  public:
+    OW_DoubleBuffer() : front(0) { readers[0] = 0; readers[1] = 0; }
+
+    // Pin the front buffer and return it, must be paired with release()
+    const T *acquire() {
+      while (true) {
+        uint8_t n = front.load();
+        readers[n]++;
+        if (front.load() == n) return &buffer[n]; // Still the front buffer
+        readers[n]--;                             // Swapped meanwhile, try again
+      }
+    }
+
+    // Unpin a buffer returned by acquire()
+    void release(const T *snapshot) {
+      readers[snapshot == &buffer[1] ? 1 : 0]--;
+    }
+
+    // Return the cleared back buffer, waiting until readers have finished with it.
+    // The struct is rebuilt in place, a T() temporary would take sizeof(T) of stack
+    T *beginWrite() {
+      uint8_t n = 1 - front.load();
+      while (readers[n].load() > 0) yield();
+      buffer[n].~T();
+      new (&buffer[n]) T();
+      return &buffer[n];
+    }
+
+    // Make the back buffer the front buffer
+    void publish() {
+      front.store(1 - front.load());
+    }
+
+  private:
+    T buffer[2];
+    std::atomic<uint8_t> front;      // Index of the buffer readers see
+    std::atomic<int>     readers[2]; // Readers holding each buffer
+};
+
+#ifdef OW_GZIP
+/***************************************************************************************
+** Description:   Streaming inflate for gzip and zlib compressed responses
+***************************************************************************************/
+// Compressed bytes are added to a small input buffer and inflated in steps that stop
+// when the input or output space runs out, then carry on when read() is called again.
+// Only the window of recent output is kept for back references, so the response is
+// never held in RAM. The window is taken from the heap by allocate().
+class OW_Inflate {
+
+  public:
+    ~OW_Inflate();
+
+    bool allocate();            // Take the window from the heap, false if not available
+    void begin(uint8_t format); // Start an OW_INFLATE_GZIP or OW_INFLATE_ZLIB stream
+
+    // Free space in the input buffer, then add() the number of bytes written to it
+    uint8_t *inputSpace(size_t &space);
+    void     add(size_t n) { inEnd += n; }
+
+    // Inflate up to size bytes into out, returns the bytes output.
+    // Set last when no more input will be added.
+    size_t read(uint8_t *out, size_t size, bool last);
+
+    bool active()   { return format != OW_INFLATE_NONE; }
+    bool finished() { return state >= OW_INF_DONE; }
+    bool failed()   { return state == OW_INF_ERROR; }
+
+  private:
+    bool     need(uint8_t n);    // true if n bits are available
+    uint32_t bits(uint8_t n);    // Take n bits, least significant first
+    int      decode(const uint16_t *count, const uint16_t *symbol);
+    void     build(uint16_t *count, uint16_t *symbol, const uint8_t *lengths, uint16_t n);
+    uint8_t  headerState();      // Next state from the gzip header flags
+    void     updateCheck();      // Add new output to the check value
+    size_t   stop(bool error);   // Bad stream or out of input, returns the bytes output
+
+    uint8_t *window = nullptr; // Recent output for back references
+    uint32_t outTotal = 0;     // Bytes output, window position is outTotal & mask
+    uint32_t check;            // gzip CRC-32 or zlib Adler-32 of the output
+    uint8_t *outStart;         // read() output buffer
+    uint8_t *outPtr;
+    uint8_t *outEnd;
+    uint8_t *checked;          // Output up to here is in the check value
+    bool     last;             // No more input will be added
+
+    uint8_t  input[OW_INFLATE_INPUT]; // Compressed bytes not yet in bitBuf
+    uint16_t inPos = 0;
+    uint16_t inEnd = 0;
+    uint64_t bitBuf = 0;       // Bits taken from input, least significant first
+    uint8_t  bitCount = 0;
+
+    uint8_t  format = OW_INFLATE_NONE;
+    uint8_t  state = OW_INF_HEADER;
+    uint8_t  flags;            // gzip header flags still to be handled
+    bool     finalBlock;
+    uint16_t skip;             // gzip header bytes to skip
+    uint16_t storedLeft;       // Stored block bytes left
+    uint16_t copyLength;       // Back reference bytes left
+    uint16_t copyDistance;
+    uint16_t codeCount[3];     // Dynamic block code counts, literal/length, distance, length
+    uint16_t index;            // Next code length to read
+
+    uint8_t  lengths[320];     // Code lengths for a dynamic block
+    uint16_t litCount[16];     // Codes of each length
+    uint16_t litSymbol[288];   // Symbols in code order
+    uint16_t distCount[16];
+    uint16_t distSymbol[30];
+};
+#endif
+
+// Connection statistics, see OW_Weather::connectStats()
+typedef struct OW_ConnectStats {
+  uint32_t connectMs = 0; // Time taken by the last new connection, including TLS handshake
+  bool     resumed = false; // Last TLS handshake resumed the cached session
+  uint16_t connects = 0;  // New connections made
+  uint16_t resumes = 0;   // TLS handshakes that resumed the cached session
+  uint16_t retries = 0;   // Failed requests tried again, see OW_Weather::setRetry()
+} OW_ConnectStats;
+
+// A location for OW_Weather::getForecasts()
+typedef struct OW_Location {
+  float latitude  = 0;
+  float longitude = 0;
+} OW_Location;
+
+// Latitude or longitude for the request functions, given as text or as a number, e.g.
+// getForecast(forecast, api_key, "51.5074", "-0.1278", ...) or with 51.5074, -0.1278.
+// A number is sent with 4 decimal places (about 10 metres), one that is not finite or
+// "" gives no location and the request fails. Text is not copied, so it must last until
+// the request function returns.
+class OW_Coordinate {
+
+  public:
+    OW_Coordinate(const char *text)   : text(text ? text : "") { }
+    OW_Coordinate(const String &text) : text(text.c_str()) { }
+
+    // Any number type, so an int or a double literal is not ambiguous
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+    OW_Coordinate(T value) { setNumber((float)value); }
+
+    const char *c_str() const { return text ? text : number; }
+
+  private:
+    void  setNumber(float value);
+
+    const char *text = nullptr; // Text given, or nullptr for a number
+    char  number[12];           // The number as text
+};
+
+// The struct to fill for one location of OW_Weather::getForecasts(), and the result
+typedef struct OW_Result {
+  OW_DataSet set;           // e.g. OW_dataSet(&forecast[i], OW_forecastFields)
+  bool       ok = false;    // true if the response parsed OK
+  uint16_t   status = 0;    // HTTP status code, 0 if there was no response
+  uint32_t   ms = 0;        // Time from the request being sent to the end of the response
+} OW_Result;
+
+// Request timeouts in milliseconds, see OW_Weather::setTimeouts()
+typedef struct OW_Timeouts {
+  uint32_t connect  = 5000;  // TCP connect and TLS handshake
+  uint32_t header   = 5000;  // Request sent to the end of the response header
+  uint32_t idle     = 5000;  // Longest wait for more of the message body
+  uint32_t deadline = 30000; // Whole request including retries, 0 for none
+} OW_Timeouts;
+
+// Response header values, see OW_Weather::lastResponse()
+typedef struct OW_Response {
+  uint16_t status = 0;        // HTTP status code, 0 if no response header was received
+  uint32_t contentLength = 0; // Message body size, 0 if not sent
+  bool     chunked = false;   // Transfer-Encoding: chunked
+  bool     close = false;     // Connection: close, server ends the connection after the body
+  uint8_t  encoding = OW_INFLATE_NONE; // Content-Encoding, OW_INFLATE_xxx
+  char     etag[OW_ETAG_SIZE] = "";         // ETag, "" if not sent
+  char     lastModified[OW_DATE_SIZE] = ""; // Last-Modified, "" if not sent
+  uint32_t maxAge = 0;        // Cache-Control max-age seconds, 0 if not sent
+  bool     noCache = false;   // Cache-Control no-cache or no-store
+} OW_Response;
+
+// Per slot callback function, see OW_Weather::onSlot()
+typedef void (*OW_SlotCallback)(const OW_slot &slot);
 
 /***************************************************************************************
 ** Description:   JSON interface class
@@ -35,16 +486,99 @@ class OW_Weather: public JsonListener {
   public:
     // Sketch calls this forecast request, it returns true if no parse errors encountered
     // ESP8266 only: setting secure to false will invoke an insecure connection
+    // The latitude and longitude can be text or numbers, see OW_Coordinate
     bool getForecast(OW_current *current, OW_hourly *hourly, OW_daily  *daily,
-                     String api_key, String latitude, String longitude,
+                     String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
                      String units, String language, bool secure = true);
 
     // From 2023 the above call requires a subscription, this of uses the forecast API
     // and is free for 1000 calls per day
     bool getForecast(OW_forecast *forecast,
-                     String api_key, String latitude, String longitude,
+                     String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                     String units, String language, bool secure = true);
+
+    // As above but storing scaled integers to halve the RAM needed, see Data_Point_Set.h
+    bool getForecast(OW_forecast_compact *forecast,
+                     String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
                      String units, String language, bool secure = true);
 
+    // Fill the back buffer of a double buffered struct and publish it if parsed OK.
+    // A table is needed for a sketch defined struct T, e.g. getForecast(buf, myFields, ...)
+    bool getForecast(OW_DoubleBuffer<OW_forecast> &forecast,
+                     String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                     String units, String language, bool secure = true) {
+      return getForecast(forecast, OW_forecastFields, api_key, latitude, longitude, units, language, secure);
+    }
+
+    template <typename T, size_t N>
+    bool getForecast(OW_DoubleBuffer<T> &forecast, const OW_Field (&fields)[N],
+                     String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                     String units, String language, bool secure = true) {
+      if (!getForecast(OW_dataSet(forecast.beginWrite(), fields), api_key, latitude, longitude,
+                       units, language, secure)) return false;
+      forecast.publish();
+      return true;
+    }
+
+    // As above but populating sketch defined structs, only the members listed in each
+    // OW_FIELD() descriptor table are collected, see OW_dataSet() in Data_Point_Set.h
+    bool getForecast(OW_DataSet current, OW_DataSet hourly, OW_DataSet daily,
+                     String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                     String units, String language, bool secure = true);
+
+    bool getForecast(OW_DataSet forecast,
+                     String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                     String units, String language, bool secure = true);
+
+    // Forecast API (5 day) for several locations over one connection. Up to
+    // OW_PIPELINE_DEPTH requests are sent before their responses are read (HTTP
+    // pipelining), so the server works on the next while one is parsed. The structs in
+    // results[i] are filled for locations[i], and ok, status and ms set for each.
+    // Requests not answered before the server closes the connection are sent again on a
+    // new one. Returns the number of locations parsed OK.
+    uint16_t getForecasts(const OW_Location *locations, OW_Result *results, uint16_t count,
+                          String api_key, String units, String language, bool secure = true);
+
+    // Non-blocking versions of the getForecast() calls above, these return once the
+    // fetch is set up, then each poll() call does a step of it so the sketch loop() can
+    // carry on. Returns false if a fetch is already in progress.
+    //   ow.beginForecast(forecast, api_key, ...);
+    //   in loop(): if (ow.poll() == OW_POLL_DONE) ... use forecast
+    // The structs must not be used or deleted until poll() returns OW_POLL_DONE or
+    // OW_POLL_ERROR. Sending, and reading each block of the response, return quickly.
+    // Connecting is not split up: the poll() call that connects waits for the TCP
+    // connect and TLS handshake (a second or more with TLS on a small board), up to the connect
+    // timeout, so keepAlive() or setDnsCache() are worth using with poll().
+    bool beginForecast(OW_current *current, OW_hourly *hourly, OW_daily  *daily,
+                       String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                       String units, String language, bool secure = true);
+
+    bool beginForecast(OW_forecast *forecast,
+                       String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                       String units, String language, bool secure = true);
+
+    bool beginForecast(OW_forecast_compact *forecast,
+                       String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                       String units, String language, bool secure = true);
+
+    bool beginForecast(OW_DataSet current, OW_DataSet hourly, OW_DataSet daily,
+                       String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                       String units, String language, bool secure = true);
+
+    bool beginForecast(OW_DataSet forecast,
+                       String api_key, const OW_Coordinate &latitude, const OW_Coordinate &longitude,
+                       String units, String language, bool secure = true);
+
+    // Do the next step of a fetch, returns OW_POLL_IN_PROGRESS, OW_POLL_DONE or OW_POLL_ERROR.
+    // The result stays DONE or ERROR until the next beginForecast().
+    uint8_t poll();
+
+    // Start a non-blocking fetch of a url, see beginForecast()
+    bool beginRequest(String url);
+
+    // The url of the request functions can be a full url or a path, e.g. "/data/2.5/...".
+    // Only the path is sent in the request line, the server is the one set by setServer()
+
     // Called by library (or user sketch), sends a GET request to a https (secure) url
     bool parseRequest(String url); // and parses response, returns true if no parse errors
 
@@ -52,7 +586,83 @@ class OW_Weather: public JsonListener {
     bool parseRequestSecure(String* url); 
     bool parseRequestInsecure(String* url); 
 
-    void partialDataSet(bool partialSet);
+    // Server to connect to, the default is api.openweathermap.org. A port of 0 selects
+    // 443 for a secure connection, or 80 if not, e.g. setServer("127.0.0.1", 8080) for
+    // a local test server
+    void setServer(const char *host, uint16_t port = 0);
+
+    // Connect with a sketch created client instead of the built in WiFi client, e.g. an
+    // EthernetClient, a TLS client with certificate checks, or OW_PosixClient on a host
+    // computer. The client is kept by the sketch, nullptr to use the built in client again
+    void setClient(Client *client);
+
+    // Connect to the address held in the cache instead of looking up the server name for
+    // each new connection, nullptr (the default) for none. If the connect fails the name
+    // is looked up again. Not used with a TLS client that can only send the server name
+    // (SNI) when connecting by name, e.g. the BearSSL client on ESP8266.
+    void setDnsCache(OW_DnsCache *cache);
+
+    // Keep the connection open for the next request, e.g. current plus forecast or several
+    // locations, so the TLS handshake is not repeated. A connection closed by the server
+    // is re-opened when needed. keepAlive(false) or stop() closes the connection.
+    void keepAlive(bool enable);
+    void stop();
+
+    ~OW_Weather();
+
+    // Time and TLS session use for new connections, the time of a resumed handshake can be
+    // compared with a full one to check the saving
+    const OW_ConnectStats &connectStats() { return stats; }
+
+    // Each part of a request has its own timeout, so a stuck connection fails quickly
+    // while a slow message is read for as long as it keeps arriving, up to the deadline
+    void setTimeouts(const OW_Timeouts &timeouts);
+
+    // Try a failed request again up to retries times, 0 (the default) for none. The wait
+    // before a retry doubles each time from backoff ms up to maxBackoff ms, half of it
+    // random. A request refused by the server, e.g. a bad API key, is not tried again.
+    // getForecast() waits with delay(), a non-blocking fetch waits in poll()
+    void setRetry(uint8_t retries, uint32_t backoff = 500, uint32_t maxBackoff = 8000);
+
+    // Response header values of the last request, e.g. the HTTP status code if it failed
+    const OW_Response &lastResponse() { return response; }
+
+#ifdef OW_TLS_SESSION
+    // The TLS session is kept and offered when reconnecting, so the server can resume it
+    // with a shorter handshake
+    void clearSession(); // Next connection does a full handshake
+  #ifdef OW_SAVE_TLS_SESSION
+    // Save the session to a file to use it after a restart, for example
+    // saveSession(LittleFS, "/ow_session.bin"). The file holds the session secret.
+    bool saveSession(fs::FS &fs, const char *path);
+    bool loadSession(fs::FS &fs, const char *path);
+  #endif
+#endif
+
+    void partialDataSet(bool partialSet); // Legacy, prefer a sketch defined OW_DataSet
+
+    // Call a sketch function as each "list", "hourly" or "daily" element ends, this is
+    // as well as filling any structs, so all slots can be used without the RAM needed
+    // to hold them all. The onecall hourly and daily sections are always requested.
+    // Set nullptr to stop the callbacks.
+    void onSlot(OW_SlotCallback callback);
+
+    // Arena that holds the text for OW_TEXT (const char *) struct members, nullptr for none
+    void setArena(OW_Arena *arena);
+
+    // Print the values in a struct to the serial port
+    void printWeather(OW_current *current);
+    void printWeather(OW_hourly *hourly);
+    void printWeather(OW_daily *daily);
+    void printWeather(OW_forecast *forecast);
+    void printWeather(OW_forecast_compact *forecast);
+    void printWeather(OW_DataSet set);
+
+    // Weather condition text for a weather id, from a table in flash (English only).
+    // Used with OW_CONDITION_TABLE defined in User_Setup.h, see Data_Point_Set.h
+    static const __FlashStringHelper *conditionMain(uint16_t id);        // e.g. "Rain"
+    static const __FlashStringHelper *conditionDescription(uint16_t id); // e.g. "light rain"
+    static const char *conditionIcon(uint16_t id, bool night);           // e.g. "10n"
 
     float    lat = 0;
     float    lon = 0;
@@ -82,32 +692,179 @@ class OW_Weather: public JsonListener {
 
     void error( const char *message );    // Error message is sent to serial port
 
-    void fullDataSet(const char *value);    // Populate structure with full data set
-    void partialDataSet(const char *value); // Populate structure with minimal data set
-    void forecastDataSet(const char *val);  // Populate forecast structure
+    // Pass a block of received JSON message bytes to the parser
+    void feedParser(JSON_Decoder &parser, const uint8_t *buf, size_t len);
 
+    // Skip over unwanted values in the received bytes
+    const uint8_t *skipBytes(const uint8_t *buf, const uint8_t *end);
 
-  private: // Variables used internal to library
+    bool wantKey(uint8_t key);              // true if the key value holds wanted values
+
+    // Report JSON bytes received to the serial port
+    void printReceiveStatus();
+
+    // Track the top level sections holding values still wanted, so the message
+    // download can end once all are received
+    void initSections();
+    void addSection(uint8_t key, uint16_t slots);
+    void slotFilled(uint8_t key, uint16_t slots);
+    void sectionDone(uint8_t key);
+    void checkComplete();
+
+    // Add a struct and its descriptor table to the list populated by value()
+    void addDataSet(const OW_DataSet &set);
+
+    // Convert val and store in a struct member of OW_Type type
+    void storeValue(void *member, uint8_t type, const char *val);
+
+    // Find the descriptor for the current value in a table, false if not found
+    bool findField(const OW_Field *fields, uint8_t fieldCount, uint8_t parent, OW_Field &field);
+
+    // Store a value in slot index of a struct member
+    void storeField(void *data, const OW_Field &field, uint16_t index, const char *val);
+
+    // Add the keys in a descriptor table to the wanted key masks and section list
+    void addFields(const OW_Field *fields, uint8_t fieldCount);
+
+    // Set up the structs to populate for a onecall API request and build the url,
+    // returns false if the url is too long
+    bool oneCallUrl(OW_DataSet current, OW_DataSet hourly, OW_DataSet daily,
+                    const char *api_key, const char *latitude, const char *longitude,
+                    const char *units, const char *language, bool secure);
+
+    // Set up the struct to populate for a forecast API request and build the url
+    bool forecastUrl(OW_DataSet forecast, const char *api_key, const char *latitude,
+                     const char *longitude, const char *units, const char *language, bool secure);
+
+    // Add the query values common to both APIs to the url
+    void addQuery(OW_RequestBuilder &url, const char *units, const char *language,
+                  const char *api_key);
+
+    // Copy a sketch url for the request, returns false if too long
+    bool setUrl(const char *url);
+
+    // Fetch the url with retries, see setRetry()
+    bool request();
+
+    // Start a non-blocking fetch of the url
+    bool beginFetch();
+
+    // Fetch the url and feed the JSON message to the parser, returns true if parsed OK
+    bool fetch();
+
+    // Read a response and feed the JSON body to the parser, returns true if parsed OK
+    bool receive(Client *client, JSON_Decoder &parser, uint32_t start, uint32_t sent);
+
+    // Connect to the server with the sketch client or the built in client type selected
+    // by Secure, returns nullptr if the connection failed
+    Client *openServer();
+
+    // Connect a new client of type T, or reuse a kept open connection if keepAlive(true)
+    template <typename T> Client *openClient();
+
+    // Connect the sketch client, or reuse it if kept open
+    Client *openTransport();
+
+    // true if the kept open connection can be used again, if not it is closed
+    bool reuseConnection();
+
+    // Send the GET request for the url in one write, returns false if too long
+    bool sendRequest(Client *client);
+
+    // Decide if a failed request is tried again, if so set the wait in ms
+    bool retryDelay(uint32_t &wait);
+
+    // true if limit ms have passed since the time given, or the request deadline has passed
+    bool timedOut(uint32_t since, uint32_t limit);
+
+    // limit, or the ms left before the request deadline if less
+    uint32_t timeLeft(uint32_t limit);
+
+    // true if a non-blocking fetch is in progress, a new request can not be made
+    bool fetchBusy();
+
+    // End a non-blocking fetch, returns the poll() value
+    uint8_t endFetch(bool parsed, bool reuse = true);
+
+    // Connect a new client, offering any TLS session, and update the statistics
+    template <typename T> bool connectClient(T &client, const char *host, uint16_t port);
+
+    // Close the connection unless it is kept open and the message has been read to the end
+    void releaseClient(Client *client, bool reuse);
+
+    // Clear the response state before a request
+    void resetResponse();
+
+    // Read the response header, false and the client released if not a 200 response
+    bool readHeader(Client *client, uint32_t timeout);
+
+    // Check the header has been received with a 200 status, if not release the client
+    bool checkResponse(Client *client);
+
+    // Pass one response header byte to the header parser, true at the end of the header
+    bool headerByte(uint8_t c);
+
+    // Store a header value byte, and the value at its end (c = 0)
+    void headerValue(uint8_t c);
+
+    // Read a block of the message body, returns the number of bytes read
+    int  readBody(Client *client, uint8_t *buf, size_t size);
+
+    // true when the whole message body has been read
+    bool bodyDone();
+
+    // Remove chunked transfer encoding in place, returns the number of data bytes left
+    size_t dechunk(uint8_t *buf, size_t len);
+
+    // Read a block of the message body as sent, i.e. not inflated
+    int  readRaw(Client *client, uint8_t *buf, size_t size);
+
+    // true when the message body as sent has been read
+    bool rawDone();
+
+    // Accept-Encoding request header line, or "" if compression is not supported
+    const char *acceptEncoding();
+
+#ifdef OW_GZIP
+    // Read a block of the inflated message body
+    int  inflateBody(Client *client, uint8_t *buf, size_t size);
+#endif
+
+    // Read the rest of a message stopped early so the connection can be reused
+    bool drainBody(Client *client);
+
+    // Set or clear a day/night bit from the weather icon name
+    void storeNight(uint8_t *night, uint16_t index, const char *val);
+
+    // Print struct values using the descriptor table
+    void printDataSet(const void *data, const OW_Field *fields, uint8_t fieldCount);
+    void printField(const void *data, const OW_Field &field, uint8_t index);
+
+    uint8_t keyId(const char *key);         // Look up the OW_Key ID for a key name
+
+    int32_t toInt(const char *val);         // Number conversion directly from the
+    float   toFloat(const char *val);       // parser buffer, no String copy
+
+    // Number times 10^shift rounded to an integer, limited to min to max
+    int32_t toScaled(const char *val, int8_t shift, int32_t min, int32_t max);
+
+    void pushLevel(bool isArray);           // Object or array entered, record key ID
+    void popLevel();                        // Object or array ended
+
+    // Key ID of the top level object or array containing the value, e.g. "daily"
+    uint8_t parentKey() { return depth > 1 ? keyStack[1] : (uint8_t)OW_KEY_NONE; }
+
+    // Key ID of the object or array immediately containing the value, e.g. "temp"
+    uint8_t setKey() { return depth <= OW_MAX_DEPTH ? keyStack[depth - 1] : (uint8_t)OW_KEY_UNKNOWN; }
 
-    uint16_t hourly_index;   // index into the OW_hourly structure's data arrays
-    uint16_t daily_index;    // index into the OW_daily structure's data arrays
-    uint16_t forecast_index; // index into the OW_forecast structure's data arrays
+
+  private: // Variables used internal to library
 
     // The value storage structures are created and deleted by the sketch and
     // a pointer passed via the library getForecast() call the value() function
     // is then used to populate the structs with values
-    OW_current  *current;  // pointer provided by sketch to the OW_current struct
-    OW_hourly   *hourly;   // pointer provided by sketch to the OW_hourly struct
-    OW_daily    *daily;    // pointer provided by sketch to the OW_daily struct
-    OW_forecast *forecast; // pointer provided by sketch to the OW_forecast struct
-
-    String      valuePath;  // object (i.e. sequential key) path (like a "file path")
-                            // taken to the name:value pair in the form "hourly/data"
-                            // so values can be pulled from the correct array.
-                            // Needed since different objects contain "data" arrays.
-
-    String data_set;        // A copy of the last object name at the head of an array
-                            // short equivalent to path.
+    OW_DataSet dataSet[OW_MAX_DATA_SETS]; // Struct pointers and descriptor tables
+    uint8_t    dataSetCount;              // Number of structs being populated
 
     bool     parseOK;       // true if the parse been completed
                             // (does not mean data values gathered are good!)
@@ -115,18 +872,236 @@ class OW_Weather: public JsonListener {
     bool     partialSet = false;    // Set true for partial data set acquisition
     bool     oneCall = true;        // Use the oneCall API
 
-    String   currentParent; // Current object e.g. "daily"
-    uint16_t objectLevel;   // Object level, increments for new object, decrements at end
-    String   currentKey;    // Name key of the name:value pair e.g "temperature"
-    String   currentSet;    // Name key of the data set
-    String   arrayPath;     // Path to name:value pair e.g.  "daily/data"
-    uint16_t arrayIndex;    // Array index e.g. 5 for day 5 forecast, qualify with arrayPath
-    uint16_t arrayLevel;    // Array level
+    uint8_t  keyStack[OW_MAX_DEPTH]; // Key ID that opened each object/array level
+    uint8_t  arrayFlags;    // Bit n set if nesting level n is an array
+    uint8_t  depth;         // Object/array nesting depth, 1 = root object
+    uint8_t  currentKey;    // Key ID of the name:value pair e.g OW_KEY_TEMP
+    uint16_t arrayIndex;    // Array index e.g. 5 for day 5 forecast, qualify with parentKey()
+
+    uint8_t  sectionKey[OW_MAX_SECTIONS];   // Parent key ID of each section still wanted
+    uint16_t sectionSlots[OW_MAX_SECTIONS]; // Array slots wanted in each section
+    uint8_t  sectionCount;  // Number of sections still wanted
+    uint8_t  rootPending;   // OW_ROOT_xxx bits for location values not yet received
+    uint64_t sectionMask;   // Bit n set if OW_Key n is a wanted top level section
+    uint64_t keyMask;       // Bit n set if OW_Key n holds wanted values in a section
+    bool     trackSections; // false if the end of the wanted data cannot be detected
+    bool     dataComplete;  // true when all wanted values received, stop reading
+
+    uint8_t  skipMode;      // OW_SKIP_xxx state
+    uint8_t  skipDepth;     // Object/array nesting depth within a skipped value
+    bool     skipInString;  // Skip scan is inside a string
+    bool     skipEscape;    // Skip scan found a \ in a string
+
+    uint32_t bytesReceived; // JSON message bytes passed to the parser
+    uint32_t bodyRead;      // Message bytes read from the client
+    bool     documentEnd;   // End of the JSON document reached
+    bool     headerFound;   // End of the response header found
+    OW_Response response;   // Values from the response header
+    uint8_t  headerState;   // OW_HEADER_xxx state
+    uint8_t  headerField;   // OW_HDR_xxx field of the current header line
+    uint8_t  headerPos;     // Characters in headerToken, or in a text value
+    char     headerToken[OW_HEADER_TOKEN]; // Lower case field name or value token
+    uint8_t  chunkState;    // OW_CHUNK_xxx state
+    uint32_t chunkSize;     // Data bytes left in the current chunk
+#ifdef OW_GZIP
+    OW_Inflate *inflater = nullptr; // Compressed response decoder, during a request only
+#endif
+
+    String   host = "api.openweathermap.org"; // Server name
+    uint16_t serverPort = 0;              // Server port, 0 for the default
+    Client  *transport = nullptr;         // Sketch client, nullptr for the built in one
+
+    Client  *connection = nullptr;        // Open connection, nullptr if none
+    void   (*connectionFree)(Client *c);  // Deletes the connection client
+    uint16_t connectionPort = 0;          // Port of the kept open connection
+    bool     keepAliveOn = false;         // Keep the connection open between requests
+    bool     reusedConnection = false;    // Last request used the kept open connection
+
+    uint8_t  fetchState = OW_FETCH_IDLE;  // OW_FETCH_xxx non-blocking fetch state
+    JSON_Decoder *fetchParser = nullptr;  // Parser kept between poll() calls
+    uint32_t fetchTimer;                  // Start of the current timeout or retry wait
+    uint32_t retryWait;                   // Retry wait ms in the OW_FETCH_BACKOFF state
+    bool     fetchRetried;                // A stale kept open connection has been replaced
+
+    char     requestUrl[OW_URL_SIZE];     // Url of the request in progress
+    bool     batch = false;               // getForecasts() in progress
+
+    OW_Timeouts timeouts;                 // Request timeouts
+    uint32_t requestStart;                // Time the request began, for the deadline
+    uint8_t  retryLimit = 0;              // Retries allowed for a failed request
+    uint8_t  retryCount;                  // Retries made for the current request
+    uint32_t retryBackoff = 500;          // First retry wait in ms
+    uint32_t retryMaxBackoff = 8000;      // Longest retry wait in ms
+
+    OW_ConnectStats stats;                // New connection statistics
+#ifdef OW_TLS_SESSION
+    BearSSL::Session *tlsSession = nullptr; // Session offered for resumption
+#endif
+
+    OW_Arena *arena = nullptr; // Holds OW_TEXT values
+    OW_DnsCache *dnsCache = nullptr; // Server addresses, see setDnsCache()
+
+    OW_SlotCallback slotCallback = nullptr; // Called as each array section element ends
+    OW_slot  slot;          // Values for the callback, cleared after each call
 
     bool     Secure = true; // Link security setting secure (https) or insecure (http)
     uint16_t port;          // 
 };
 
+#ifdef OW_POSIX_CLIENT
+/***************************************************************************************
+** Description:   Client using POSIX sockets, for builds on a host computer
+***************************************************************************************/
+// Plain TCP only, so it is used with a http server, e.g. a local test server:
+//   OW_PosixClient client;
+//   ow.setClient(&client);
+//   ow.setServer("127.0.0.1", 8080);
+// Reads do not block, available() waits up to 1 ms for data so polling loops do not spin.
+// The connect waits up to the Stream timeout, see setTimeouts().
+class OW_PosixClient : public Client {
+
+  public:
+    ~OW_PosixClient() { stop(); }
+
+    int     connect(IPAddress ip, uint16_t port) override;
+    int     connect(const char *host, uint16_t port) override;
+    size_t  write(uint8_t c) override { return write(&c, 1); }
+    size_t  write(const uint8_t *buf, size_t size) override;
+    int     available() override;
+    int     read() override;
+    int     read(uint8_t *buf, size_t size) override;
+    int     peek() override;
+    void    flush() override { }
+    void    stop() override;
+    uint8_t connected() override;
+    operator bool() override { return fd >= 0; }
+
+  private:
+    int  bytesWaiting();    // Bytes that can be read now
+    int  fd = -1;           // Socket, -1 if not connected
+};
+#endif // OW_POSIX_CLIENT
+
+#ifdef OW_WORKER
+class OW_Job;
+
+// Job finished callback, see OW_Job::callback
+typedef void (*OW_JobCallback)(OW_Job &job, bool ok);
+
+/***************************************************************************************
+** Description:   A forecast request for an OW_Worker, and its result
+***************************************************************************************/
+// The sketch owns the job and must not change or delete it from submit() until it has
+// finished. The structs are filled by the worker so are only read once the job has
+// finished, or use a double buffered struct which is published if parsed OK.
+class OW_Job {
+
+  public:
+    // Set up a forecast API request
+    void forecast(OW_DataSet forecast,
+                  String api_key, String latitude, String longitude,
+                  String units, String language, bool secure = true);
+
+    // As above, filling the back buffer which is published if parsed OK
+    template <typename T, size_t N>
+    void forecast(OW_DoubleBuffer<T> &buffer, const OW_Field (&fields)[N],
+                  String api_key, String latitude, String longitude,
+                  String units, String language, bool secure = true) {
+      forecast(OW_dataSet(buffer.beginWrite(), fields), api_key, latitude, longitude,
+               units, language, secure);
+      doubleBuffer = &buffer;
+      publish = [](void *b) { static_cast<OW_DoubleBuffer<T> *>(b)->publish(); };
+    }
+
+    // Set up a onecall API request
+    void oneCall(OW_DataSet current, OW_DataSet hourly, OW_DataSet daily,
+                 String api_key, String latitude, String longitude,
+                 String units, String language, bool secure = true);
+
+    uint8_t jobState() { return state.load(); }           // OW_JOB_xxx
+    bool    finished() { return state.load() >= OW_JOB_DONE; }
+    bool    ok()       { return state.load() == OW_JOB_DONE; }
+
+    // Wait up to timeout ms for the job to finish, returns finished()
+    bool wait(uint32_t timeout = 0xFFFFFFFF);
+
+    // Called by the worker task as the job finishes, so keep it short, e.g. set a flag
+    // or notify a task. The job has finished once the callback returns.
+    OW_JobCallback callback = nullptr;
+    void          *context  = nullptr; // Not used by the library, e.g. for the callback
+
+    OW_Response    response;           // Response header values, set as the job finishes
+
+  private:
+    friend class OW_Worker;
+
+    OW_DataSet set[3];      // Structs to fill, forecast API uses set[0]
+    bool       oneCallApi = false;
+    String     apiKey, lat, lon, units, language;
+    bool       secure = true;
+
+    void      *doubleBuffer = nullptr;          // OW_DoubleBuffer to publish, if any
+    void     (*publish)(void *buffer) = nullptr;
+
+    std::atomic<uint8_t> state{OW_JOB_IDLE};
+};
+
+/***************************************************************************************
+** Description:   Fetches and parses queued OW_Job requests on a worker task or thread
+***************************************************************************************/
+// The sketch loop or UI task submits jobs and never waits for the network. The worker has
+// its own OW_Weather, with keepAlive(true), so the connection is reused between jobs.
+//
+//   OW_Worker worker;
+//   OW_Job    job;
+//   worker.begin();
+//   job.forecast(OW_dataSet(forecast, OW_forecastFields), api_key, ...);
+//   worker.submit(job);
+//   ... later: if (job.finished()) ...
+class OW_Worker {
+
+  public:
+    ~OW_Worker();
+
+    // Start the worker, up to queueLength jobs can be waiting. Returns false if it
+    // could not be started
+    bool begin(uint8_t queueLength = OW_WORKER_QUEUE);
+
+    // Queue a job, returns false if the queue is full, the job is already queued or
+    // running, or the worker has not been started
+    bool submit(OW_Job &job);
+
+    // Finish the queued jobs, then stop the worker and close the connection
+    void end();
+
+    // The OW_Weather used by the worker, settings such as onSlot() and setArena()
+    // are made before begin()
+    OW_Weather &weather() { return ow; }
+
+  private:
+    void    run();             // Worker loop, runs jobs until a nullptr job is received
+    void    runJob(OW_Job &job);
+    OW_Job *nextJob();         // Wait for the next job
+    bool    queueJob(OW_Job *job, bool wait);
+
+    OW_Weather ow;
+    bool       started = false;
+
+#ifdef OW_WORKER_FREERTOS
+    static void task(void *worker);
+
+    QueueHandle_t     queue = nullptr;
+    std::atomic<bool> running{false};
+#else
+    std::thread             thread;
+    std::mutex              lock;
+    std::condition_variable wake;
+    std::deque<OW_Job *>    jobs;
+    uint8_t                 queueSize = 0;
+#endif
+};
+#endif // OW_WORKER
+
 /***************************************************************************************
 ***************************************************************************************/
 #endif
@@ -12,9 +12,47 @@
 #define MAX_DAYS 5      // Maximum "daily" forecast periods can be 1 to 8 (Today + 7 days = 8 maximum)
                         // TFT_eSPI_OpenWeather example requires this to be >= 5 (today + 4 forecast days)
 
+//#define OW_CONDITION_TABLE // Store only the weather id and a day/night bit, not the main,
+                              // description and icon Strings. The text is then found from a
+                              // table in flash (English only), see Data_Point_Set.h
+                              // The supplied examples use the Strings so will need editing
+
+#ifndef OW_READ_BUFFER_SIZE     // May be set by the build, e.g. the host benchmark
+#define OW_READ_BUFFER_SIZE 512 // Bytes read from the client per read() call when
+                                // receiving the JSON message, this buffer is on the stack
+#endif
+
+//#define OW_GZIP // Ask the server for a gzip compressed response, this is inflated as it
+                  // arrives so less is sent over the air. OW_INFLATE_WINDOW bytes plus
+                  // about 1.3 kbytes are taken from the heap during each request
+
+//#define OW_SAVE_TLS_SESSION // ESP8266 and Pico W: add saveSession() and loadSession() to keep
+                              // the TLS session in a file over a restart. The file holds the
+                              // session master secret, so only use this on a trusted device
+
+#define OW_INFLATE_WINDOW 32768 // Inflate window size, a power of 2. 32768 works with any
+                                // gzip response, a smaller window saves RAM but only works
+                                // if the server compresses with a window that small
+
+#define OW_WORKER_QUEUE 4       // OW_Worker jobs that can be waiting, see OpenWeather.h
+#define OW_WORKER_STACK 8192    // ESP32 only: OW_Worker task stack size in bytes
+#define OW_WORKER_PRIORITY 1    // ESP32 only: OW_Worker task priority
+#define OW_WORKER_CORE 0        // ESP32 only: OW_Worker task core, the sketch loop() is on core 1
+
+#define OW_URL_SIZE 256         // Longest request url + 1, the request is built in a buffer
+                                // this size plus the header lines on the stack
+
+#define OW_PIPELINE_DEPTH 4     // getForecasts() requests sent before their responses are
+                                // read, 1 to send each request after the last response
+
+#define OW_DNS_ENTRIES 4        // Host names held by an OW_DnsCache
+#define OW_DNS_HOST_SIZE 40     // Longest host name held + 1, longer names are not cached
+#define OW_DNS_TTL 300000       // Default ms before a cached address is looked up again
+
 //#define SHOW_HEADER   // Debug only - for checking response header via serial message
 //#define SHOW_JSON     // Debug only - simple serial output formatting of whole JSON message
 //#define SHOW_CALLBACK // Debug only to show the decode tree
+//#define OW_NO_SKIP    // Debug only - pass unwanted values to the parser instead of skipping them
 #define OW_STATUS_ON    // Debug only - turn on/off progress and status messages
 
 
@@ -42,4 +80,57 @@
   #define MAX_DAYS 8  // Ignore compiler warning!
 #endif
 
-#define MAX_3HRS (MAX_DAYS * 8)
\ No newline at end of file
+#define MAX_3HRS (MAX_DAYS * 8)
+
+// Check and correct bad setting
+#if !defined (OW_READ_BUFFER_SIZE) || (OW_READ_BUFFER_SIZE < 1)
+  #undef  OW_READ_BUFFER_SIZE
+  #define OW_READ_BUFFER_SIZE 512
+#endif
+
+// Check and correct bad setting
+#if !defined (OW_WORKER_QUEUE) || (OW_WORKER_QUEUE < 1) || (OW_WORKER_QUEUE > 255)
+  #undef  OW_WORKER_QUEUE
+  #define OW_WORKER_QUEUE 4
+#endif
+
+// Check and correct bad setting
+#if !defined (OW_WORKER_STACK) || (OW_WORKER_STACK < 4096)
+  #undef  OW_WORKER_STACK
+  #define OW_WORKER_STACK 8192
+#endif
+
+// Check and correct bad setting
+#if !defined (OW_URL_SIZE) || (OW_URL_SIZE < 128)
+  #undef  OW_URL_SIZE
+  #define OW_URL_SIZE 256
+#endif
+
+// Check and correct bad setting
+#if !defined (OW_PIPELINE_DEPTH) || (OW_PIPELINE_DEPTH < 1)
+  #undef  OW_PIPELINE_DEPTH
+  #define OW_PIPELINE_DEPTH 4
+#endif
+
+// Check and correct bad setting
+#if !defined (OW_DNS_ENTRIES) || (OW_DNS_ENTRIES < 1)
+  #undef  OW_DNS_ENTRIES
+  #define OW_DNS_ENTRIES 4
+#endif
+
+// Check and correct bad setting
+#if !defined (OW_DNS_HOST_SIZE) || (OW_DNS_HOST_SIZE < 16)
+  #undef  OW_DNS_HOST_SIZE
+  #define OW_DNS_HOST_SIZE 40
+#endif
+
+// Check and correct bad setting
+#if !defined (OW_DNS_TTL)
+  #define OW_DNS_TTL 300000
+#endif
+
+// Check and correct bad setting
+#if !defined (OW_INFLATE_WINDOW) || (OW_INFLATE_WINDOW < 256) || (OW_INFLATE_WINDOW > 32768) || (OW_INFLATE_WINDOW & (OW_INFLATE_WINDOW - 1))
+  #undef  OW_INFLATE_WINDOW
+  #define OW_INFLATE_WINDOW 32768
+#endif
\ No newline at end of file
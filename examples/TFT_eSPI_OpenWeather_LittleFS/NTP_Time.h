@@ -133,8 +133,9 @@ void syncTime(void)
 {
   // Don't send too often so we don't trigger Denial of Service
   if (nextSendTime < millis()) {
-    // Get a random server from the pool
-    WiFi.hostByName(ntpServerName, timeServerIP);
+    // Get a random server from the pool, the address is kept in the sketch dnsCache
+    // and only looked up again after OW_DNS_TTL ms
+    dnsCache.resolve(ntpServerName, timeServerIP);
     nextSendTime = millis() + 5000;
 
     // Flush old late packets
@@ -68,6 +68,9 @@
 
 #include <OpenWeather.h>  // Latest here: https://github.com/Bodmer/OpenWeather
 
+// Weather and NTP server addresses, so the names are not looked up for every update
+OW_DnsCache dnsCache;
+
 #include "NTP_Time.h"     // Attached to this sketch, see that tab for library needs
 
 /***************************************************************************************
@@ -78,7 +81,59 @@ TFT_eSPI tft = TFT_eSPI();             // Invoke custom library
 
 OW_Weather ow;      // Weather forecast library instance
 
-OW_forecast  *forecast;
+// Only the forecast values used by this sketch are collected, this saves several
+// kbytes of RAM compared to the library OW_forecast struct. Arrays of one element
+// hold the value for the first 3 hour slot only. Text is held in the arena below
+// so const char * is used instead of String.
+typedef struct TFT_forecast {
+  uint32_t dt[MAX_3HRS];
+  float    temp[1];
+  float    temp_min[MAX_3HRS];
+  float    temp_max[MAX_3HRS];
+  float    pressure[1];
+  uint8_t  humidity[1];
+  uint16_t id[MAX_3HRS];
+  const char *main[1];
+  const char *description[1];
+  uint8_t  clouds_all[1];
+  float    wind_speed[1];
+  uint16_t wind_deg[1];
+  const char *dt_txt[9]; // Used to find the start of the next day
+
+  const char *city_name;
+  int32_t  timezone;
+  uint32_t sunrise;
+  uint32_t sunset;
+} TFT_forecast;
+
+// Where each TFT_forecast value is found in the JSON message
+static constexpr OW_Field forecastFields[] PROGMEM = {
+  OW_FIELD(TFT_forecast, dt,          LIST, LIST,    DT),
+  OW_FIELD(TFT_forecast, temp,        LIST, MAIN,    TEMP),
+  OW_FIELD(TFT_forecast, temp_min,    LIST, MAIN,    TEMP_MIN),
+  OW_FIELD(TFT_forecast, temp_max,    LIST, MAIN,    TEMP_MAX),
+  OW_FIELD(TFT_forecast, pressure,    LIST, MAIN,    PRESSURE),
+  OW_FIELD(TFT_forecast, humidity,    LIST, MAIN,    HUMIDITY),
+  OW_FIELD(TFT_forecast, id,          LIST, WEATHER, ID),
+  OW_FIELD(TFT_forecast, main,        LIST, WEATHER, MAIN),
+  OW_FIELD(TFT_forecast, description, LIST, WEATHER, DESCRIPTION),
+  OW_FIELD(TFT_forecast, clouds_all,  LIST, CLOUDS,  ALL),
+  OW_FIELD(TFT_forecast, wind_speed,  LIST, WIND,    SPEED),
+  OW_FIELD(TFT_forecast, wind_deg,    LIST, WIND,    DEG),
+  OW_FIELD(TFT_forecast, dt_txt,      LIST, LIST,    DT_TXT),
+
+  OW_FIELD(TFT_forecast, city_name,   CITY, CITY,    NAME),
+  OW_FIELD(TFT_forecast, timezone,    CITY, CITY,    TIMEZONE),
+  OW_FIELD(TFT_forecast, sunrise,     CITY, CITY,    SUNRISE),
+  OW_FIELD(TFT_forecast, sunset,      CITY, CITY,    SUNSET),
+};
+
+TFT_forecast *forecast;
+
+// The forecast struct and text are created in this arena for each update. The arena is
+// reset, not freed, between updates so the heap does not become fragmented.
+static uint8_t arenaBuffer[2048];
+OW_Arena arena(arenaBuffer, sizeof(arenaBuffer));
 
 boolean booted = true;
 
@@ -86,10 +141,13 @@ GfxUi ui = GfxUi(&tft); // Jpeg and bmpDraw functions
 
 long lastDownloadUpdate = millis();
 
+bool fetching = false; // Weather fetch in progress, see ow.poll()
+
 /***************************************************************************************
 **                          Declare prototypes
 ***************************************************************************************/
-void updateData();
+bool updateData();
+void showData(bool parsed);
 void drawProgress(uint8_t percentage, String text);
 void drawTime();
 void drawCurrentWeather();
@@ -135,6 +193,17 @@ void setup() {
   }
   Serial.println("\nFlash FS available!");
 
+#ifdef OW_SAVE_TLS_SESSION // Set in the library User_Setup.h
+  // Resume the TLS session saved before the restart, for a shorter first handshake
+  ow.loadSession(LittleFS, "/ow_session.bin");
+#endif
+
+  // Try a failed update again up to 3 times, waiting up to 1, 2 then 4 seconds
+  ow.setRetry(3, 1000);
+
+  // Connect to the cached server address (used for the ESP32 TLS client)
+  ow.setDnsCache(&dnsCache);
+
   // Enable if you want to erase LittleFS, this takes some time!
   // then disable and reload sketch to avoid reformatting on every boot!
   #ifdef FORMAT_LittleFS
@@ -204,12 +273,27 @@ void setup() {
 void loop() {
 
   // Check if we should update weather information
-  if (booted || (millis() - lastDownloadUpdate > 1000UL * UPDATE_INTERVAL_SECS))
+  if (!fetching && (booted || (millis() - lastDownloadUpdate > 1000UL * UPDATE_INTERVAL_SECS)))
   {
-    updateData();
+    fetching = updateData();
     lastDownloadUpdate = millis();
   }
 
+  // The fetch is done a step at a time, so the clock is kept up to date meanwhile
+  if (fetching)
+  {
+    uint8_t state = ow.poll();
+
+    // The start up screen waits for the first forecast
+    while (booted && state == OW_POLL_IN_PROGRESS) { yield(); state = ow.poll(); }
+
+    if (state != OW_POLL_IN_PROGRESS)
+    {
+      fetching = false;
+      showData(state == OW_POLL_DONE);
+    }
+  }
+
   // If minute has changed then request new time from NTP server
   if (booted || minute() != lastMinute)
   {
@@ -231,8 +315,8 @@ void loop() {
 /***************************************************************************************
 **                          Fetch the weather data  and update screen
 ***************************************************************************************/
-// Update the Internet based information and update screen
-void updateData() {
+// Start fetching the Internet based information, returns false if it could not start
+bool updateData() {
   // booted = true;  // Test only
   // booted = false; // Test only
 
@@ -242,8 +326,10 @@ void updateData() {
   if (booted) drawProgress(50, "Updating conditions...");
   else fillSegment(22, 22, 0, (int) (50 * 3.6), 16, TFT_NAVY);
 
-  // Create the structure that holds the retrieved weather
-  forecast = new OW_forecast;
+  // Create the structure that holds the retrieved weather, the last one is discarded
+  arena.reset();
+  forecast = arena.create<TFT_forecast>();
+  ow.setArena(&arena);
 
 #ifdef RANDOM_LOCATION // Randomly choose a place on Earth to test icons etc
   String latitude = "";
@@ -254,12 +340,27 @@ void updateData() {
   Serial.print(", Lon = "); Serial.println(longitude);
 #endif
 
-  bool parsed = ow.getForecast(forecast, api_key, latitude, longitude, units, language);
+  if (ow.beginForecast(OW_dataSet(forecast, forecastFields), api_key, latitude, longitude, units, language)) return true;
+
+  showData(false);
+  return false;
+}
+
+/***************************************************************************************
+**                          Update screen with the fetched weather data
+***************************************************************************************/
+void showData(bool parsed) {
 
   if (parsed) Serial.println("Data points received");
   else Serial.println("Failed to get data points");
 
+#ifdef OW_SAVE_TLS_SESSION
+  // Save a new TLS session, an unchanged one is not written again
+  if (parsed && !ow.connectStats().resumed) ow.saveSession(LittleFS, "/ow_session.bin");
+#endif
+
   //Serial.print("Free heap = "); Serial.println(ESP.getFreeHeap(), DEC);
+  //Serial.print("Arena high water mark = "); Serial.println(arena.highWater());
 
   printWeather(); // For debug, turn on output with #define SERIAL_MESSAGES
 
@@ -301,9 +402,6 @@ void updateData() {
   {
     Serial.println("Failed to get weather");
   }
-
-  // Delete to free up space
-  delete forecast;
 }
 
 /***************************************************************************************
@@ -671,10 +769,12 @@ void fillSegment(int x, int y, int start_angle, int sub_angle, int r, unsigned i
 int getNextDayIndex(void)
 {
   int index = 0;
-  String today = forecast->dt_txt[0].substring(8,10);
+  // dt_txt is "yyyy-mm-dd hh:mm:ss", compare the day of month
+  const char *today = forecast->dt_txt[0];
   for (index = 0; index < 9; index++)
   {
-    if (forecast->dt_txt[index].substring(8,10) != today) break;
+    const char *day = forecast->dt_txt[index];
+    if (strlen(day) < 10 || strlen(today) < 10 || strncmp(day + 8, today + 8, 2) != 0) break;
   }
   return index;
 }
@@ -699,38 +799,7 @@ void printWeather(void)
   if (forecast)
   {
     Serial.println("###############  Forecast weather  ###############\n");
-    for (int i = 0; i < (MAX_DAYS * 8); i++)
-    {
-      Serial.print("3 hourly forecast   "); if (i < 10) Serial.print(" "); Serial.print(i);
-      Serial.println();
-      Serial.print("dt (time)        : "); Serial.println(strTime(forecast->dt[i]));
-
-      Serial.print("temp             : "); Serial.println(forecast->temp[i]);
-      Serial.print("temp.min         : "); Serial.println(forecast->temp_min[i]);
-      Serial.print("temp.max         : "); Serial.println(forecast->temp_max[i]);
-
-      Serial.print("pressure         : "); Serial.println(forecast->pressure[i]);
-      Serial.print("sea_level        : "); Serial.println(forecast->sea_level[i]);
-      Serial.print("grnd_level       : "); Serial.println(forecast->grnd_level[i]);
-      Serial.print("humidity         : "); Serial.println(forecast->humidity[i]);
-
-      Serial.print("clouds           : "); Serial.println(forecast->clouds_all[i]);
-      Serial.print("wind_speed       : "); Serial.println(forecast->wind_speed[i]);
-      Serial.print("wind_deg         : "); Serial.println(forecast->wind_deg[i]);
-      Serial.print("wind_gust        : "); Serial.println(forecast->wind_gust[i]);
-
-      Serial.print("visibility       : "); Serial.println(forecast->visibility[i]);
-      Serial.print("pop              : "); Serial.println(forecast->pop[i]);
-      Serial.println();
-
-      Serial.print("dt_txt           : "); Serial.println(forecast->dt_txt[i]);
-      Serial.print("id               : "); Serial.println(forecast->id[i]);
-      Serial.print("main             : "); Serial.println(forecast->main[i]);
-      Serial.print("description      : "); Serial.println(forecast->description[i]);
-      Serial.print("icon             : "); Serial.println(forecast->icon[i]);
-
-      Serial.println();
-    }
+    ow.printWeather(OW_dataSet(forecast, forecastFields));
   }
 #endif
 }
@@ -0,0 +1,206 @@
+// Benchmark of the value dispatch, run as a test it only reports the speed
+
+// The forecast response is parsed into an OW_forecast by the library, which finds the
+// member from interned key IDs, and by a copy of the listener the library used before,
+// which compared the key and parent Strings in an if/else chain. The time for the
+// JSON_Decoder alone is taken off both. Built with OW_NO_SKIP so the library sees every
+// value as the old one did. The library time includes reading the HTTP response, so
+// its rate is if anything low.
+//   bench_dispatch [parses]
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+#include <chrono>
+
+#include "test_util.h"
+
+// Callbacks as they were before key IDs, for the forecast only
+class StringDispatch : public JsonListener {
+
+  public:
+    OW_forecast *forecast = nullptr;
+    uint32_t values = 0;
+
+    void key(const char *key) override { currentKey = key; }
+
+    void startDocument() override {
+      currentParent = currentKey = "";
+      objectLevel = arrayIndex = arrayLevel = 0;
+    }
+
+    void endDocument() override { startDocument(); }
+
+    void startObject() override {
+      if (arrayIndex == 0 && objectLevel == 1) currentParent = currentKey;
+      objectLevel++;
+    }
+
+    void endObject() override {
+      if (arrayLevel == 0) currentParent = "";
+      if (arrayLevel == 1 && objectLevel == 2) arrayIndex++;
+      objectLevel--;
+    }
+
+    void startArray() override { arrayLevel++; }
+
+    void endArray() override {
+      if (arrayLevel > 0) arrayLevel--;
+      if (arrayLevel == 0) arrayIndex = 0;
+    }
+
+    void whitespace(char) override { }
+    void error(const char *) override { ++testFailures(); }
+
+    void value(const char *val) override {
+      String value = val;
+      values++;
+
+      if (currentParent == "") {
+        if (currentKey == "timezone") forecast->timezone = value.toInt();
+        else
+        if (currentKey == "sunrise") forecast->sunrise = (uint32_t)value.toInt();
+        else
+        if (currentKey == "sunset") forecast->sunset = (uint32_t)value.toInt();
+        return;
+      }
+
+      if (currentParent == "city") {
+        if (currentKey == "name") forecast->city_name = value;
+        else
+        if (currentKey == "lat") lat = value.toFloat();
+        else
+        if (currentKey == "lon") lon = value.toFloat();
+        return;
+      }
+
+      if (currentParent == "list") {
+        if (arrayIndex >= MAX_3HRS) return;
+
+        if (currentKey == "dt") forecast->dt[arrayIndex] = (uint32_t)value.toInt();
+        else
+        if (currentKey == "temp") forecast->temp[arrayIndex] = value.toFloat();
+        else
+        if (currentKey == "temp_min") forecast->temp_min[arrayIndex] = value.toFloat();
+        else
+        if (currentKey == "temp_max") forecast->temp_max[arrayIndex] = value.toFloat();
+        else
+        if (currentKey == "feels_like") forecast->feels_like[arrayIndex] = value.toFloat();
+        else
+        if (currentKey == "pressure") forecast->pressure[arrayIndex] = value.toFloat();
+        else
+        if (currentKey == "sea_level") forecast->sea_level[arrayIndex] = value.toFloat();
+        else
+        if (currentKey == "grnd_level") forecast->grnd_level[arrayIndex] = value.toFloat();
+        else
+        if (currentKey == "humidity") forecast->humidity[arrayIndex] = value.toInt();
+        else
+        if (currentKey == "id") forecast->id[arrayIndex] = value.toInt();
+#ifndef OW_CONDITION_TABLE
+        else
+        if (currentKey == "main") forecast->main[arrayIndex] = value;
+        else
+        if (currentKey == "description") forecast->description[arrayIndex] = value;
+        else
+        if (currentKey == "icon") forecast->icon[arrayIndex] = value;
+#endif
+        else
+        if (currentKey == "all") forecast->clouds_all[arrayIndex] = (uint8_t)value.toInt();
+        else
+        if (currentKey == "speed") forecast->wind_speed[arrayIndex] = value.toFloat();
+        else
+        if (currentKey == "deg") forecast->wind_deg[arrayIndex] = (uint16_t)value.toInt();
+        else
+        if (currentKey == "gust") forecast->wind_gust[arrayIndex] = value.toFloat();
+        else
+        if (currentKey == "visibility") forecast->visibility[arrayIndex] = value.toInt();
+        else
+        if (currentKey == "pop") forecast->pop[arrayIndex] = value.toFloat();
+        else
+        if (currentKey == "dt_txt") forecast->dt_txt[arrayIndex] = value;
+      }
+    }
+
+    float lat = 0, lon = 0;
+
+  private:
+    String   currentParent, currentKey;
+    uint16_t objectLevel = 0, arrayIndex = 0, arrayLevel = 0;
+};
+
+// The decoder with nothing done in the callbacks
+class NoDispatch : public JsonListener {
+
+  public:
+    void key(const char *) override { }
+    void value(const char *) override { }
+    void startDocument() override { }
+    void endDocument() override { }
+    void startObject() override { }
+    void endObject() override { }
+    void startArray() override { }
+    void endArray() override { }
+    void whitespace(char) override { }
+    void error(const char *) override { ++testFailures(); }
+};
+
+// Mean ns per call of parse
+template <typename F>
+static double timeParses(int parses, F parse)
+{
+  using namespace std::chrono;
+  auto start = steady_clock::now();
+  for (int i = 0; i < parses; i++) parse();
+  return duration<double, std::nano>(steady_clock::now() - start).count() / parses;
+}
+
+static void decode(const std::string &body, JsonListener *listener)
+{
+  JSON_Decoder parser;
+  parser.setListener(listener);
+  for (char c : body) parser.parse(c);
+}
+
+int main(int argc, char *argv[])
+{
+  Serial.quiet = true;
+  int parses = argc > 1 ? atoi(argv[1]) : 200;
+
+  std::string body = readFile("forecast.json");
+  std::string response = httpResponse(body);
+
+  MockClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+
+  OW_forecast *before = new OW_forecast;
+  OW_forecast *after  = new OW_forecast;
+  StringDispatch strings;
+  NoDispatch none;
+  strings.forecast = before;
+
+  double decoder = timeParses(parses, [&] { decode(body, &none); });
+  double chain = timeParses(parses, [&] { decode(body, &strings); });
+  double ids = timeParses(parses, [&] {
+    client.responses.push_back(response);
+    if (!ow.getForecast(after, "key", "0", "0", "metric", "en")) ++testFailures();
+  });
+
+  double values = strings.values / (double)parses;
+  ::printf("%d parses of %.0f values, million values dispatched per second:\n", parses, values);
+  ::printf("  before, String key and parent compared  %7.2f\n", values * 1e3 / (chain - decoder));
+  ::printf("  after, interned key IDs                 %7.2f\n", values * 1e3 / (ids - decoder));
+  ::printf("  (JSON_Decoder alone %.1f us per parse)\n", decoder / 1000);
+
+  // Both fill the struct the same
+  CHECK(before->dt[MAX_3HRS - 1] != 0 && before->city_name != "");
+  for (int i = 0; i < MAX_3HRS; i++) {
+    CHECK(after->dt[i] == before->dt[i] && after->temp[i] == before->temp[i]);
+    CHECK(after->pop[i] == before->pop[i] && after->dt_txt[i] == before->dt_txt[i]);
+  }
+  CHECK(after->city_name == before->city_name);
+
+  delete before;
+  delete after;
+  return testResult("bench_dispatch");
+}
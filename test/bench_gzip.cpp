@@ -0,0 +1,131 @@
+// Download and parse time and peak heap with and without compression, built with
+// OW_GZIP as bench_gzip and without it as bench_gzip_off
+
+// Run as a test it only reports the figures. The local MockServer sends the onecall
+// response gzip compressed when the request asks for it, and uncompressed otherwise.
+// Each request is made on a new connection with OW_PosixClient. bench_gzip also times
+// the uncompressed response, the inflate window is then taken but not used. Peak heap
+// is counted by replacing operator new, for the thread making the requests only.
+//   bench_gzip [requests]
+
+#include <Arduino.h>
+#include <OpenWeather.h>
+#include <atomic>
+#include <chrono>
+#include <new>
+
+#include "mock_server.h"
+#include "test_util.h"
+
+static std::atomic<size_t> heapNow { 0 };
+static size_t heapPeak = 0;
+static thread_local bool counted = false; // Not the MockServer thread
+
+#if !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+  #pragma GCC diagnostic ignored "-Wmismatched-new-delete" // new is malloc here
+#endif
+
+// Each block starts with its counted size, so delete can take it off
+#define HEAP_HEADER 16
+
+void *operator new(size_t size)
+{
+  size_t *p = (size_t *)malloc(size + HEAP_HEADER);
+  if (!p) throw std::bad_alloc();
+  *p = counted ? size : 0;
+  if (counted && (heapNow += size) > heapPeak) heapPeak = heapNow;
+  return (uint8_t *)p + HEAP_HEADER;
+}
+
+void operator delete(void *p) noexcept
+{
+  if (!p) return;
+  size_t *block = (size_t *)((uint8_t *)p - HEAP_HEADER);
+  heapNow -= *block;
+  free(block);
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  try { return operator new(size); } catch (...) { return nullptr; }
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  try { return operator new(size); } catch (...) { return nullptr; }
+}
+void operator delete[](void *p) noexcept { operator delete(p); }
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+void operator delete[](void *p, size_t) noexcept { operator delete(p); }
+#define COUNTING true
+#else
+#define COUNTING false // The sanitizer has its own operator new
+#endif
+
+struct Hourly {
+  uint32_t dt[MAX_HOURS];
+  float    temp[MAX_HOURS];
+  uint16_t id[MAX_HOURS];
+};
+
+static const OW_Field hourlyFields[] = {
+  OW_FIELD(Hourly, dt,   HOURLY, HOURLY,  DT),
+  OW_FIELD(Hourly, temp, HOURLY, HOURLY,  TEMP),
+  OW_FIELD(Hourly, id,   HOURLY, WEATHER, ID),
+};
+
+// Time and peak heap of the requests, with the server sending compressed if asked
+static void run(OW_Weather &ow, MockServer &server, Hourly *hourly, int requests, bool compress, const char *name)
+{
+  using namespace std::chrono;
+
+  static const std::string body = readFile("onecall.json");
+  static const std::string gzip = readFile("onecall.json.gz");
+  std::string plain = httpResponse(body);
+  std::string compressed = httpResponse(gzip, "Content-Encoding: gzip\r\n");
+  server.respond([=](const std::string &head) {
+    bool asked = head.find("Accept-Encoding: gzip") != std::string::npos;
+    return (compress && asked) ? compressed : plain;
+  });
+
+  size_t sent = server.bytesSent();
+  heapPeak = heapNow;
+  size_t base = heapNow;
+  auto start = steady_clock::now();
+  for (int i = 0; i < requests; i++) {
+    hourly->dt[MAX_HOURS - 1] = 0;
+    if (!ow.getForecast(OW_dataSet(), OW_dataSet(hourly, hourlyFields), OW_dataSet(),
+                        "key", "0", "0", "metric", "en", false)) ++testFailures();
+  }
+  double us = duration<double, std::micro>(steady_clock::now() - start).count() / requests;
+
+  ::printf("%s, %d requests: %.1f us per download and parse, %zu bytes sent per request",
+           name, requests, us, (server.bytesSent() - sent) / requests);
+  if (COUNTING) ::printf(", peak heap %zu bytes\n", heapPeak - base);
+  else ::printf("\n");
+
+  CHECK(hourly->dt[MAX_HOURS - 1] != 0);
+}
+
+int main(int argc, char *argv[])
+{
+  Serial.quiet = true;
+  int requests = argc > 1 ? atoi(argv[1]) : 100;
+
+  MockServer server;
+  counted = true;
+  OW_PosixClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+  ow.setServer("127.0.0.1", server.port());
+  Hourly *hourly = new Hourly;
+
+#ifdef OW_GZIP
+  run(ow, server, hourly, requests, true, "gzip compressed");
+  run(ow, server, hourly, requests, false, "Uncompressed, OW_GZIP set");
+#else
+  run(ow, server, hourly, requests, true, "Uncompressed, OW_GZIP not set");
+#endif
+
+  delete hourly;
+  return testResult("bench_gzip");
+}
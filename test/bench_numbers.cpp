@@ -0,0 +1,93 @@
+// Microbenchmark of the number conversion, run as a test it only reports the times
+
+// A response of numbers is parsed repeatedly into float members (toFloat), scaled
+// integer members (toScaled), and String members converted afterwards with
+// String::toFloat() as the library used to. The time of a parse that only stores the
+// first number is taken off, leaving the cost of parsing and storing each number, so
+// the rows differ only in the conversion.
+//   bench_numbers [parses]
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+#include <chrono>
+#include <vector>
+
+#include "test_util.h"
+
+#define BATCH 200
+
+struct FloatNumbers  { float   value[BATCH]; };
+struct ScaledNumbers { int16_t value[BATCH]; };
+struct StringNumbers { String  value[BATCH]; };
+struct NoNumbers     { float   value[1]; }; // Only the first is stored
+
+static const OW_Field floatFields[]  = { OW_FIELD(FloatNumbers, value, LIST, MAIN, TEMP) };
+static const OW_Field scaledFields[] = { OW_FIELD_TYPE(ScaledNumbers, value, OW_I16_X100, LIST, MAIN, TEMP) };
+static const OW_Field stringFields[] = { OW_FIELD(StringNumbers, value, LIST, MAIN, TEMP) };
+static const OW_Field noFields[]     = { OW_FIELD(NoNumbers, value, LIST, MAIN, TEMP) };
+
+static MockClient client;
+static OW_Weather ow;
+static std::string response;
+
+// Mean ns per parse, after is run once after each parse
+template <typename F>
+static double timeParses(OW_DataSet set, int parses, F after)
+{
+  using namespace std::chrono;
+  double total = 0;
+  for (int i = 0; i < parses; i++) {
+    client.responses.push_back(response);
+    auto start = steady_clock::now();
+    if (!ow.getForecast(set, "key", "0", "0", "metric", "en")) ++testFailures();
+    after();
+    total += duration<double, std::nano>(steady_clock::now() - start).count();
+  }
+  return total / parses;
+}
+
+int main(int argc, char *argv[])
+{
+  Serial.quiet = true;
+  int parses = argc > 1 ? atoi(argv[1]) : 200;
+
+  // Temperatures in the format the server sends
+  std::string json = "{\"list\":[";
+  for (int i = 0; i < BATCH; i++) {
+    char item[64];
+    snprintf(item, sizeof(item), "%s{\"main\":{\"temp\":%.2f}}", i ? "," : "", (i * 7919 % 6000) / 100.0 - 20);
+    json += item;
+  }
+  json += "]}";
+  response = httpResponse(json);
+  ow.setClient(&client);
+
+  FloatNumbers  *f = new FloatNumbers;
+  ScaledNumbers *s = new ScaledNumbers;
+  StringNumbers *t = new StringNumbers;
+  NoNumbers     *n = new NoNumbers;
+  float sum = 0;
+
+  double none = timeParses(OW_dataSet(n, noFields), parses, [] { });
+  double floats = timeParses(OW_dataSet(f, floatFields), parses, [] { });
+  double scaled = timeParses(OW_dataSet(s, scaledFields), parses, [] { });
+  double strings = timeParses(OW_dataSet(t, stringFields), parses, [&] {
+    for (int i = 0; i < BATCH; i++) sum += t->value[i].toFloat();
+  });
+
+  ::printf("%d parses of %d numbers, ns per number stored:\n", parses, BATCH);
+  ::printf("  float member (toFloat)             %7.1f\n", (floats - none) / BATCH);
+  ::printf("  scaled integer member (toScaled)   %7.1f\n", (scaled - none) / BATCH);
+  ::printf("  String member + String::toFloat()  %7.1f\n", (strings - none) / BATCH);
+  ::printf("  (parse storing one number %.1f us)\n", none / 1000);
+
+  CHECK(f->value[1] == strtof(t->value[1].c_str(), nullptr));
+  CHECK(sum != 0);
+
+  delete f;
+  delete s;
+  delete t;
+  delete n;
+  return testResult("bench_numbers");
+}
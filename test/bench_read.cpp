@@ -0,0 +1,72 @@
+// Download and parse time against the local MockServer, built with OW_READ_BUFFER_SIZE
+// of 1, 64 and 1024 bytes: bench_read_1, bench_read_64 and bench_read_1024
+
+// Run as a test it only reports the times. Each request is made on a new connection
+// with OW_PosixClient, so the time includes the connect, the request, the reads and the
+// parse, as on a board. The host has no TLS, so HTTPS is not measured, there each read
+// goes through the TLS stack too and the difference is larger.
+//   bench_read [requests]
+
+#include <Arduino.h>
+#include <OpenWeather.h>
+#include <chrono>
+
+#include "mock_server.h"
+#include "test_util.h"
+
+// OW_PosixClient counting the body reads
+class CountingClient : public OW_PosixClient {
+
+  public:
+    uint32_t reads = 0;
+
+    int read(uint8_t *buf, size_t size) override {
+      reads++;
+      return OW_PosixClient::read(buf, size);
+    }
+};
+
+struct Forecast {
+  uint32_t dt[MAX_3HRS];
+  float    temp[MAX_3HRS];
+  uint16_t id[MAX_3HRS];
+  uint32_t sunset;
+};
+
+static const OW_Field forecastFields[] = {
+  OW_FIELD(Forecast, dt,     LIST, LIST, DT),
+  OW_FIELD(Forecast, temp,   LIST, MAIN, TEMP),
+  OW_FIELD(Forecast, id,     LIST, WEATHER, ID),
+  OW_FIELD(Forecast, sunset, CITY, CITY, SUNSET),
+};
+
+int main(int argc, char *argv[])
+{
+  using namespace std::chrono;
+  Serial.quiet = true;
+  int requests = argc > 1 ? atoi(argv[1]) : 100;
+
+  MockServer server;
+  CountingClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+  ow.setServer("127.0.0.1", server.port());
+
+  Forecast *forecast = new Forecast;
+  auto start = steady_clock::now();
+  for (int i = 0; i < requests; i++) {
+    forecast->sunset = 0;
+    if (!ow.getForecast(OW_dataSet(forecast, forecastFields), "key", "0", "0", "metric", "en", false)) ++testFailures();
+  }
+  double us = duration<double, std::micro>(steady_clock::now() - start).count() / requests;
+
+  size_t bytes = readFile("forecast.json").size();
+  ::printf("Read size %d bytes, %d requests: %.1f us per download and parse, %.1f MB/s, %.1f reads per request\n",
+           OW_READ_BUFFER_SIZE, requests, us, bytes / us, client.reads / (double)requests);
+
+  CHECK(forecast->dt[MAX_3HRS - 1] != 0 && forecast->sunset != 0);
+  CHECK(server.connections() == requests);
+
+  delete forecast;
+  return testResult("bench_read");
+}
@@ -0,0 +1,104 @@
+// Parse throughput with unwanted values skipped, built twice: bench_skip, and
+// bench_skip_off with OW_NO_SKIP so every value goes to the JSON_Decoder
+
+// Run as a test it only reports the speed. The structs want a few values, as a sketch
+// that shows the current weather and the next days would, including values at the end
+// of the response so all of it is read.
+//   bench_skip [parses]
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+#include <chrono>
+
+#include "test_util.h"
+
+struct Now {
+  uint32_t dt;
+  float    temp;
+  String   description;
+};
+
+struct Days {
+  uint32_t dt[MAX_DAYS];
+  float    temp_max[MAX_DAYS];
+  uint16_t id[MAX_DAYS];
+};
+
+struct Hours {
+  uint32_t dt[8];
+  float    temp[8];
+  uint16_t id[8];
+  uint32_t sunset;
+};
+
+static const OW_Field nowFields[] = {
+  OW_FIELD(Now, dt,          CURRENT, CURRENT, DT),
+  OW_FIELD(Now, temp,        CURRENT, CURRENT, TEMP),
+  OW_FIELD(Now, description, CURRENT, WEATHER, DESCRIPTION),
+};
+
+static const OW_Field dayFields[] = {
+  OW_FIELD(Days, dt,       DAILY, DAILY, DT),
+  OW_FIELD(Days, temp_max, DAILY, TEMP, MAX),
+  OW_FIELD(Days, id,       DAILY, WEATHER, ID),
+};
+
+static const OW_Field hourFields[] = {
+  OW_FIELD(Hours, dt,     LIST, LIST, DT),
+  OW_FIELD(Hours, temp,   LIST, MAIN, TEMP),
+  OW_FIELD(Hours, id,     LIST, WEATHER, ID),
+  OW_FIELD(Hours, sunset, CITY, CITY, SUNSET),
+};
+
+static MockClient client;
+static OW_Weather ow;
+
+// Body bytes parsed per second
+template <typename F>
+static double throughput(const std::string &body, int parses, F fetch)
+{
+  using namespace std::chrono;
+  std::string response = httpResponse(body);
+  auto start = steady_clock::now();
+  for (int i = 0; i < parses; i++) {
+    client.responses.push_back(response);
+    if (!fetch()) ++testFailures();
+  }
+  return body.size() * (double)parses / duration<double>(steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+  Serial.quiet = true;
+  int parses = argc > 1 ? atoi(argv[1]) : 100;
+  ow.setClient(&client);
+
+  Now   *now   = new Now;
+  Days  *days  = new Days;
+  Hours *hours = new Hours;
+
+  double onecall = throughput(readFile("onecall.json"), parses, [&] {
+    return ow.getForecast(OW_dataSet(now, nowFields), OW_dataSet(), OW_dataSet(days, dayFields),
+                          "key", "0", "0", "metric", "en");
+  });
+  double forecast = throughput(readFile("forecast.json"), parses, [&] {
+    return ow.getForecast(OW_dataSet(hours, hourFields), "key", "0", "0", "metric", "en");
+  });
+
+#ifdef OW_NO_SKIP
+  const char *mode = "off";
+#else
+  const char *mode = "on";
+#endif
+  ::printf("Skipping %s, %d parses, MB/s: onecall %.1f, forecast %.1f\n",
+           mode, parses, onecall / 1e6, forecast / 1e6);
+
+  CHECK(now->dt == 1700000000 && days->dt[MAX_DAYS - 1] != 0);
+  CHECK(hours->dt[7] != 0 && hours->sunset != 0);
+
+  delete now;
+  delete days;
+  delete hours;
+  return testResult("bench_skip");
+}
@@ -0,0 +1,226 @@
+// Local HTTP/1.1 server for the OW_PosixClient tests, serving the sample responses
+
+// Listens on a free 127.0.0.1 port in its own thread and answers one connection at a
+// time, like the API server: GET /data/2.5/forecast and /data/2.5/onecall with the
+// test/data responses, keep-alive unless the request has "Connection: close", and
+// pipelined requests answered in order. A request target that is not origin-form
+// (a path) gets 400 Bad Request. A test can set its own responder, the connection is
+// then closed after a response with "Connection: close" in its header, and can have
+// responses sent slowly or stop part way, as a slow or stalled server would, or have
+// each connection closed after a number of responses with requests still unanswered.
+
+#ifndef mock_server_h
+#define mock_server_h
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test_util.h"
+
+#ifndef MSG_NOSIGNAL
+  #define MSG_NOSIGNAL 0 // macOS
+#endif
+
+class MockServer {
+
+  public:
+    MockServer() {
+      forecast = readFile("forecast.json");
+      onecall = readFile("onecall.json");
+
+      listener = socket(AF_INET, SOCK_STREAM, 0);
+      int on = 1;
+      setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+      sockaddr_in address = {};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      socklen_t size = sizeof(address);
+      if (bind(listener, (sockaddr *)&address, size) != 0 || listen(listener, 4) != 0 ||
+          getsockname(listener, (sockaddr *)&address, &size) != 0) {
+        ::printf("MockServer: can not listen\n");
+        exit(1);
+      }
+      serverPort = ntohs(address.sin_port);
+
+      thread = std::thread([this] { run(); });
+    }
+
+    ~MockServer() {
+      done = true;
+      thread.join();
+      close(listener);
+    }
+
+    uint16_t port() const { return serverPort; }
+    int connections() const { return accepted; }
+
+    size_t bytesSent() const { return sent; }
+
+    // Response for each request head, in place of the sample responses
+    void respond(std::function<std::string(const std::string &head)> responder) {
+      std::lock_guard<std::mutex> lock(mutex);
+      this->responder = responder;
+    }
+
+    // Send each response in pieces of piece bytes, pause ms apart, and send nothing
+    // after the first stall bytes, the connection is then held open until the client
+    // closes it. pace(SIZE_MAX, 0) sends each response at once.
+    void pace(size_t piece, uint32_t pause, size_t stall = SIZE_MAX) {
+      pieceSize = piece;
+      pauseMs = pause;
+      stallAt = stall;
+    }
+
+    // Close each connection after this many responses, -1 for no limit. Requests
+    // received and not answered are dropped, as a server closing an idle connection would
+    void closeAfter(int responses) { closeLimit = responses; }
+
+    // Request lines answered, e.g. "GET /data/2.5/forecast?lat=... HTTP/1.1"
+    std::vector<std::string> requests() {
+      std::lock_guard<std::mutex> lock(mutex);
+      return received;
+    }
+
+    // Request lines received and not answered, as the server closed the connection
+    std::vector<std::string> unanswered() {
+      std::lock_guard<std::mutex> lock(mutex);
+      return dropped;
+    }
+
+  private:
+    void run() {
+      while (!done) {
+        if (!waitFor(listener)) continue;
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) continue;
+        accepted++;
+        serve(fd);
+
+        // Close after the client has read what was sent, a close with unread requests
+        // would reset the connection and could lose the responses
+        shutdown(fd, SHUT_WR);
+        char buffer[1024];
+        for (int i = 0; i < 20 && !done; i++) {
+          if (waitFor(fd) && recv(fd, buffer, sizeof(buffer), 0) <= 0) break;
+        }
+        close(fd);
+      }
+    }
+
+    // Answer requests until the client closes or asks to
+    void serve(int fd) {
+      std::string input;
+      int answered = 0;
+      while (!done) {
+        size_t end;
+        while ((end = input.find("\r\n\r\n")) != std::string::npos) {
+          if (closeLimit >= 0 && answered >= closeLimit) return drop(input);
+          answered++;
+          std::string head = input.substr(0, end);
+          input.erase(0, end + 4);
+          std::string response = answer(head);
+          if (!sendPaced(fd, response)) return drop(input);
+          std::string header = response.substr(0, response.find("\r\n\r\n"));
+          if (head.find("Connection: close") != std::string::npos ||
+              header.find("Connection: close") != std::string::npos) return drop(input);
+        }
+        if (closeLimit >= 0 && answered >= closeLimit) return drop(input);
+
+        if (!waitFor(fd)) continue;
+        char buffer[1024];
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) return;
+        input.append(buffer, n);
+      }
+    }
+
+    // Keep the request lines of requests received but not answered as the server closes
+    void drop(const std::string &input) {
+      std::lock_guard<std::mutex> lock(mutex);
+      for (size_t pos = 0, end; (end = input.find("\r\n\r\n", pos)) != std::string::npos; pos = end + 4) {
+        dropped.push_back(input.substr(pos, input.find("\r\n", pos) - pos));
+      }
+    }
+
+    // Send the response as set by pace(), false if the client has gone
+    bool sendPaced(int fd, const std::string &response) {
+      size_t piece = pieceSize, stall = stallAt;
+      uint32_t pause = pauseMs;
+
+      for (size_t pos = 0; pos < response.size() && !done; ) {
+        if (pos >= stall) {
+          // Stalled, wait for the client to give up
+          char buffer[256];
+          while (!done) {
+            if (waitFor(fd) && recv(fd, buffer, sizeof(buffer), 0) <= 0) return false;
+          }
+          return false;
+        }
+
+        size_t n = std::min(std::min(piece, response.size() - pos), stall - pos);
+        ssize_t r = send(fd, response.data() + pos, n, MSG_NOSIGNAL);
+        if (r <= 0) return false;
+        sent += r;
+        pos += r;
+        if (pause && pos < response.size()) std::this_thread::sleep_for(std::chrono::milliseconds(pause));
+      }
+      return true;
+    }
+
+    std::string answer(const std::string &head) {
+      std::string line = head.substr(0, head.find("\r\n"));
+      std::function<std::string(const std::string &)> custom;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        received.push_back(line);
+        custom = responder;
+      }
+      if (custom) return custom(head);
+
+      if (line.compare(0, 5, "GET /") != 0) return reply("400 Bad Request", "{\"cod\":400}");
+      if (line.find("GET /data/2.5/forecast?") == 0) return reply("200 OK", forecast);
+      if (line.find("GET /data/2.5/onecall?") == 0)  return reply("200 OK", onecall);
+      return reply("404 Not Found", "{\"cod\":\"404\",\"message\":\"Not found\"}");
+    }
+
+    static std::string reply(const char *status, const std::string &body) {
+      return std::string("HTTP/1.1 ") + status + "\r\nContent-Type: application/json; charset=utf-8\r\n"
+             "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    }
+
+    // true if fd can be read, waits up to 50 ms so done is checked
+    static bool waitFor(int fd) {
+      pollfd p = { fd, POLLIN, 0 };
+      return poll(&p, 1, 50) > 0;
+    }
+
+    std::string forecast, onecall;
+    int  listener;
+    uint16_t serverPort;
+    std::thread thread;
+    std::atomic<bool> done { false };
+    std::atomic<int> accepted { 0 };
+    std::atomic<size_t> sent { 0 };
+    std::atomic<size_t> pieceSize { SIZE_MAX };
+    std::atomic<size_t> stallAt { SIZE_MAX };
+    std::atomic<uint32_t> pauseMs { 0 };
+    std::atomic<int> closeLimit { -1 };
+    std::mutex mutex;
+    std::vector<std::string> received, dropped;
+    std::function<std::string(const std::string &)> responder;
+};
+
+#endif
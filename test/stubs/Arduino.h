@@ -0,0 +1,145 @@
+// Arduino core stand-in for the host tests, only what the library uses is provided
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+// Program memory is ordinary memory on a host computer
+#define PROGMEM
+#define PSTR(s) (s)
+#define strcmp_P  strcmp
+#define strncmp_P strncmp
+#define strlen_P  strlen
+#define memcpy_P  memcpy
+#define pgm_read_byte(p)  (*(const uint8_t  *)(p))
+#define pgm_read_word(p)  (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_float(p) (*(const float    *)(p))
+#define pgm_read_ptr(p)   (*(void * const   *)(p))
+
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper *)(s))
+
+typedef bool boolean;
+
+/***************************************************************************************
+** Description:   Time and scheduling
+***************************************************************************************/
+inline uint32_t millis() {
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return (uint32_t)duration_cast<milliseconds>(steady_clock::now() - start).count();
+}
+
+inline uint32_t micros() {
+  using namespace std::chrono;
+  static const steady_clock::time_point start = steady_clock::now();
+  return (uint32_t)duration_cast<microseconds>(steady_clock::now() - start).count();
+}
+
+inline void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+inline void yield()            { std::this_thread::yield(); }
+
+inline long random(long max)           { return max > 0 ? rand() % max : 0; }
+inline long random(long min, long max) { return max > min ? min + rand() % (max - min) : min; }
+
+/***************************************************************************************
+** Description:   String, held in a std::string so heap use can be counted by the tests
+***************************************************************************************/
+class String {
+
+  public:
+    String() { }
+    String(const char *s)        { if (s) text = s; }
+    String(const __FlashStringHelper *s) : String((const char *)s) { }
+    String(const std::string &s) : text(s) { }
+    String(char c)               : text(1, c) { }
+    String(int v)                : text(std::to_string(v)) { }
+    String(unsigned int v)       : text(std::to_string(v)) { }
+    String(long v)               : text(std::to_string(v)) { }
+    String(unsigned long v)      : text(std::to_string(v)) { }
+    String(float v, int places = 2)  { format(v, places); }
+    String(double v, int places = 2) { format(v, places); }
+
+    const char *c_str() const  { return text.c_str(); }
+    unsigned    length() const { return text.size(); }
+    bool        reserve(unsigned size) { text.reserve(size); return true; }
+
+    long  toInt()   const { return atol(text.c_str()); }
+    float toFloat() const { return (float)atof(text.c_str()); }
+
+    String &operator+=(const String &s) { text += s.text; return *this; }
+    String &operator+=(const char *s)   { text += s; return *this; }
+    String &operator+=(char c)          { text += c; return *this; }
+
+    bool operator==(const String &s) const { return text == s.text; }
+    bool operator==(const char *s) const   { return text == s; }
+    bool operator!=(const String &s) const { return text != s.text; }
+    bool operator!=(const char *s) const   { return text != s; }
+    char operator[](unsigned i) const      { return text[i]; }
+
+    int    indexOf(char c) const { size_t i = text.find(c); return i == std::string::npos ? -1 : (int)i; }
+    String substring(unsigned from) const              { return text.substr(from); }
+    String substring(unsigned from, unsigned to) const { return text.substr(from, to - from); }
+
+  private:
+    void format(double v, int places) {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "%.*f", places, v);
+      text = buf;
+    }
+
+    std::string text;
+};
+
+inline String operator+(const String &a, const String &b) { String s(a); s += b; return s; }
+inline String operator+(const String &a, const char *b)   { String s(a); s += b; return s; }
+inline String operator+(const char *a, const String &b)   { String s(a); s += b; return s; }
+
+/***************************************************************************************
+** Description:   Serial port, output goes to stdout unless quiet is set
+***************************************************************************************/
+class HardwareSerial {
+
+  public:
+    bool quiet = false; // Set by the tests to hide the library status messages
+
+    void begin(unsigned long) { }
+
+    void print(const __FlashStringHelper *s) { out("%s", (const char *)s); }
+    void print(const String &s)   { out("%s", s.c_str()); }
+    void print(const char *s)     { out("%s", s); }
+    void print(char c)            { out("%c", c); }
+    void print(int v)             { out("%d", v); }
+    void print(unsigned int v)    { out("%u", v); }
+    void print(long v)            { out("%ld", v); }
+    void print(unsigned long v)   { out("%lu", v); }
+    void print(double v, int places = 2) { out("%.*f", places, v); }
+
+    template <typename T> void println(const T &v) { print(v); println(); }
+    void println() { out("\n"); }
+
+    size_t write(uint8_t c) { out("%c", c); return 1; }
+
+    template <typename... A> void printf(const char *format, A... a) { out(format, a...); }
+
+  private:
+    template <typename... A> void out(const char *format, A... a) {
+      if (!quiet) ::printf(format, a...);
+    }
+};
+
+extern HardwareSerial Serial;
+
+#include "IPAddress.h"
+
+#endif
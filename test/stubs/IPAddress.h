@@ -0,0 +1,24 @@
+// IPv4 address stand-in for the host tests
+
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include <stdint.h>
+#include <string.h>
+
+class IPAddress {
+
+  public:
+    IPAddress() { }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) { bytes[0] = a; bytes[1] = b; bytes[2] = c; bytes[3] = d; }
+    IPAddress(uint32_t address) { memcpy(bytes, &address, 4); }
+
+    operator uint32_t() const { uint32_t a; memcpy(&a, bytes, 4); return a; }
+    uint8_t operator[](int i) const { return bytes[i]; }
+    bool operator==(const IPAddress &ip) const { return (uint32_t)*this == (uint32_t)ip; }
+
+  private:
+    uint8_t bytes[4] = { 0, 0, 0, 0 };
+};
+
+#endif
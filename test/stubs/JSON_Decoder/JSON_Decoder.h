@@ -0,0 +1,148 @@
+// Stand-in for the JSON_Decoder.h of https://github.com/Bodmer/JSON_Decoder, used by the
+// host tests only when that library is not found, see test/CMakeLists.txt
+
+// A small streaming decoder with the same listener callbacks: key() and value() get the
+// text without quotes or escapes, numbers and literals are reported by value() when the
+// character after them arrives, and error() is called for malformed JSON. Like the real
+// one it has fixed size buffers, so parsing does not allocate memory.
+
+#ifndef JSON_Decoder_h
+#define JSON_Decoder_h
+
+#include <ctype.h>
+#include <stdint.h>
+
+#include "JSON_Listener.h"
+
+class JSON_Decoder {
+
+  public:
+    void setListener(JsonListener *listener) { this->listener = listener; }
+
+    void reset() {
+      state = START;
+      depth = 0;
+      length = 0;
+      escape = false;
+    }
+
+    void parse(char c) {
+      switch (state) {
+        case DONE: return;
+
+        case STRING:
+          if (escape)         { add(c); escape = false; }
+          else if (c == '\\') escape = true;
+          else if (c == '"')  endString();
+          else                add(c);
+          return;
+
+        case SCALAR:
+          if (isalnum((unsigned char)c) || c == '.' || c == '-' || c == '+') { add(c); return; }
+          listener->value(text());
+          endValue();
+          break; // c follows the value
+
+        default: break;
+      }
+
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\n') { listener->whitespace(c); return; }
+
+      switch (state) {
+        case START:
+          if (c == '{' || c == '[') { listener->startDocument(); open(c); }
+          else listener->error("Document must start with { or [");
+          return;
+
+        case COLON:
+          if (c == ':') state = VALUE;
+          else listener->error("Expected :");
+          return;
+
+        case KEY:
+          if (c == '"')      { state = STRING; isKey = true; }
+          else if (c == '}') close(c);
+          else listener->error("Expected key");
+          return;
+
+        case VALUE:
+          if (c == '"')                  { state = STRING; isKey = false; }
+          else if (c == '{' || c == '[') open(c);
+          else if (c == ']')             close(c);
+          else { add(c); state = SCALAR; }
+          return;
+
+        case AFTER_VALUE:
+          if (c == ',')                  state = nesting[depth - 1] == '{' ? KEY : VALUE;
+          else if (c == '}' || c == ']') close(c);
+          else listener->error("Expected , } or ]");
+          return;
+
+        default: return;
+      }
+    }
+
+  private:
+    enum State { START, KEY, COLON, VALUE, STRING, SCALAR, AFTER_VALUE, DONE };
+
+    enum { BUFFER_SIZE = 512, MAX_DEPTH = 32 };
+
+    void add(char c) { if (length < BUFFER_SIZE - 1) buffer[length++] = c; }
+
+    // The text collected, then empty for the next
+    const char *text() {
+      buffer[length] = 0;
+      length = 0;
+      return buffer;
+    }
+
+    void open(char c) {
+      if (depth == MAX_DEPTH) {
+        listener->error("Nesting too deep");
+        return;
+      }
+      nesting[depth++] = c;
+      if (c == '{') { listener->startObject(); state = KEY; }
+      else          { listener->startArray();  state = VALUE; }
+    }
+
+    void close(char c) {
+      if (depth == 0 || nesting[depth - 1] != (c == '}' ? '{' : '[')) {
+        listener->error("Unbalanced brackets");
+        return;
+      }
+      depth--;
+      if (c == '}') listener->endObject();
+      else          listener->endArray();
+
+      if (depth == 0) {
+        listener->endDocument();
+        state = DONE;
+      }
+      else endValue();
+    }
+
+    void endString() {
+      if (isKey) {
+        listener->key(text());
+        state = COLON;
+      }
+      else {
+        listener->value(text());
+        endValue();
+      }
+    }
+
+    void endValue() { state = AFTER_VALUE; }
+
+    JsonListener *listener = nullptr;
+    State    state = START;
+    char     nesting[MAX_DEPTH]; // '{' or '[' for each level
+    uint8_t  depth = 0;
+    char     buffer[BUFFER_SIZE]; // Key or value text
+    uint16_t length = 0;
+    bool     escape = false;
+    bool     isKey = false;       // The string is an object member name
+};
+
+#endif
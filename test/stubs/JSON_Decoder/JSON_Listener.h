@@ -0,0 +1,24 @@
+// Stand-in for the JSON_Listener.h of https://github.com/Bodmer/JSON_Decoder, used by the
+// host tests only when that library is not found, see test/CMakeLists.txt
+
+#ifndef JSON_Listener_h
+#define JSON_Listener_h
+
+class JsonListener {
+
+  public:
+    virtual ~JsonListener() { }
+
+    virtual void whitespace(char c) = 0;
+    virtual void startDocument() = 0;
+    virtual void key(const char *key) = 0;
+    virtual void value(const char *value) = 0;
+    virtual void endArray() = 0;
+    virtual void endObject() = 0;
+    virtual void endDocument() = 0;
+    virtual void startArray() = 0;
+    virtual void startObject() = 0;
+    virtual void error(const char *message) = 0;
+};
+
+#endif
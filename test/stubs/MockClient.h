@@ -0,0 +1,93 @@
+// Client that replays recorded server responses, for the host tests
+
+// Given to the library with setClient(). Each connection is sent the next queued
+// response, or with keepAlive set, each GET request is sent the next queued response
+// and the connection is left open as a keep-alive server would.
+
+#ifndef MockClient_h
+#define MockClient_h
+
+#include <Client.h>
+#include <algorithm>
+#include <deque>
+#include <string>
+
+class MockClient : public Client {
+
+  public:
+    std::deque<std::string> responses; // Queued responses, header and body
+    std::string sent;                  // Everything written by the library
+    std::string host;                  // Last host name or address connected to
+    size_t   maxRead = SIZE_MAX;       // Most bytes returned by one read() or available()
+    bool     keepAlive = false;        // One response per GET, connection kept open
+    bool     refuse = false;           // Connections fail
+    uint32_t refuseAddress = 0;        // Connections to this address fail, 0 for none
+    int      connects = 0;             // Connections made
+
+    int connect(IPAddress ip, uint16_t port) override {
+      if (refuseAddress && (uint32_t)ip == refuseAddress) return 0;
+      char name[16];
+      snprintf(name, sizeof(name), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+      return connect(name, port);
+    }
+
+    int connect(const char *name, uint16_t) override {
+      if (refuse) return 0;
+      host = name;
+      connects++;
+      open = true;
+      input.clear();
+      pos = 0;
+      if (!keepAlive) next();
+      return 1;
+    }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+
+    size_t write(const uint8_t *buf, size_t size) override {
+      if (!open) return 0;
+      std::string text((const char *)buf, size);
+      sent += text;
+      if (keepAlive) {
+        for (size_t i = text.find("GET "); i != std::string::npos; i = text.find("GET ", i + 4)) next();
+      }
+      return size;
+    }
+
+    int available() override { return open ? (int)std::min(input.size() - pos, maxRead) : 0; }
+
+    int read() override {
+      if (!open || pos >= input.size()) return -1;
+      return (uint8_t)input[pos++];
+    }
+
+    int read(uint8_t *buf, size_t size) override {
+      size_t n = std::min(size, (size_t)available());
+      if (!n) return -1;
+      memcpy(buf, input.data() + pos, n);
+      pos += n;
+      return (int)n;
+    }
+
+    int  peek() override  { return open && pos < input.size() ? (uint8_t)input[pos] : -1; }
+    void flush() override { }
+    void stop() override  { open = false; }
+
+    // A server without keep-alive closes once the response is sent, the unread bytes
+    // can still be read
+    uint8_t connected() override { return open && (keepAlive || pos < input.size()); }
+    operator bool() override { return open; }
+
+  private:
+    void next() {
+      if (responses.empty()) return;
+      input += responses.front();
+      responses.pop_front();
+    }
+
+    std::string input;   // Bytes sent by the server on this connection
+    size_t      pos = 0; // Bytes read by the library
+    bool        open = false;
+};
+
+#endif
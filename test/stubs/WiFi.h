@@ -0,0 +1,48 @@
+// WiFi library stand-in for the host tests
+
+// The host tests give the library a client with setClient(), so the built in clients
+// are only here to compile the library and never connect.
+
+#ifndef WiFi_h
+#define WiFi_h
+
+#include <Client.h>
+
+class WiFiClient : public Client {
+
+  public:
+    int     connect(IPAddress, uint16_t) override { return 0; }
+    int     connect(const char *, uint16_t) override { return 0; }
+    size_t  write(uint8_t) override { return 0; }
+    size_t  write(const uint8_t *, size_t) override { return 0; }
+    int     available() override { return 0; }
+    int     read() override { return -1; }
+    int     read(uint8_t *, size_t) override { return -1; }
+    int     peek() override { return -1; }
+    void    flush() override { }
+    void    stop() override { }
+    uint8_t connected() override { return 0; }
+    operator bool() override { return false; }
+};
+
+class WiFiClientSecure : public WiFiClient {
+
+  public:
+    using WiFiClient::connect;
+    void setInsecure() { }
+    int  connect(IPAddress, uint16_t, const char *, const char *, const char *, const char *) { return 0; }
+};
+
+namespace BearSSL {
+  class WiFiClientSecure : public ::WiFiClientSecure { };
+}
+
+class WiFiClass {
+
+  public:
+    int hostByName(const char *, IPAddress &) { return 0; }
+};
+
+extern WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,7 @@
+// Arduino globals for the host tests
+
+#include <Arduino.h>
+#include <WiFi.h>
+
+HardwareSerial Serial;
+WiFiClass WiFi;
@@ -0,0 +1,169 @@
+// Heap allocations during a request, counted by replacing operator new
+
+// The parser state (key IDs, nesting stack, slot indexes) is held in OW_Weather, so a
+// request into structs without String members must make no allocations at all once
+// the first request has been made. The String members of OW_forecast are allocated by
+// the struct, the count is only reported.
+
+#include <Arduino.h>
+#include <OpenWeather.h>
+#include <new>
+
+#include "test_util.h"
+
+static size_t allocations = 0;
+
+#if !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#if defined(__GNUC__) && !defined(__clang__) && (__GNUC__ >= 11)
+  #pragma GCC diagnostic ignored "-Wmismatched-new-delete" // new is malloc here
+#endif
+
+void *operator new(size_t size)
+{
+  allocations++;
+  void *p = malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+#define COUNTING true
+#else
+#define COUNTING false // The sanitizer has its own operator new
+#endif
+
+// Client that replays one response without allocating, unlike MockClient
+class ResponseClient : public Client {
+
+  public:
+    const std::string *response = nullptr;
+
+    int     connect(IPAddress, uint16_t) override { return 0; }
+    int     connect(const char *, uint16_t) override { pos = 0; open = true; return 1; }
+    size_t  write(uint8_t) override { return 1; }
+    size_t  write(const uint8_t *, size_t size) override { return size; }
+    int     available() override { return open ? (int)(response->size() - pos) : 0; }
+    int     read() override { return pos < response->size() ? (uint8_t)(*response)[pos++] : -1; }
+    int     read(uint8_t *buf, size_t size) override {
+      size_t n = std::min(size, response->size() - pos);
+      memcpy(buf, response->data() + pos, n);
+      pos += n;
+      return n ? (int)n : -1;
+    }
+    int     peek() override { return pos < response->size() ? (uint8_t)(*response)[pos] : -1; }
+    void    flush() override { }
+    void    stop() override { open = false; }
+    uint8_t connected() override { return open && pos < response->size(); }
+    operator bool() override { return open; }
+
+  private:
+    size_t pos = 0;
+    bool   open = false;
+};
+
+struct Forecast {
+  uint32_t dt[MAX_3HRS];
+  float    temp[MAX_3HRS];
+  uint16_t id[MAX_3HRS];
+  uint8_t  night[(MAX_3HRS + 7) / 8];
+  float    pop[MAX_3HRS];
+  int32_t  timezone;
+  uint32_t sunrise;
+};
+
+static const OW_Field forecastFields[] = {
+  OW_FIELD(Forecast, dt,       LIST, LIST, DT),
+  OW_FIELD(Forecast, temp,     LIST, MAIN, TEMP),
+  OW_FIELD(Forecast, id,       LIST, WEATHER, ID),
+  OW_FIELD_NIGHT(Forecast, night, MAX_3HRS, LIST, WEATHER),
+  OW_FIELD(Forecast, pop,      LIST, LIST, POP),
+  OW_FIELD(Forecast, timezone, CITY, CITY, TIMEZONE),
+  OW_FIELD(Forecast, sunrise,  CITY, CITY, SUNRISE),
+};
+
+struct Current {
+  uint32_t dt;
+  float    temp;
+  uint16_t id;
+};
+
+struct Daily {
+  uint32_t dt[MAX_DAYS];
+  float    temp_max[MAX_DAYS];
+};
+
+static const OW_Field currentFields[] = {
+  OW_FIELD(Current, dt,   CURRENT, CURRENT, DT),
+  OW_FIELD(Current, temp, CURRENT, CURRENT, TEMP),
+  OW_FIELD(Current, id,   CURRENT, WEATHER, ID),
+};
+
+static const OW_Field dailyFields[] = {
+  OW_FIELD(Daily, dt,       DAILY, DAILY, DT),
+  OW_FIELD(Daily, temp_max, DAILY, TEMP, MAX),
+};
+
+int main()
+{
+  Serial.quiet = true;
+
+  std::string forecastResponse = httpResponse(readFile("forecast.json"));
+  std::string onecallResponse = httpResponse(readFile("onecall.json"));
+
+  ResponseClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+
+  // Made before counting, a host String holds these without allocating anyway
+  String key("key"), lat("51.5085"), lon("-0.1257"), units("metric"), lang("en");
+
+  Forecast *forecast = new Forecast;
+  Current  *current  = new Current;
+  Daily    *daily    = new Daily;
+  OW_forecast *strings = new OW_forecast;
+
+  // The first request of each kind may set up buffers that are kept
+  client.response = &forecastResponse;
+  CHECK(ow.getForecast(OW_dataSet(forecast, forecastFields), key, lat, lon, units, lang));
+  client.response = &onecallResponse;
+  CHECK(ow.getForecast(OW_dataSet(current, currentFields), OW_dataSet(), OW_dataSet(daily, dailyFields),
+                       key, lat, lon, units, lang));
+
+  size_t start = allocations;
+  client.response = &forecastResponse;
+  memset(forecast, 0, sizeof(Forecast));
+  CHECK(ow.getForecast(OW_dataSet(forecast, forecastFields), key, lat, lon, units, lang));
+  CHECK(forecast->dt[MAX_3HRS - 1] != 0 && forecast->sunrise != 0);
+  size_t forecastAllocations = allocations - start;
+
+  start = allocations;
+  client.response = &onecallResponse;
+  memset(daily, 0, sizeof(Daily));
+  CHECK(ow.getForecast(OW_dataSet(current, currentFields), OW_dataSet(), OW_dataSet(daily, dailyFields),
+                       key, lat, lon, units, lang));
+  CHECK(daily->dt[MAX_DAYS - 1] != 0);
+  size_t onecallAllocations = allocations - start;
+
+  start = allocations;
+  client.response = &forecastResponse;
+  CHECK(ow.getForecast(strings, key, lat, lon, units, lang));
+  size_t stringAllocations = allocations - start;
+
+  if (COUNTING) {
+    ::printf("Allocations per request: forecast %zu, onecall %zu, OW_forecast with String members %zu\n",
+             forecastAllocations, onecallAllocations, stringAllocations);
+    CHECK(forecastAllocations == 0);
+    CHECK(onecallAllocations == 0);
+  }
+  else ::printf("Built with a sanitizer, allocations not counted\n");
+
+  delete forecast;
+  delete current;
+  delete daily;
+  delete strings;
+  return testResult("test_allocations");
+}
@@ -0,0 +1,118 @@
+// Reuse of an OW_Arena over many updates, as the TFT_eSPI_OpenWeather_LittleFS example does
+
+// Each update resets the arena, creates the struct in it and parses the forecast with
+// the text held in the arena. The bytes used must be the same for every update, so the
+// arena does not creep, and the high water mark must not grow past the first update.
+// Identical text is stored once, and a full arena gives "" for text and nullptr for
+// structs instead of writing past its end.
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+
+#include "test_util.h"
+
+#define UPDATES 1000
+
+struct Forecast {
+  uint32_t    dt[MAX_3HRS];
+  float       temp[MAX_3HRS];
+  const char *description[MAX_3HRS];
+  const char *dt_txt[MAX_3HRS];
+  const char *city_name;
+  uint32_t    sunset;
+};
+
+static const OW_Field forecastFields[] = {
+  OW_FIELD(Forecast, dt,          LIST, LIST, DT),
+  OW_FIELD(Forecast, temp,        LIST, MAIN, TEMP),
+  OW_FIELD(Forecast, description, LIST, WEATHER, DESCRIPTION),
+  OW_FIELD(Forecast, dt_txt,      LIST, LIST, DT_TXT),
+  OW_FIELD(Forecast, city_name,   CITY, CITY, NAME),
+  OW_FIELD(Forecast, sunset,      CITY, CITY, SUNSET),
+};
+
+static uint8_t arenaBuffer[8192];
+
+int main()
+{
+  Serial.quiet = true;
+
+  MockClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+
+  std::string response = httpResponse(readFile("forecast.json"));
+  OW_Arena arena(arenaBuffer, sizeof(arenaBuffer));
+  CHECK(arena.size() == sizeof(arenaBuffer) && arena.used() == 0 && arena.highWater() == 0);
+
+  Forecast *forecast = nullptr;
+  size_t used = 0;
+  int failed = 0;
+  for (int i = 0; i < UPDATES; i++) {
+    arena.reset();
+    CHECK(arena.used() == 0);
+
+    forecast = arena.create<Forecast>();
+    CHECK(forecast != nullptr);
+    ow.setArena(&arena);
+    client.responses.push_back(response);
+    bool ok = ow.getForecast(OW_dataSet(forecast, forecastFields), "key", "0", "0", "metric", "en");
+
+    ok = ok && forecast->sunset != 0 && strcmp(forecast->city_name, "London") == 0;
+    ok = ok && strcmp(forecast->dt_txt[MAX_3HRS - 1], "2023-11-18 21:00:00") == 0;
+    if (i == 0) used = arena.used();
+    ok = ok && arena.used() == used && arena.highWater() == used;
+    if (!ok && failed++ < 5) ::printf("update %d: used %zu, high water %zu\n", i, arena.used(), arena.highWater());
+  }
+  CHECK(failed == 0);
+  ::printf("%d updates, arena used %zu of %zu bytes, high water mark %zu\n",
+           UPDATES, used, arena.size(), arena.highWater());
+
+  // Identical text is held once
+  int shared = 0;
+  for (int i = 0; i < MAX_3HRS; i++) {
+    for (int j = 0; j < i; j++) {
+      if (strcmp(forecast->description[i], forecast->description[j]) == 0) {
+        CHECK(forecast->description[i] == forecast->description[j]);
+        shared++;
+        break;
+      }
+    }
+  }
+  CHECK(shared > 0);
+
+  // reset() keeps the high water mark, a smaller use does not lower it
+  arena.reset();
+  CHECK(arena.alloc(16) != nullptr);
+  CHECK(arena.used() == 16 && arena.highWater() == used);
+
+  // A full arena, the struct is not created and text is ""
+  static uint8_t small[sizeof(Forecast) + 64];
+  OW_Arena full(small, sizeof(small));
+  CHECK(full.create<Forecast>() != nullptr);
+  CHECK(full.create<Forecast>() == nullptr);
+  CHECK(full.alloc(sizeof(small)) == nullptr);
+
+  full.reset();
+  forecast = full.create<Forecast>();
+  ow.setArena(&full);
+  client.responses.push_back(response);
+  CHECK(ow.getForecast(OW_dataSet(forecast, forecastFields), "key", "0", "0", "metric", "en"));
+  CHECK(forecast->sunset != 0);
+  CHECK(strcmp(forecast->city_name, "") == 0);
+  CHECK(strcmp(forecast->dt_txt[MAX_3HRS - 1], "") == 0);
+  CHECK(full.used() <= full.size() && full.highWater() <= full.size());
+
+  // Without an arena text is ""
+  ow.setArena(nullptr);
+  client.responses.push_back(response);
+  CHECK(ow.getForecast(OW_dataSet(forecast, forecastFields), "key", "0", "0", "metric", "en"));
+  CHECK(strcmp(forecast->description[0], "") == 0);
+
+  // An arena taken from the heap
+  OW_Arena heap(4096);
+  CHECK(heap.size() == 4096 && heap.alloc(4096, 1) != nullptr && heap.alloc(1, 1) == nullptr);
+
+  return testResult("test_arena");
+}
@@ -0,0 +1,89 @@
+// Chunked transfer encoding with random chunk boundaries and read sizes
+
+// The forecast response is sent chunked with random chunk sizes, hex case, chunk
+// extensions and trailers, and read by the library 1 to 97 bytes at a time, so chunk
+// size lines and CRLFs are split across reads in every way. Each must parse to the same
+// values as the Content-Length response. Two chunked responses on a kept open
+// connection check the body end is found without reading into the next response.
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+
+#include "test_util.h"
+
+// Values compared with memcmp, so no String members
+struct Forecast {
+  uint32_t dt[MAX_3HRS];
+  float    temp[MAX_3HRS];
+  uint16_t id[MAX_3HRS];
+  float    pop[MAX_3HRS];
+  uint32_t sunrise;
+};
+
+static const OW_Field forecastFields[] = {
+  OW_FIELD(Forecast, dt,      LIST, LIST, DT),
+  OW_FIELD(Forecast, temp,    LIST, MAIN, TEMP),
+  OW_FIELD(Forecast, id,      LIST, WEATHER, ID),
+  OW_FIELD(Forecast, pop,     LIST, LIST, POP),
+  OW_FIELD(Forecast, sunrise, CITY, CITY, SUNRISE),
+};
+
+int main()
+{
+  Serial.quiet = true;
+
+  std::string body = readFile("forecast.json");
+  MockClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+
+  Forecast *expected = new Forecast;
+  Forecast *parsed = new Forecast;
+  memset(expected, 0, sizeof(Forecast));
+  client.responses.push_back(httpResponse(body));
+  CHECK(ow.getForecast(OW_dataSet(expected, forecastFields), "key", "0", "0", "metric", "en"));
+  CHECK(expected->dt[MAX_3HRS - 1] != 0);
+
+  // Random chunks, small ones for some seeds so most reads end in a size line
+  int failed = 0;
+  for (unsigned seed = 0; seed < 400; seed++) {
+    client.maxRead = 1 + seed % 97;
+    client.responses.push_back(chunkedResponse(body, seed, (seed % 4 == 0) ? 8 : 600));
+
+    memset(parsed, 0, sizeof(Forecast));
+    bool ok = ow.getForecast(OW_dataSet(parsed, forecastFields), "key", "0", "0", "metric", "en");
+    if (!ok || memcmp(parsed, expected, sizeof(Forecast)) != 0) {
+      if (failed++ < 5) ::printf("seed %u, read size %zu: ok %d\n", seed, client.maxRead, ok);
+    }
+  }
+  CHECK(failed == 0);
+
+  // Kept open connection, the second response follows the first
+  client.keepAlive = true;
+  ow.keepAlive(true);
+  for (unsigned seed = 0; seed < 20; seed++) {
+    client.maxRead = 1 + seed * 5;
+    for (int i = 0; i < 2; i++) {
+      client.responses.push_back(chunkedResponse(body, seed * 2 + i, 300));
+      memset(parsed, 0, sizeof(Forecast));
+      CHECK(ow.getForecast(OW_dataSet(parsed, forecastFields), "key", "0", "0", "metric", "en"));
+      CHECK(memcmp(parsed, expected, sizeof(Forecast)) == 0);
+    }
+  }
+  CHECK(client.connects == 401 + 1);
+  ow.keepAlive(false);
+  client.keepAlive = false;
+
+  // A bad chunk size fails the request instead of waiting for the timeout
+  client.maxRead = SIZE_MAX;
+  client.responses.push_back("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                             "5\r\n{\"cod\r\nzz\r\n\"200\"}\r\n0\r\n\r\n");
+  uint32_t start = millis();
+  CHECK(!ow.getForecast(OW_dataSet(parsed, forecastFields), "key", "0", "0", "metric", "en"));
+  CHECK(millis() - start < 1000);
+
+  delete expected;
+  delete parsed;
+  return testResult("test_chunked");
+}
@@ -0,0 +1,135 @@
+// Precision of OW_forecast_compact, the scaled integer values against the OW_forecast floats
+
+// The forecast response is parsed into both structs. The server sends temperatures,
+// wind speeds and pop to 0.01, so each scaled value must be the float value rounded to
+// 0.01 and the accessors must be within float rounding of the float members. Visibility
+// is kept in decametres, so within 5 metres. A second response has values with more
+// decimal places, out of range values and exponent notation to check the rounding and
+// the limits of each type.
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+#include <cmath>
+
+#include "test_util.h"
+
+static bool near(float a, float b, float limit) { return fabsf(a - b) <= limit; }
+
+// One "list" element
+static std::string slot(const char *temp, const char *speed, const char *pop, const char *visibility)
+{
+  char text[512];
+  snprintf(text, sizeof(text),
+    "{\"dt\": 1700000000, \"main\": {\"temp\": %s, \"feels_like\": %s, \"temp_min\": %s, \"temp_max\": %s, "
+    "\"pressure\": 1013, \"humidity\": 80}, \"weather\": [{\"id\": 500, \"main\": \"Rain\", "
+    "\"description\": \"light rain\", \"icon\": \"10n\"}], \"clouds\": {\"all\": 75}, "
+    "\"wind\": {\"speed\": %s, \"deg\": 270, \"gust\": %s}, \"visibility\": %s, \"pop\": %s}",
+    temp, temp, temp, temp, speed, speed, visibility, pop);
+  return text;
+}
+
+int main()
+{
+  Serial.quiet = true;
+
+  MockClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+
+  OW_forecast *forecast = new OW_forecast;
+  OW_forecast_compact *compact = new OW_forecast_compact;
+
+  std::string response = httpResponse(readFile("forecast.json"));
+  client.responses.push_back(response);
+  CHECK(ow.getForecast(forecast, "key", "0", "0", "metric", "en"));
+  client.responses.push_back(response);
+  CHECK(ow.getForecast(compact, "key", "0", "0", "metric", "en"));
+  CHECK(forecast->dt[MAX_3HRS - 1] != 0);
+
+  // Values sent to 0.01 are kept exactly
+  int failed = 0;
+  for (int i = 0; i < MAX_3HRS; i++) {
+    bool ok =
+      compact->temp_x100[i]       == lround(forecast->temp[i] * 100.0)       &&
+      compact->feels_like_x100[i] == lround(forecast->feels_like[i] * 100.0) &&
+      compact->temp_min_x100[i]   == lround(forecast->temp_min[i] * 100.0)   &&
+      compact->temp_max_x100[i]   == lround(forecast->temp_max[i] * 100.0)   &&
+      compact->wind_speed_x100[i] == lround(forecast->wind_speed[i] * 100.0) &&
+      compact->wind_gust_x100[i]  == lround(forecast->wind_gust[i] * 100.0)  &&
+      compact->pop_x100[i]        == lround(forecast->pop[i] * 100.0);
+
+    // The accessors return the float values to within float rounding
+    ok = ok &&
+      near(compact->temp(i),       forecast->temp[i],       1e-5f * (1 + fabsf(forecast->temp[i])))  &&
+      near(compact->feels_like(i), forecast->feels_like[i], 1e-5f * (1 + fabsf(forecast->feels_like[i]))) &&
+      near(compact->temp_min(i),   forecast->temp_min[i],   1e-5f * (1 + fabsf(forecast->temp_min[i]))) &&
+      near(compact->temp_max(i),   forecast->temp_max[i],   1e-5f * (1 + fabsf(forecast->temp_max[i]))) &&
+      near(compact->wind_speed(i), forecast->wind_speed[i], 1e-5f * (1 + forecast->wind_speed[i])) &&
+      near(compact->wind_gust(i),  forecast->wind_gust[i],  1e-5f * (1 + forecast->wind_gust[i]))  &&
+      near(compact->pop(i),        forecast->pop[i],        1e-6f);
+
+    // Whole number values
+    ok = ok &&
+      compact->pressure[i]   == forecast->pressure[i]   &&
+      compact->sea_level[i]  == forecast->sea_level[i]  &&
+      compact->grnd_level[i] == forecast->grnd_level[i] &&
+      compact->humidity[i]   == forecast->humidity[i]   &&
+      compact->clouds_all[i] == forecast->clouds_all[i] &&
+      compact->wind_deg[i]   == forecast->wind_deg[i]   &&
+      compact->id[i]         == forecast->id[i]         &&
+      compact->dt[i]         == forecast->dt[i]         &&
+      labs((long)compact->visibility(i) - (long)forecast->visibility[i]) <= 5;
+
+    if (!ok && failed++ < 5) ::printf("slot %d differs\n", i);
+  }
+  CHECK(failed == 0);
+  CHECK(compact->city_name == forecast->city_name);
+  CHECK(compact->sunrise == forecast->sunrise && compact->sunset == forecast->sunset);
+  CHECK(compact->timezone == forecast->timezone);
+
+  // Rounding and limits
+  std::string body = "{\"cod\": \"200\", \"list\": [" +
+    slot("12.345",  "12.5",  "0.125",  "12345")  + ", " +
+    slot("-12.345", "0.004", "0.994",  "10000")  + ", " +
+    slot("-0.004",  "0.005", "1",      "4")      + ", " +
+    slot("327.67",  "1e1",   "2",      "700000") + ", " +
+    slot("400",     "-1e9",  "-0.5",   "-10")    + ", " +
+    slot("-400",    "99999999999", "0", "655355") + "]}";
+  memset(compact->temp_x100, 0, sizeof(compact->temp_x100));
+  client.responses.push_back(httpResponse(body));
+  CHECK(ow.getForecast(compact, "key", "0", "0", "metric", "en"));
+
+  CHECK(compact->temp_x100[0] == 1235);   // Half rounds away from zero
+  CHECK(compact->temp_x100[1] == -1235);
+  CHECK(compact->temp_x100[2] == 0);
+  CHECK(compact->temp_x100[3] == 32767);
+  CHECK(compact->temp_x100[4] == 32767);  // Limited to the type range
+  CHECK(compact->temp_x100[5] == -32768);
+  CHECK(compact->temp_min_x100[0] == 1235 && compact->feels_like_x100[5] == -32768);
+
+  CHECK(compact->wind_speed_x100[0] == 1250);
+  CHECK(compact->wind_speed_x100[1] == 0);
+  CHECK(compact->wind_speed_x100[2] == 1);
+  CHECK(compact->wind_speed_x100[3] == 1000); // Exponent notation
+  CHECK(compact->wind_speed_x100[4] == -32768);
+  CHECK(compact->wind_speed_x100[5] == 32767);
+
+  CHECK(compact->pop_x100[0] == 13);
+  CHECK(compact->pop_x100[1] == 99);
+  CHECK(compact->pop_x100[2] == 100);
+  CHECK(compact->pop_x100[3] == 200);
+  CHECK(compact->pop_x100[4] == 0);
+
+  CHECK(compact->visibility(0) == 12350);
+  CHECK(compact->visibility(1) == 10000);
+  CHECK(compact->visibility(2) == 0);
+  CHECK(compact->visibility_dam[3] == 65535);
+  CHECK(compact->visibility_dam[4] == 0);
+  CHECK(compact->visibility_dam[5] == 65535);
+  CHECK(near(compact->temp(0), 12.35f, 1e-5f) && near(compact->pop(2), 1.0f, 1e-6f));
+
+  delete forecast;
+  delete compact;
+  return testResult("test_compact");
+}
@@ -0,0 +1,114 @@
+// Struct size and heap held for the weather condition text, built twice: with the
+// main, description and icon Strings (test_conditions_text), and with OW_CONDITION_TABLE
+// holding only the id and a day/night bit (test_conditions_table)
+
+// Each build reports sizeof the library structs and the heap their Strings hold after
+// parsing the sample responses, so the two lines of output compare the layouts. The heap
+// is counted as an Arduino String takes it, one block of length + 1 bytes for each String
+// holding text, as the host String keeps short text inside the object. The table build
+// also checks the text looked up for each slot is the text the server sent.
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+
+#include "test_util.h"
+
+static size_t blocks = 0, bytes = 0;
+
+static void heap(const String *s, int n = 1)
+{
+  for (int i = 0; i < n; i++) {
+    if (s[i].length() == 0) continue;
+    blocks++;
+    bytes += s[i].length() + 1;
+  }
+}
+
+#ifdef OW_CONDITION_TABLE
+// The text as sent, to check the table against
+struct Text {
+  uint16_t id[MAX_3HRS];
+  String   main[MAX_3HRS];
+  String   description[MAX_3HRS];
+  String   icon[MAX_3HRS];
+};
+
+static const OW_Field textFields[] = {
+  OW_FIELD(Text, id,          LIST, WEATHER, ID),
+  OW_FIELD(Text, main,        LIST, WEATHER, MAIN),
+  OW_FIELD(Text, description, LIST, WEATHER, DESCRIPTION),
+  OW_FIELD(Text, icon,        LIST, WEATHER, ICON),
+};
+#endif
+
+int main()
+{
+  Serial.quiet = true;
+
+  MockClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+
+  OW_forecast *forecast = new OW_forecast;
+  OW_current  *current  = new OW_current;
+  OW_hourly   *hourly   = new OW_hourly;
+  OW_daily    *daily    = new OW_daily;
+
+  client.responses.push_back(httpResponse(readFile("forecast.json")));
+  client.responses.push_back(httpResponse(readFile("onecall.json")));
+  CHECK(ow.getForecast(forecast, "key", "0", "0", "metric", "en"));
+  CHECK(ow.getForecast(current, hourly, daily, "key", "0", "0", "metric", "en"));
+  CHECK(forecast->id[MAX_3HRS - 1] != 0 && daily->id[MAX_DAYS - 1] != 0);
+
+  heap(forecast->dt_txt, MAX_3HRS);
+  heap(&forecast->city_name);
+#ifndef OW_CONDITION_TABLE
+  heap(&current->main);
+  heap(&current->description);
+  heap(&current->icon);
+  heap(hourly->main, MAX_HOURS);
+  heap(hourly->description, MAX_HOURS);
+  heap(hourly->icon, MAX_HOURS);
+  heap(daily->main, MAX_DAYS);
+  heap(daily->description, MAX_DAYS);
+  heap(daily->icon, MAX_DAYS);
+  heap(forecast->main, MAX_3HRS);
+  heap(forecast->description, MAX_3HRS);
+  heap(forecast->icon, MAX_3HRS);
+  const char *layout = "main, description and icon Strings";
+#else
+  const char *layout = "id and day/night bit";
+#endif
+
+  ::printf("Weather condition as %s\n", layout);
+  ::printf("  sizeof OW_current %zu, OW_hourly %zu, OW_daily %zu, OW_forecast %zu bytes\n",
+           sizeof(OW_current), sizeof(OW_hourly), sizeof(OW_daily), sizeof(OW_forecast));
+  ::printf("  heap held by their Strings after parsing: %zu blocks, %zu bytes\n", blocks, bytes);
+
+#ifdef OW_CONDITION_TABLE
+  // Only the OW_forecast date text and city name are left
+  CHECK(blocks == MAX_3HRS + 1);
+
+  // The text looked up from the id and night bit is the text sent, for every slot
+  Text *text = new Text;
+  client.responses.push_back(httpResponse(readFile("forecast.json")));
+  CHECK(ow.getForecast(OW_dataSet(text, textFields), "key", "0", "0", "metric", "en"));
+  for (int i = 0; i < MAX_3HRS; i++) {
+    CHECK(forecast->id[i] == text->id[i]);
+    CHECK(String(ow.conditionMain(forecast->id[i])) == text->main[i]);
+    CHECK(String(ow.conditionDescription(forecast->id[i])) == text->description[i]);
+    CHECK(String(ow.conditionIcon(forecast->id[i], OW_isNight(forecast->night, i))) == text->icon[i]);
+  }
+  CHECK(String(ow.conditionMain(1)) == "");
+  delete text;
+#else
+  CHECK(blocks > 3 * MAX_3HRS);
+#endif
+
+  delete forecast;
+  delete current;
+  delete hourly;
+  delete daily;
+  return testResult("test_conditions");
+}
@@ -0,0 +1,156 @@
+// OW_DnsCache with a stubbed resolver, alone and given to OW_Weather with setDnsCache()
+
+// The resolver answers from a table and counts its calls, so the tests can see when a
+// name is looked up again: after the TTL, when its entry is the oldest and a new name
+// needs one, when the name is too long to be held, and when a connect to the cached
+// address fails because the server has moved.
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+
+#include "test_util.h"
+
+static const IPAddress serverA(10, 0, 0, 1);
+static const IPAddress serverB(10, 0, 0, 2);
+
+static IPAddress serverAddress = serverA; // Address of the weather server, can move
+static int resolves = 0;
+
+static bool resolver(const char *host, IPAddress &ip)
+{
+  resolves++;
+  if (strcmp(host, "api.openweathermap.org") == 0) ip = serverAddress;
+  else if (strncmp(host, "unknown", 7) == 0) return false;
+  else ip = IPAddress(192, 168, 0, (uint8_t)strlen(host));
+  return true;
+}
+
+static const char *name(int n)
+{
+  static char text[2][16];
+  char *s = text[n & 1];
+  snprintf(s, 16, "host%d.test", n);
+  return s;
+}
+
+int main()
+{
+  Serial.quiet = true;
+  IPAddress ip;
+
+  // A name is looked up once and then found in the cache
+  {
+    OW_DnsCache cache(resolver);
+    CHECK(!cache.find("host1.test", ip));
+    CHECK(cache.resolve("host1.test", ip) && ip == IPAddress(192, 168, 0, 10));
+    ip = IPAddress();
+    CHECK(cache.find("host1.test", ip) && ip == IPAddress(192, 168, 0, 10));
+    CHECK(cache.resolve("host1.test", ip));
+    CHECK(resolves == 1 && cache.lookups == 1 && cache.hits == 2);
+
+    // A name not found is not cached
+    CHECK(!cache.resolve("unknown.test", ip));
+    CHECK(!cache.resolve("unknown.test", ip));
+    CHECK(!cache.find("unknown.test", ip) && resolves == 3);
+
+    cache.invalidate("host1.test");
+    CHECK(!cache.find("host1.test", ip));
+    CHECK(cache.resolve("host1.test", ip) && resolves == 4);
+    cache.clear();
+    CHECK(!cache.find("host1.test", ip));
+  }
+
+  // An address is looked up again after the TTL
+  {
+    resolves = 0;
+    OW_DnsCache cache(resolver, 50);
+    CHECK(cache.resolve("host1.test", ip));
+    CHECK(cache.find("host1.test", ip));
+    delay(60);
+    CHECK(!cache.find("host1.test", ip));
+    CHECK(cache.resolve("host1.test", ip) && resolves == 2);
+    CHECK(cache.find("host1.test", ip));
+  }
+
+  // With all entries in use the oldest lookup is replaced
+  {
+    resolves = 0;
+    OW_DnsCache cache(resolver);
+    for (int n = 0; n < OW_DNS_ENTRIES; n++) {
+      CHECK(cache.resolve(name(n), ip));
+      delay(2);
+    }
+    CHECK(cache.resolve(name(OW_DNS_ENTRIES), ip));
+    CHECK(!cache.find(name(0), ip));
+    for (int n = 1; n <= OW_DNS_ENTRIES; n++) CHECK(cache.find(name(n), ip));
+    CHECK(resolves == OW_DNS_ENTRIES + 1);
+
+    // A name re-resolved after it is invalidated reuses a free entry
+    cache.invalidate(name(2));
+    CHECK(cache.resolve(name(0), ip));
+    for (int n = 0; n <= OW_DNS_ENTRIES; n++) CHECK(cache.find(name(n), ip) == (n != 2));
+  }
+
+  // A name too long for an entry is resolved every time and does not evict others
+  {
+    resolves = 0;
+    OW_DnsCache cache(resolver);
+    std::string longName = std::string(OW_DNS_HOST_SIZE, 'x') + ".test";
+    for (int n = 0; n < OW_DNS_ENTRIES; n++) CHECK(cache.resolve(name(n), ip));
+    for (int i = 0; i < 3; i++) {
+      CHECK(cache.resolve(longName.c_str(), ip) && ip == IPAddress(192, 168, 0, (uint8_t)longName.size()));
+    }
+    CHECK(!cache.find(longName.c_str(), ip));
+    for (int n = 0; n < OW_DNS_ENTRIES; n++) CHECK(cache.find(name(n), ip));
+    CHECK(resolves == OW_DNS_ENTRIES + 3);
+
+    // One shorter than the entry size is held
+    std::string fits = std::string(OW_DNS_HOST_SIZE - 1 - 5, 'y') + ".test";
+    CHECK(cache.resolve(fits.c_str(), ip) && cache.find(fits.c_str(), ip));
+  }
+
+  // OW_Weather connects to the cached address and sends the server name in the request
+  {
+    resolves = 0;
+    OW_DnsCache cache(resolver);
+    MockClient client;
+    OW_Weather ow;
+    ow.setClient(&client);
+    ow.setDnsCache(&cache);
+
+    std::string response = httpResponse(readFile("forecast.json"));
+    OW_forecast *forecast = new OW_forecast;
+
+    client.responses.push_back(response);
+    CHECK(ow.getForecast(forecast, "key", "0", "0", "metric", "en"));
+    CHECK(client.host == "10.0.0.1" && resolves == 1);
+    CHECK(client.sent.find("Host: api.openweathermap.org\r\n") != std::string::npos);
+
+    client.responses.push_back(response);
+    CHECK(ow.getForecast(forecast, "key", "0", "0", "metric", "en"));
+    CHECK(client.host == "10.0.0.1" && resolves == 1 && cache.hits >= 1);
+
+    // The server moves, the connect to the old address fails and the name is looked up again
+    serverAddress = serverB;
+    client.refuseAddress = (uint32_t)serverA;
+    client.responses.push_back(response);
+    CHECK(ow.getForecast(forecast, "key", "0", "0", "metric", "en"));
+    CHECK(client.host == "10.0.0.2" && resolves == 2);
+    CHECK(cache.find("api.openweathermap.org", ip) && ip == serverB);
+
+    client.responses.push_back(response);
+    CHECK(ow.getForecast(forecast, "key", "0", "0", "metric", "en"));
+    CHECK(resolves == 2 && client.connects == 4);
+
+    // A name that can not be resolved makes no connection
+    ow.setServer("unknown.test");
+    client.responses.push_back(response);
+    CHECK(!ow.getForecast(forecast, "key", "0", "0", "metric", "en"));
+    CHECK(client.connects == 4);
+
+    delete forecast;
+  }
+
+  return testResult("test_dns");
+}
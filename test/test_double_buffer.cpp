@@ -0,0 +1,89 @@
+// OW_DoubleBuffer with a reader thread taking snapshots while responses are parsed
+
+// The writer parses good and bad responses into the back buffer. The reader must only
+// ever see a whole forecast: the empty struct before the first publish, London or Paris,
+// never a mix of two updates or a partly parsed one. Build with -DOW_TEST_SANITIZE=thread
+// to have the accesses checked as well.
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+#include <atomic>
+#include <thread>
+
+#include "test_util.h"
+
+static OW_DoubleBuffer<OW_forecast> weather;
+
+// Each good response has its own city and dt values, so a mix can be seen
+enum Snapshot { EMPTY, LONDON, PARIS, MIXED };
+
+static Snapshot identify(const OW_forecast *f)
+{
+  uint32_t era = f->dt[0] / 100000000;
+  for (int i = 1; i < MAX_3HRS; i++) if (f->dt[i] / 100000000 != era) return MIXED;
+
+  if (f->city_name == ""       && era == 0)  return EMPTY;
+  if (f->city_name == "London" && era == 17) return LONDON;
+  if (f->city_name == "Paris"  && era == 27) return PARIS;
+  return MIXED;
+}
+
+int main()
+{
+  Serial.quiet = true;
+
+  std::string london = readFile("forecast.json");
+  std::string paris = replaceAll(replaceAll(london, "\"London\"", "\"Paris\""), "\"dt\": 17", "\"dt\": 27");
+  std::string truncated = london.substr(0, london.size() / 2);
+  std::string malformed = replaceAll(london, "\"list\": [", "\"list\": [}");
+
+  std::atomic<bool> done(false);
+  std::atomic<long> reads(0), mixed(0), londonSeen(0), parisSeen(0);
+
+  std::thread reader([&] {
+    while (!done) {
+      const OW_forecast *f = weather.acquire();
+      Snapshot s = identify(f);
+      weather.release(f);
+
+      reads++;
+      if (s == MIXED)  mixed++;
+      if (s == LONDON) londonSeen++;
+      if (s == PARIS)  parisSeen++;
+    }
+  });
+
+  MockClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+
+  const int updates = 1000;
+  int published = 0;
+  for (int i = 0; i < updates; i++) {
+    const std::string &body = (i % 4 == 0) ? london : (i % 4 == 1) ? truncated :
+                              (i % 4 == 2) ? paris : malformed;
+    client.responses.push_back(httpResponse(body));
+
+    bool ok = ow.getForecast(weather, "key", "51.5085", "-0.1257", "metric", "en");
+    CHECK(ok == (i % 2 == 0)); // Only the good responses parse OK and are published
+    if (ok) published++;
+
+    // A failed parse leaves the last good forecast in the front buffer
+    const OW_forecast *f = weather.acquire();
+    CHECK(identify(f) == ((i % 4 < 2) ? LONDON : PARIS));
+    weather.release(f);
+  }
+
+  done = true;
+  reader.join();
+
+  ::printf("published %d, reads %ld, London %ld, Paris %ld, mixed %ld\n",
+           published, reads.load(), londonSeen.load(), parisSeen.load(), mixed.load());
+
+  CHECK(published == updates / 2);
+  CHECK(mixed == 0);
+  CHECK(reads > 0);
+
+  return testResult("test_double_buffer");
+}
@@ -0,0 +1,167 @@
+// Early end of the message once all wanted values are received
+
+// The onecall response is parsed into a partial data set, current plus the first three
+// hourly slots. The library must stop reading within one read block of the end of
+// hourly[2], leaving the daily section and the rest of hourly unread, and the values
+// must be the same as those parsed into the library structs. With a kept open
+// connection the unread end of the body is drained, so the next request on the same
+// connection parses.
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+
+#include "test_util.h"
+
+#define SLOTS 3
+
+// MockClient counting the bytes read by the library
+class CountingClient : public MockClient {
+
+  public:
+    size_t bytesRead = 0;
+
+    int read() override {
+      int c = MockClient::read();
+      if (c >= 0) bytesRead++;
+      return c;
+    }
+
+    int read(uint8_t *buf, size_t size) override {
+      int n = MockClient::read(buf, size);
+      if (n > 0) bytesRead += n;
+      return n;
+    }
+};
+
+struct Current {
+  uint32_t dt;
+  float    temp;
+  uint16_t id;
+};
+
+struct Hourly {
+  uint32_t dt[SLOTS];
+  float    temp[SLOTS];
+  uint16_t id[SLOTS];
+};
+
+static const OW_Field currentFields[] = {
+  OW_FIELD(Current, dt,   CURRENT, CURRENT, DT),
+  OW_FIELD(Current, temp, CURRENT, CURRENT, TEMP),
+  OW_FIELD(Current, id,   CURRENT, WEATHER, ID),
+};
+
+static const OW_Field hourlyFields[] = {
+  OW_FIELD(Hourly, dt,   HOURLY, HOURLY, DT),
+  OW_FIELD(Hourly, temp, HOURLY, HOURLY, TEMP),
+  OW_FIELD(Hourly, id,   HOURLY, WEATHER, ID),
+};
+
+// Offset just past the end of element n of the top level array named key
+static size_t elementEnd(const std::string &body, const char *key, int n)
+{
+  size_t pos = body.find(std::string("\"") + key + "\"");
+  pos = body.find('[', pos);
+  int depth = 0;
+  for (size_t i = pos + 1; i < body.size(); i++) {
+    if (body[i] == '{' || body[i] == '[') depth++;
+    else if ((body[i] == '}' || body[i] == ']') && --depth == 0 && n-- == 0) return i + 1;
+  }
+  return body.size();
+}
+
+static bool same(const Current *current, const Hourly *hourly, const OW_current *full, const OW_hourly *fullHourly)
+{
+  bool ok = current->dt == full->dt && current->temp == full->temp && current->id == full->id;
+  for (int i = 0; i < SLOTS; i++) {
+    ok = ok && hourly->dt[i] == fullHourly->dt[i] && hourly->temp[i] == fullHourly->temp[i] &&
+         hourly->id[i] == fullHourly->id[i];
+  }
+  return ok;
+}
+
+int main()
+{
+  Serial.quiet = true;
+
+  std::string body = readFile("onecall.json");
+  std::string response = httpResponse(body);
+  size_t header = response.size() - body.size();
+  size_t wantedEnd = elementEnd(body, "hourly", SLOTS - 1);
+  CHECK(wantedEnd < body.find("\"daily\""));
+
+  CountingClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+
+  // The library structs, all three sections are parsed up to daily[MAX_DAYS - 1]
+  OW_current *full = new OW_current;
+  OW_hourly  *fullHourly = new OW_hourly;
+  OW_daily   *fullDaily = new OW_daily;
+  client.responses.push_back(response);
+  CHECK(ow.getForecast(full, fullHourly, fullDaily, "key", "0", "0", "metric", "en"));
+  CHECK(client.bytesRead >= header + elementEnd(body, "daily", MAX_DAYS - 1));
+  CHECK(fullDaily->dt[MAX_DAYS - 1] != 0);
+  float lat = ow.lat, lon = ow.lon;
+  String timezone = ow.timezone;
+
+  // Partial data set, reading stops in the block holding the end of hourly[2]
+  Current *current = new Current;
+  Hourly  *hourly  = new Hourly;
+  memset(current, 0, sizeof(Current));
+  memset(hourly, 0, sizeof(Hourly));
+  ow.lat = ow.lon = 0;
+  ow.timezone = "";
+  client.bytesRead = 0;
+  client.responses.push_back(response);
+  CHECK(ow.getForecast(OW_dataSet(current, currentFields), OW_dataSet(hourly, hourlyFields), OW_dataSet(),
+                       "key", "0", "0", "metric", "en"));
+  ::printf("Partial data set: %zu of %zu bytes read, wanted values end at byte %zu\n",
+           client.bytesRead, response.size(), header + wantedEnd);
+  CHECK(client.bytesRead >= header + wantedEnd);
+  CHECK(client.bytesRead <= header + wantedEnd + OW_READ_BUFFER_SIZE);
+  CHECK(same(current, hourly, full, fullHourly));
+  CHECK(ow.lat == lat && ow.lon == lon && ow.timezone == timezone);
+  CHECK(client.sent.find("exclude=minutely,alerts,daily") != std::string::npos);
+
+  // Read a byte at a time the reading stops at the end of hourly[2]
+  memset(hourly, 0, sizeof(Hourly));
+  client.maxRead = 1;
+  client.bytesRead = 0;
+  client.responses.push_back(response);
+  CHECK(ow.getForecast(OW_dataSet(current, currentFields), OW_dataSet(hourly, hourlyFields), OW_dataSet(),
+                       "key", "0", "0", "metric", "en"));
+  CHECK(client.bytesRead == header + wantedEnd);
+  CHECK(same(current, hourly, full, fullHourly));
+  client.maxRead = SIZE_MAX;
+
+  // Kept open connection, the rest of the body is drained so the next response is found
+  client.keepAlive = true;
+  ow.keepAlive(true);
+  int connects = client.connects;
+  for (int i = 0; i < 3; i++) {
+    memset(current, 0, sizeof(Current));
+    memset(hourly, 0, sizeof(Hourly));
+    client.bytesRead = 0;
+    client.responses.push_back(response);
+    CHECK(ow.getForecast(OW_dataSet(current, currentFields), OW_dataSet(hourly, hourlyFields), OW_dataSet(),
+                         "key", "0", "0", "metric", "en"));
+    CHECK(client.bytesRead == response.size());
+    CHECK(same(current, hourly, full, fullHourly));
+  }
+
+  // The library structs after them on the same connection
+  client.responses.push_back(response);
+  memset(fullHourly->dt, 0, sizeof(fullHourly->dt));
+  CHECK(ow.getForecast(full, fullHourly, fullDaily, "key", "0", "0", "metric", "en"));
+  CHECK(same(current, hourly, full, fullHourly));
+  CHECK(client.connects == connects + 1);
+
+  delete full;
+  delete fullHourly;
+  delete fullDaily;
+  delete current;
+  delete hourly;
+  return testResult("test_early_end");
+}
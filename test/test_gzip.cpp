@@ -0,0 +1,233 @@
+// Compressed responses, built with OW_GZIP
+
+// The forecast response is sent gzip and zlib compressed by a local MockServer, framed
+// by Content-Length, chunked, and by the server closing the connection, and read by the
+// library 1 to all available bytes at a time. Each must parse to the same values as the
+// uncompressed response. With a slot callback the whole body is read, so the check value
+// at its end is tested, and a body with a bad CRC-32, Adler-32, length or deflate data
+// must fail the request, also when it is only read to clear a kept open connection.
+//
+// The payloads in test/data were made with Python's zlib module from forecast.json:
+//   forecast.json.gz         gzip.compress(data, 9, mtime=0), dynamic Huffman blocks
+//   forecast.json.zz         zlib.compress(data, 9)
+//   forecast_fixed.json.gz   Z_FIXED raw deflate, with a gzip header using FEXTRA,
+//                            FNAME, FCOMMENT and FHCRC
+//   forecast_stored.json.zz  zlib.compress(data, 0), stored blocks
+
+#include <Arduino.h>
+#include <OpenWeather.h>
+
+#include "mock_server.h"
+#include "test_util.h"
+
+// OW_PosixClient returning at most maxRead bytes from each read
+class LimitedClient : public OW_PosixClient {
+
+  public:
+    size_t maxRead = SIZE_MAX;
+
+    int available() override {
+      int n = OW_PosixClient::available();
+      return (n > 0 && (size_t)n > maxRead) ? (int)maxRead : n;
+    }
+
+    int read(uint8_t *buf, size_t size) override {
+      return OW_PosixClient::read(buf, std::min(size, maxRead));
+    }
+};
+
+// Values compared with memcmp, so no String members
+struct Forecast {
+  uint32_t dt[MAX_3HRS];
+  float    temp[MAX_3HRS];
+  uint16_t id[MAX_3HRS];
+  float    pop[MAX_3HRS];
+  uint32_t sunrise;
+};
+
+static const OW_Field forecastFields[] = {
+  OW_FIELD(Forecast, dt,      LIST, LIST, DT),
+  OW_FIELD(Forecast, temp,    LIST, MAIN, TEMP),
+  OW_FIELD(Forecast, id,      LIST, WEATHER, ID),
+  OW_FIELD(Forecast, pop,     LIST, LIST, POP),
+  OW_FIELD(Forecast, sunrise, CITY, CITY, SUNRISE),
+};
+
+enum Framing { LENGTH, CHUNKED, CLOSE };
+static const char *framingName[] = { "Content-Length", "chunked", "close" };
+
+static std::string frame(const std::string &body, Framing framing, const std::string &headers, unsigned seed = 1)
+{
+  if (framing == CHUNKED) return chunkedResponse(body, seed, 97, headers);
+  if (framing == CLOSE) {
+    return "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n" + headers + "Connection: close\r\n\r\n" + body;
+  }
+  return httpResponse(body, headers);
+}
+
+static int slots = 0;
+static void countSlot(const OW_slot &slot) { slots++; }
+
+// Server answers every request with response, and keeps the last request head
+static void serve(MockServer &server, const std::string &response, std::string *head = nullptr)
+{
+  server.respond([response, head](const std::string &request) {
+    if (head) *head = request;
+    return response;
+  });
+}
+
+// Parse the response into forecast, true if the request succeeded
+static bool fetch(OW_Weather &ow, Forecast *forecast)
+{
+  memset(forecast, 0, sizeof(Forecast));
+  return ow.getForecast(OW_dataSet(forecast, forecastFields), "key", "0", "0", "metric", "en", false);
+}
+
+int main()
+{
+  Serial.quiet = true;
+
+  std::string body = readFile("forecast.json");
+  struct Payload { const char *file; const char *encoding; uint8_t format; std::string data; } payloads[] = {
+    { "forecast.json.gz",        "Content-Encoding: gzip\r\n",    OW_INFLATE_GZIP, "" },
+    { "forecast.json.zz",        "Content-Encoding: deflate\r\n", OW_INFLATE_ZLIB, "" },
+    { "forecast_fixed.json.gz",  "Content-Encoding: gzip\r\n",    OW_INFLATE_GZIP, "" },
+    { "forecast_stored.json.zz", "Content-Encoding: deflate\r\n", OW_INFLATE_ZLIB, "" },
+  };
+  for (Payload &p : payloads) p.data = readFile(p.file);
+
+  MockServer server;
+  LimitedClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+  ow.setServer("127.0.0.1", server.port());
+
+  // The values from the uncompressed response
+  Forecast *expected = new Forecast;
+  Forecast *forecast = new Forecast;
+  std::string head;
+  serve(server, httpResponse(body), &head);
+  CHECK(fetch(ow, expected));
+  CHECK(expected->dt[MAX_3HRS - 1] != 0 && expected->sunrise != 0);
+  CHECK(ow.lastResponse().encoding == OW_INFLATE_NONE);
+  CHECK(head.find("Accept-Encoding: gzip\r\n") != std::string::npos);
+
+  // Each payload, framing and read size, with the slot callback the whole body is read
+  const size_t readSizes[] = { 1, 7, 64, 1000, SIZE_MAX };
+  ow.onSlot(countSlot);
+  for (const Payload &p : payloads) {
+    for (int framing = LENGTH; framing <= CLOSE; framing++) {
+      serve(server, frame(p.data, (Framing)framing, p.encoding, framing + p.data.size()));
+      for (size_t size : readSizes) {
+        client.maxRead = size;
+        slots = 0;
+        bool ok = fetch(ow, forecast);
+        bool same = memcmp(forecast, expected, sizeof(Forecast)) == 0;
+        if (!ok || !same || slots != 40 || ow.lastResponse().encoding != p.format) {
+          ::printf("%s, %s, read size %zu: %s\n", p.file, framingName[framing], size, ok ? "values differ" : "failed");
+          ++testFailures();
+        }
+      }
+    }
+  }
+  client.maxRead = SIZE_MAX;
+
+  // Without the callback the read stops once the values are parsed
+  ow.onSlot(nullptr);
+  for (const Payload &p : payloads) {
+    serve(server, frame(p.data, LENGTH, p.encoding));
+    CHECK(fetch(ow, forecast));
+    CHECK(memcmp(forecast, expected, sizeof(Forecast)) == 0);
+  }
+
+  // Kept open connection, the rest of each compressed body is read so the next response
+  // is found, with Content-Length and chunked
+  ow.keepAlive(true);
+  int connections = server.connections();
+  for (int framing = LENGTH; framing <= CHUNKED; framing++) {
+    serve(server, frame(payloads[0].data, (Framing)framing, payloads[0].encoding));
+    for (int i = 0; i < 3; i++) {
+      CHECK(fetch(ow, forecast));
+      CHECK(memcmp(forecast, expected, sizeof(Forecast)) == 0);
+    }
+  }
+  CHECK(server.connections() == connections + 1);
+
+  // Several locations with pipelined requests, each response compressed
+  serve(server, frame(payloads[1].data, CHUNKED, payloads[1].encoding));
+  Forecast *batch = new Forecast[3];
+  OW_Location locations[3];
+  OW_Result results[3];
+  for (int i = 0; i < 3; i++) {
+    locations[i].latitude = 50 + i;
+    results[i].set = OW_dataSet(&batch[i], forecastFields);
+  }
+  CHECK(ow.getForecasts(locations, results, 3, "key", "metric", "en", false) == 3);
+  for (int i = 0; i < 3; i++) {
+    CHECK(results[i].ok && results[i].status == 200);
+    CHECK(memcmp(&batch[i], expected, sizeof(Forecast)) == 0);
+  }
+  ow.keepAlive(false);
+
+  // A bad check value, length or deflate data fails the request
+  std::string badCrc = payloads[0].data;
+  badCrc[badCrc.size() - 8] ^= 1;
+  std::string badLength = payloads[0].data;
+  badLength[badLength.size() - 4] ^= 1;
+  std::string badAdler = payloads[1].data;
+  badAdler[badAdler.size() - 1] ^= 1;
+  std::string badData = payloads[3].data;
+  badData[badData.size() / 2] ^= 1;  // A stored block byte, so only the check value finds it
+  std::string badCode = payloads[0].data;
+  badCode[100] ^= 0xFF;
+  std::string truncated = payloads[0].data.substr(0, payloads[0].data.size() - 6);
+
+  struct Bad { const char *name; std::string data; const char *encoding; } bad[] = {
+    { "CRC-32",      badCrc,    payloads[0].encoding },
+    { "length",      badLength, payloads[0].encoding },
+    { "Adler-32",    badAdler,  payloads[1].encoding },
+    { "stored data", badData,   payloads[1].encoding },
+    { "deflate",     badCode,   payloads[0].encoding },
+  };
+
+  ow.onSlot(countSlot);
+  for (const Bad &b : bad) {
+    for (int framing = LENGTH; framing <= CLOSE; framing++) {
+      serve(server, frame(b.data, (Framing)framing, b.encoding));
+      if (fetch(ow, forecast)) {
+        ::printf("Bad %s, %s: not rejected\n", b.name, framingName[framing]);
+        ++testFailures();
+      }
+    }
+  }
+
+  // Connection closed before the end of the check value
+  serve(server, frame(truncated, CLOSE, payloads[0].encoding));
+  CHECK(!fetch(ow, forecast));
+  ow.onSlot(nullptr);
+
+  // The check value read only to clear a kept open connection still fails the request,
+  // and the connection is not used again. Read a byte at a time, the check value is not
+  // yet received when the values are parsed.
+  ow.keepAlive(true);
+  client.maxRead = 1;
+  for (int framing = LENGTH; framing <= CHUNKED; framing++) {
+    serve(server, frame(payloads[0].data, (Framing)framing, payloads[0].encoding));
+    CHECK(fetch(ow, forecast));
+    connections = server.connections();
+    serve(server, frame(badCrc, (Framing)framing, payloads[0].encoding));
+    CHECK(!fetch(ow, forecast));
+    serve(server, frame(payloads[0].data, (Framing)framing, payloads[0].encoding));
+    CHECK(fetch(ow, forecast));
+    CHECK(memcmp(forecast, expected, sizeof(Forecast)) == 0);
+    CHECK(server.connections() == connections + 1);
+  }
+  ow.keepAlive(false);
+  client.maxRead = SIZE_MAX;
+
+  delete[] batch;
+  delete expected;
+  delete forecast;
+  return testResult("test_gzip");
+}
@@ -0,0 +1,204 @@
+// Response header parser, see OW_Weather::headerByte() and lastResponse()
+
+// Responses with a non-200 status, Content-Length, chunked transfer encoding,
+// Cache-Control, ETag and Last-Modified, in any letter case and spacing, are read with
+// MockClient a byte at a time and in large reads. Each must give the expected
+// OW_Response and, for a 200 status, the same values as a plain response. Header lines
+// and tokens longer than the buffers are skipped or truncated, and each header is
+// also split into two reads at every byte so no state is lost between reads.
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+
+#include "test_util.h"
+
+// MockClient sending the first split bytes of each connection, then the rest once the
+// library has found nothing more to read
+class SplitClient : public MockClient {
+
+  public:
+    size_t split = SIZE_MAX;
+
+    int connect(const char *name, uint16_t port) override {
+      bytesRead = 0;
+      held = true;
+      return MockClient::connect(name, port);
+    }
+
+    int available() override {
+      int n = MockClient::available();
+      if (!held || n <= 0) return n;
+      if (bytesRead >= split) {
+        held = false; // Nothing this time, the rest is sent
+        return 0;
+      }
+      return (int)std::min((size_t)n, split - bytesRead);
+    }
+
+    int read() override {
+      if (held && bytesRead >= split) return -1;
+      int c = MockClient::read();
+      if (c >= 0) bytesRead++;
+      return c;
+    }
+
+    int read(uint8_t *buf, size_t size) override {
+      int n = MockClient::read(buf, size);
+      if (n > 0) bytesRead += n;
+      return n;
+    }
+
+  private:
+    size_t bytesRead = 0;
+    bool   held = true;
+};
+
+// Values compared with memcmp, so no String members
+struct Forecast {
+  uint32_t dt[MAX_3HRS];
+  float    temp[MAX_3HRS];
+  uint16_t id[MAX_3HRS];
+  uint32_t sunrise;
+};
+
+static const OW_Field forecastFields[] = {
+  OW_FIELD(Forecast, dt,      LIST, LIST, DT),
+  OW_FIELD(Forecast, temp,    LIST, MAIN, TEMP),
+  OW_FIELD(Forecast, id,      LIST, WEATHER, ID),
+  OW_FIELD(Forecast, sunrise, CITY, CITY, SUNRISE),
+};
+
+// A response and the header values it must give
+struct Case {
+  const char *name;
+  std::string response;
+  OW_Response expected;
+};
+
+static OW_Response expect(uint16_t status, uint32_t length, bool chunked = false, bool close = false,
+                          uint32_t maxAge = 0, bool noCache = false, const char *etag = "", const char *modified = "")
+{
+  OW_Response r;
+  r.status = status;
+  r.contentLength = length;
+  r.chunked = chunked;
+  r.close = close;
+  r.maxAge = maxAge;
+  r.noCache = noCache;
+  strcpy(r.etag, etag);
+  strcpy(r.lastModified, modified);
+  return r;
+}
+
+static bool same(const OW_Response &a, const OW_Response &b)
+{
+  return a.status == b.status && a.contentLength == b.contentLength && a.chunked == b.chunked &&
+         a.close == b.close && a.maxAge == b.maxAge && a.noCache == b.noCache &&
+         !strcmp(a.etag, b.etag) && !strcmp(a.lastModified, b.lastModified);
+}
+
+// Fetch the response, true if it gave the expected header values and forecast values
+static bool check(OW_Weather &ow, SplitClient &client, const Case &c, const Forecast *expected, Forecast *forecast)
+{
+  memset(forecast, 0, sizeof(Forecast));
+  client.responses.push_back(c.response);
+  bool ok = ow.getForecast(OW_dataSet(forecast, forecastFields), "key", "0", "0", "metric", "en");
+  if (ok != (c.expected.status == 200) || !same(ow.lastResponse(), c.expected)) return false;
+  return !ok || memcmp(forecast, expected, sizeof(Forecast)) == 0;
+}
+
+int main()
+{
+  Serial.quiet = true;
+
+  std::string body = readFile("forecast.json");
+  std::string length = std::to_string(body.size());
+  std::string error = "{\"cod\":\"404\",\"message\":\"city not found\"}";
+  std::string longEtag = "\"" + std::string(100, 'e') + "\"";
+
+  Case cases[] = {
+    { "Content-Length, ETag, Last-Modified, max-age",
+      httpResponse(body, "ETag: W/\"5f1d-18b7a\"\r\nLast-Modified: Tue, 14 Nov 2023 22:13:20 GMT\r\n"
+                         "Cache-Control: public, max-age=600\r\n"),
+      expect(200, body.size(), false, false, 600, false, "W/\"5f1d-18b7a\"", "Tue, 14 Nov 2023 22:13:20 GMT") },
+
+    { "chunked, overrides Content-Length",
+      chunkedResponse(body, 3, 500, "Cache-Control: no-cache\r\nContent-Length: 999\r\n"),
+      expect(200, 0, true, false, 0, true) },
+
+    { "letter case and spacing",
+      "HTTP/1.1 200 OK\r\ncontent-LENGTH:" + length + "\r\nCACHE-CONTROL:max-age=60,No-Store\r\n"
+      "etag:   \"x\"\r\nTransfer-Encoding:  identity\r\nConnection: Close\r\n\r\n" + body,
+      expect(200, body.size(), false, true, 60, true, "\"x\"") },
+
+    { "lines and tokens longer than the buffers",
+      "HTTP/1.1 200 OK\r\nX-" + std::string(300, 'a') + ": 1\r\n"
+      "Content-Length-" + std::string(40, 'x') + ": 5\r\n"
+      "Set-Cookie: " + std::string(2000, 'c') + "\r\n"
+      "Cache-Control: max-age=" + std::string(40, '9') + ", a-long-extension-token-name, max-age=300\r\n"
+      "ETag: " + longEtag + "\r\nContent-Length: " + length + "\r\n\r\n" + body,
+      expect(200, body.size(), false, false, 300, false, longEtag.substr(0, OW_ETAG_SIZE - 1).c_str()) },
+
+    { "404 with a body",
+      "HTTP/1.1 404 Not Found\r\nContent-Type: application/json\r\nContent-Length: " +
+      std::to_string(error.size()) + "\r\n\r\n" + error,
+      expect(404, error.size()) },
+
+    { "500 chunked",
+      "HTTP/1.1 500 Internal Server Error\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nerror\r\n0\r\n\r\n",
+      expect(500, 0, true) },
+  };
+
+  SplitClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+
+  Forecast *expected = new Forecast;
+  Forecast *forecast = new Forecast;
+  client.responses.push_back(httpResponse(body));
+  CHECK(ow.getForecast(OW_dataSet(expected, forecastFields), "key", "0", "0", "metric", "en"));
+  CHECK(expected->dt[MAX_3HRS - 1] != 0 && expected->sunrise != 0);
+
+  // A byte at a time and in large reads
+  for (const Case &c : cases) {
+    for (size_t size : { (size_t)1, (size_t)SIZE_MAX }) {
+      client.maxRead = size;
+      if (!check(ow, client, c, expected, forecast)) {
+        ::printf("%s, read size %zu: failed\n", c.name, size);
+        ++testFailures();
+      }
+    }
+  }
+  client.maxRead = SIZE_MAX;
+
+  // The header split into two reads at each byte
+  for (const Case &c : cases) {
+    size_t end = c.response.find("\r\n\r\n") + 4;
+    int failed = 0;
+    for (client.split = 1; client.split <= end; client.split++) {
+      if (!check(ow, client, c, expected, forecast) && failed++ < 3) {
+        ::printf("%s, split at %zu: failed\n", c.name, client.split);
+      }
+    }
+    if (failed) ++testFailures();
+  }
+  client.split = SIZE_MAX;
+
+  // A non-200 response body is read so a kept open connection can be used again
+  client.keepAlive = true;
+  ow.keepAlive(true);
+  int connects = client.connects;
+  for (size_t size : { (size_t)1, (size_t)SIZE_MAX }) {
+    client.maxRead = size;
+    CHECK(check(ow, client, cases[4], expected, forecast));
+    CHECK(check(ow, client, cases[0], expected, forecast));
+    CHECK(check(ow, client, cases[5], expected, forecast));
+    CHECK(check(ow, client, cases[1], expected, forecast));
+  }
+  CHECK(client.connects == connects + 1);
+
+  delete expected;
+  delete forecast;
+  return testResult("test_header");
+}
@@ -0,0 +1,136 @@
+// Number conversion: float members must match strtof() bit for bit, and the scaled
+// integer members must be the exact decimal value rounded half away from zero
+
+// Every number in the sample responses, plus edge cases, is parsed as the value of a
+// float member and of each scaled integer type.
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+#include <vector>
+
+#include "test_util.h"
+
+#define BATCH 200 // Numbers per response, list elements held by the struct
+
+struct Numbers {
+  float    value[BATCH];
+  int16_t  x100[BATCH];  // OW_I16_X100
+  uint8_t  pct[BATCH];   // OW_U8_X100
+  uint16_t dam[BATCH];   // OW_U16_DIV10
+};
+
+static const OW_Field numberFields[] = {
+  OW_FIELD(Numbers, value,                     LIST, MAIN, TEMP),
+  OW_FIELD_TYPE(Numbers, x100, OW_I16_X100,   LIST, MAIN, FEELS_LIKE),
+  OW_FIELD_TYPE(Numbers, pct,  OW_U8_X100,    LIST, LIST, POP),
+  OW_FIELD_TYPE(Numbers, dam,  OW_U16_DIV10,  LIST, LIST, VISIBILITY),
+};
+
+static const char *edgeCases[] = {
+  "0", "-0", "-0.0", "0.0", "1", "-1", "0.1", "0.7", "0.3", "99.99", "-273.15",
+  "16777215", "16777216", "16777217", "16777219", "1677721.7", "167772.17",
+  "123456789", "1234567890", "12345678901234567890", "0.000000001", "0.0000000001",
+  "3.4028235e38", "1e39", "1e-50", "1.5e3", "-2.5E-2", "6.02214076e23",
+  "1.005", "2.675", "-1.005", "0.045", "0.005", "-0.005", "0.125", "-0.125",
+  "327.67", "327.675", "-327.68", "-327.685", "2.55", "2.555", "2.545",
+  "655355", "655354", "655355.0", "4294967295", "42949672950", "429496729.5",
+};
+
+// Numbers in a JSON document, strings are skipped
+static void collectNumbers(const std::string &json, std::vector<std::string> &numbers)
+{
+  for (size_t i = 0; i < json.size(); i++) {
+    if (json[i] == '"') {
+      for (i++; i < json.size() && json[i] != '"'; i++) if (json[i] == '\\') i++;
+    }
+    else if (json[i] == '-' || isdigit((unsigned char)json[i])) {
+      size_t end = json.find_first_not_of("-+.eE0123456789", i);
+      numbers.push_back(json.substr(i, end - i));
+      i = end - 1;
+    }
+  }
+}
+
+// The decimal number times 10^shift rounded half away from zero, limited to min to max
+static int32_t exactScaled(const std::string &number, int shift, int32_t min, int32_t max)
+{
+  bool neg = number[0] == '-';
+  std::string text = number.substr(neg ? 1 : 0);
+  size_t point = text.find('.');
+  std::string whole = text.substr(0, point);
+  std::string frac = point == std::string::npos ? "" : text.substr(point + 1);
+
+  // Digits of the value times 10^(shift + 1)
+  frac.resize(shift + 1, '0');
+  std::string digits = whole + frac.substr(0, shift + 1);
+  digits.erase(0, std::min(digits.find_first_not_of('0'), digits.size()));
+  if (digits.size() > 18) return neg ? min : max;
+
+  int64_t n = (std::stoll("0" + digits) + 5) / 10;
+  if (neg) n = -n;
+  return n < min ? min : n > max ? max : (int32_t)n;
+}
+
+int main()
+{
+  Serial.quiet = true;
+
+  std::vector<std::string> numbers;
+  collectNumbers(readFile("forecast.json"), numbers);
+  collectNumbers(readFile("onecall.json"), numbers);
+  size_t fromSamples = numbers.size();
+  for (const char *number : edgeCases) numbers.push_back(number);
+
+  MockClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+  Numbers *parsed = new Numbers;
+
+  int floatMismatches = 0, scaledMismatches = 0;
+  for (size_t first = 0; first < numbers.size(); first += BATCH) {
+    size_t count = std::min((size_t)BATCH, numbers.size() - first);
+
+    std::string json = "{\"list\":[";
+    for (size_t i = 0; i < count; i++) {
+      const std::string &n = numbers[first + i];
+      json += (i ? "," : "") + std::string("{\"main\":{\"temp\":") + n + ",\"feels_like\":" + n +
+              "},\"pop\":" + n + ",\"visibility\":" + n + "}";
+    }
+    json += "]}";
+
+    memset(parsed, 0xAA, sizeof(Numbers));
+    client.responses.push_back(httpResponse(json));
+    CHECK(ow.getForecast(OW_dataSet(parsed, numberFields), "key", "0", "0", "metric", "en"));
+
+    for (size_t i = 0; i < count; i++) {
+      const std::string &n = numbers[first + i];
+
+      float expected = strtof(n.c_str(), nullptr);
+      if (memcmp(&parsed->value[i], &expected, sizeof(float)) != 0) {
+        if (floatMismatches++ < 10) ::printf("float %s: %.9g, strtof %.9g\n", n.c_str(), parsed->value[i], expected);
+      }
+
+      // Exponent notation uses the float conversion, not the exact decimal one
+      if (n.find_first_of("eE") != std::string::npos) continue;
+
+      int32_t x100 = exactScaled(n, 2, -32768, 32767);
+      int32_t pct  = exactScaled(n, 2, 0, 255);
+      int32_t dam  = exactScaled(n, -1, 0, 65535);
+      if (parsed->x100[i] != x100 || parsed->pct[i] != pct || parsed->dam[i] != dam) {
+        if (scaledMismatches++ < 10)
+          ::printf("scaled %s: %d %u %u, exact %d %d %d\n", n.c_str(),
+                   parsed->x100[i], parsed->pct[i], parsed->dam[i], x100, pct, dam);
+      }
+    }
+  }
+
+  ::printf("%zu numbers (%zu from the sample responses), %d float and %d scaled mismatches\n",
+           numbers.size(), fromSamples, floatMismatches, scaledMismatches);
+  CHECK(fromSamples > 1000);
+  CHECK(floatMismatches == 0);
+  CHECK(scaledMismatches == 0);
+
+  delete parsed;
+  return testResult("test_numbers");
+}
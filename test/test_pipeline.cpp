@@ -0,0 +1,206 @@
+// getForecasts() with pipelined requests against a local MockServer
+
+// Each location's response has its latitude as the city sunrise time, so a response
+// parsed into the wrong location's struct is seen. More locations than
+// OW_PIPELINE_DEPTH are fetched while the server answers every request, fails some
+// of them part way through the pipeline, cuts a body short and closes, or closes each
+// connection after N responses with requests still unanswered. Every OW_Result must
+// give the status and result of its own location, and the requests not answered on a
+// closed connection must be sent again on a new one.
+
+#include <Arduino.h>
+#include <OpenWeather.h>
+
+#include "mock_server.h"
+#include "test_util.h"
+
+#define LOCATIONS (3 * OW_PIPELINE_DEPTH + 1)
+
+// Values compared with memcmp, so no String members
+struct Forecast {
+  uint32_t dt[MAX_3HRS];
+  float    temp[MAX_3HRS];
+  uint32_t sunrise;
+};
+
+static const OW_Field forecastFields[] = {
+  OW_FIELD(Forecast, dt,      LIST, LIST, DT),
+  OW_FIELD(Forecast, temp,    LIST, MAIN, TEMP),
+  OW_FIELD(Forecast, sunrise, CITY, CITY, SUNRISE),
+};
+
+// How the server answers the request for a location
+enum Answer { OK, SERVER_ERROR, NOT_FOUND, MALFORMED, CUT_SHORT };
+
+static Answer answers[LOCATIONS];
+
+static uint16_t expectedStatus(Answer a)
+{
+  return a == SERVER_ERROR ? 500 : (a == NOT_FOUND ? 404 : 200);
+}
+
+// Location number from a request head, the latitude is sent as e.g. "lat=3.0000"
+static int location(const std::string &head)
+{
+  size_t pos = head.find("lat=");
+  return pos == std::string::npos ? -1 : atoi(head.c_str() + pos + 4);
+}
+
+// Times each location's request was answered, or with unanswered set received and
+// dropped as the server closed, from the request lines after the first
+static std::vector<int> requestCounts(MockServer &server, size_t first, bool unanswered = false)
+{
+  std::vector<int> counts(LOCATIONS, 0);
+  std::vector<std::string> lines = unanswered ? server.unanswered() : server.requests();
+  for (size_t i = first; i < lines.size(); i++) {
+    int n = location(lines[i]);
+    if (n >= 0 && n < LOCATIONS) counts[n]++;
+  }
+  return counts;
+}
+
+int main()
+{
+  Serial.quiet = true;
+
+  std::string body = readFile("forecast.json");
+  const std::string sunrise = "\"sunrise\": 1699945000";
+  CHECK(body.find(sunrise) != std::string::npos);
+
+  MockServer server;
+  server.respond([&](const std::string &head) {
+    int n = location(head);
+    Answer a = (n >= 0 && n < LOCATIONS) ? answers[n] : NOT_FOUND;
+    std::string located = replaceAll(body, sunrise, "\"sunrise\": " + std::to_string(1000 + n));
+
+    if (a == SERVER_ERROR) return std::string("HTTP/1.1 500 Internal Server Error\r\nContent-Length: 11\r\n\r\n{\"cod\":500}");
+    if (a == NOT_FOUND) return std::string("HTTP/1.1 404 Not Found\r\nContent-Length: 11\r\n\r\n{\"cod\":404}");
+    if (a == MALFORMED) return httpResponse(replaceAll(located, "\"list\": [", "\"list\": [}"));
+    if (a == CUT_SHORT) {
+      return "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(located.size()) +
+             "\r\nConnection: close\r\n\r\n" + located.substr(0, located.size() / 2);
+    }
+    return httpResponse(located);
+  });
+
+  OW_PosixClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+  ow.setServer("127.0.0.1", server.port());
+
+  Forecast *expected = new Forecast;
+  memset(expected, 0, sizeof(Forecast));
+  for (Answer &a : answers) a = OK;
+  CHECK(ow.getForecast(OW_dataSet(expected, forecastFields), "key", "0", "0", "metric", "en", false));
+  CHECK(expected->sunrise == 1000);
+
+  Forecast *forecasts = new Forecast[LOCATIONS];
+  OW_Location locations[LOCATIONS];
+  OW_Result results[LOCATIONS];
+  for (int i = 0; i < LOCATIONS; i++) {
+    locations[i].latitude = i;
+    results[i].set = OW_dataSet(&forecasts[i], forecastFields);
+  }
+
+  // Fetch all the locations, then check every result against its location's answer
+  auto fetch = [&](const char *name) {
+    memset(forecasts, 0, sizeof(Forecast) * LOCATIONS);
+    int good = 0;
+    for (Answer a : answers) good += (a == OK);
+
+    uint16_t parsed = ow.getForecasts(locations, results, LOCATIONS, "key", "metric", "en", false);
+    if (parsed != good) {
+      ::printf("%s: %u of %d parsed\n", name, parsed, good);
+      ++testFailures();
+    }
+
+    for (int i = 0; i < LOCATIONS; i++) {
+      Forecast want = *expected;
+      want.sunrise = 1000 + i;
+      bool ok = results[i].ok == (answers[i] == OK) && results[i].status == expectedStatus(answers[i]) &&
+                (answers[i] != OK || memcmp(&forecasts[i], &want, sizeof(Forecast)) == 0);
+      if (!ok) {
+        ::printf("%s: location %d, ok %d status %u\n", name, i, results[i].ok, results[i].status);
+        ++testFailures();
+      }
+    }
+  };
+
+  // Every request answered, all on one connection and each sent once
+  int connections = server.connections();
+  size_t requests = server.requests().size();
+  size_t dropped = server.unanswered().size();
+  fetch("All answered");
+  CHECK(server.connections() == connections + 1);
+  for (int count : requestCounts(server, requests)) CHECK(count == 1);
+  CHECK(server.unanswered().size() == dropped);
+
+  // Failures part way through the pipeline only fail their own location
+  answers[1] = SERVER_ERROR;
+  answers[OW_PIPELINE_DEPTH] = NOT_FOUND;
+  answers[OW_PIPELINE_DEPTH + 2] = MALFORMED;
+  answers[LOCATIONS - 1] = SERVER_ERROR;
+  connections = server.connections();
+  requests = server.requests().size();
+  fetch("Failures in the pipeline");
+  CHECK(server.connections() == connections + 1);
+  for (int count : requestCounts(server, requests)) CHECK(count == 1);
+  CHECK(server.unanswered().size() == dropped);
+  for (Answer &a : answers) a = OK;
+
+  // A body cut short as the server closes, the requests after it that the server did
+  // not answer are sent again on a new connection, each answered once
+  const int cut = OW_PIPELINE_DEPTH + 1;
+  answers[cut] = CUT_SHORT;
+  connections = server.connections();
+  requests = server.requests().size();
+  fetch("Cut short");
+  CHECK(server.connections() == connections + 2);
+  for (int count : requestCounts(server, requests)) CHECK(count == 1);
+  std::vector<int> lost = requestCounts(server, dropped, true);
+  for (int i = 0; i <= cut; i++) CHECK(lost[i] == 0);
+  answers[cut] = OK;
+
+  // Each connection closed after N responses with requests outstanding, the unanswered
+  // tail is sent again on a new connection each time, and each request answered once
+  for (int n = 1; n <= OW_PIPELINE_DEPTH + 1; n++) {
+    char name[32];
+    snprintf(name, sizeof(name), "Close after %d", n);
+    server.closeAfter(n);
+    connections = server.connections();
+    requests = server.requests().size();
+    fetch(name);
+    CHECK(server.connections() == connections + (LOCATIONS + n - 1) / n);
+    for (int count : requestCounts(server, requests)) CHECK(count == 1);
+  }
+  CHECK(server.unanswered().size() > dropped);
+
+  // and with failures, which still count as answered
+  answers[2] = NOT_FOUND;
+  answers[5] = MALFORMED;
+  server.closeAfter(3);
+  connections = server.connections();
+  requests = server.requests().size();
+  fetch("Close after 3 with failures");
+  CHECK(server.connections() == connections + (LOCATIONS + 2) / 3);
+  for (int count : requestCounts(server, requests)) CHECK(count == 1);
+  for (Answer &a : answers) a = OK;
+
+  // A server closing every connection unanswered, each location fails with no status
+  server.closeAfter(0);
+  requests = server.requests().size();
+  uint16_t parsed = ow.getForecasts(locations, results, LOCATIONS, "key", "metric", "en", false);
+  CHECK(parsed == 0);
+  for (int i = 0; i < LOCATIONS; i++) CHECK(!results[i].ok && results[i].status == 0);
+  CHECK(server.requests().size() == requests);
+  server.closeAfter(-1);
+
+  // No server at all
+  ow.setServer("127.0.0.1", 1);
+  CHECK(ow.getForecasts(locations, results, LOCATIONS, "key", "metric", "en", false) == 0);
+  for (int i = 0; i < LOCATIONS; i++) CHECK(!results[i].ok && results[i].status == 0);
+
+  delete expected;
+  delete[] forecasts;
+  return testResult("test_pipeline");
+}
@@ -0,0 +1,113 @@
+// Fetch and parse over a real TCP connection, OW_PosixClient and a local MockServer
+
+#include <Arduino.h>
+#include <OpenWeather.h>
+
+#include "mock_server.h"
+#include "test_util.h"
+
+int main()
+{
+  Serial.quiet = true;
+
+  MockServer server;
+  OW_PosixClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+  ow.setServer("127.0.0.1", server.port());
+
+  OW_forecast *forecast = new OW_forecast;
+  OW_current  *current  = new OW_current;
+  OW_hourly   *hourly   = new OW_hourly;
+  OW_daily    *daily    = new OW_daily;
+
+  // Forecast API, a new connection for each request
+  CHECK(ow.getForecast(forecast, "key", "51.5085", "-0.1257", "metric", "en", false));
+  CHECK(forecast->city_name == "London");
+  CHECK(forecast->dt[0] == 1700000000);
+  CHECK(ow.lastResponse().status == 200);
+
+  CHECK(ow.getForecast(forecast, "key", 51.5085f, -0.1257f, "metric", "en", false));
+  CHECK(server.connections() == 2);
+
+  // One call API
+  CHECK(ow.getForecast(current, hourly, daily, "key", "51.5085", "-0.1257", "metric", "en", false));
+  CHECK(current->dt == 1700000000);
+  CHECK(current->temp == 26.11f);
+
+  // Every request line reached the server in origin-form
+  CHECK(server.requests().size() == 3);
+  for (const std::string &line : server.requests()) {
+    CHECK(line.compare(0, 14, "GET /data/2.5/") == 0);
+    CHECK(line.find("http") == std::string::npos);
+  }
+
+  // Kept open connection reused
+  int connections = server.connections();
+  ow.keepAlive(true);
+  for (int i = 0; i < 5; i++) {
+    forecast->dt[0] = 0;
+    CHECK(ow.getForecast(forecast, "key", "51.5085", "-0.1257", "metric", "en", false));
+    CHECK(forecast->dt[0] == 1700000000);
+  }
+  CHECK(server.connections() == connections + 1);
+
+  // Several locations with pipelined requests
+  OW_forecast *batch = new OW_forecast[3];
+  OW_Location locations[3];
+  OW_Result results[3];
+  for (int i = 0; i < 3; i++) {
+    locations[i].latitude = 50 + i;
+    locations[i].longitude = -1;
+    results[i].set = OW_dataSet(&batch[i], OW_forecastFields);
+  }
+  CHECK(ow.getForecasts(locations, results, 3, "key", "metric", "en", false) == 3);
+  for (int i = 0; i < 3; i++) {
+    CHECK(results[i].ok && results[i].status == 200);
+    CHECK(batch[i].city_name == "London");
+  }
+  ow.keepAlive(false);
+
+  // Non-blocking fetch
+  forecast->dt[0] = 0;
+  CHECK(ow.beginForecast(forecast, "key", "51.5085", "-0.1257", "metric", "en", false));
+  uint8_t state;
+  uint32_t start = millis();
+  while ((state = ow.poll()) == OW_POLL_IN_PROGRESS && millis() - start < 5000) { }
+  CHECK(state == OW_POLL_DONE);
+  CHECK(forecast->dt[0] == 1700000000);
+
+  // Non-blocking fetch kept open, only current is wanted so the rest of the body is
+  // read a block per poll() after the parse is done and the connection is reused
+  ow.keepAlive(true);
+  connections = server.connections();
+  for (int i = 0; i < 2; i++) {
+    current->dt = 0;
+    CHECK(ow.beginForecast(current, nullptr, nullptr, "key", "51.5085", "-0.1257", "metric", "en", false));
+    int polls = 0;
+    start = millis();
+    while ((state = ow.poll()) == OW_POLL_IN_PROGRESS && millis() - start < 5000) {
+      if (current->dt) polls++;
+    }
+    CHECK(state == OW_POLL_DONE);
+    CHECK(current->dt == 1700000000);
+    CHECK(polls > 1);
+  }
+  CHECK(server.connections() == connections + 1);
+  ow.keepAlive(false);
+
+  // A url the server does not have, then a port with no server
+  CHECK(!ow.parseRequest("/data/2.5/weather?lat=1&lon=2"));
+  CHECK(ow.lastResponse().status == 404);
+
+  ow.setServer("127.0.0.1", 1);
+  CHECK(!ow.getForecast(forecast, "key", "51.5085", "-0.1257", "metric", "en", false));
+
+  delete[] batch;
+  delete forecast;
+  delete current;
+  delete hourly;
+  delete daily;
+
+  return testResult("test_posix_client");
+}
@@ -0,0 +1,102 @@
+// Request line and header sent to the server
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+#include <cmath>
+
+#include "test_util.h"
+
+// Request line and Host header of the last request sent
+static std::string requestHead(const MockClient &client)
+{
+  size_t start = client.sent.rfind("GET ");
+  size_t end = client.sent.find("\r\n", client.sent.find("Host: ", start));
+  return client.sent.substr(start, end - start);
+}
+
+int main()
+{
+  Serial.quiet = true;
+
+  std::string body = readFile("forecast.json");
+  MockClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+
+  // The path is sent (origin-form), the server name is in the Host header
+  OW_forecast *forecast = new OW_forecast;
+  client.responses.push_back(httpResponse(body));
+  CHECK(ow.getForecast(forecast, "key", "51.5085", "-0.1257", "metric", "en"));
+  CHECK(requestHead(client) ==
+        "GET /data/2.5/forecast?lat=51.5085&lon=-0.1257&units=metric&lang=en&appid=key HTTP/1.1\r\n"
+        "Host: api.openweathermap.org");
+  CHECK(client.host == "api.openweathermap.org");
+
+  // The location as a String, a float, a double or an int
+  String lat = "51.5085";
+  client.responses.push_back(httpResponse(body));
+  CHECK(ow.getForecast(forecast, "key", lat, String("-0.1257"), "metric", "en"));
+  CHECK(requestHead(client).find("lat=51.5085&lon=-0.1257&") != std::string::npos);
+
+  client.responses.push_back(httpResponse(body));
+  CHECK(ow.getForecast(forecast, "key", 51.5085f, -0.1257, "metric", "en"));
+  CHECK(requestHead(client).find("lat=51.5085&lon=-0.1257&") != std::string::npos);
+
+  client.responses.push_back(httpResponse(body));
+  CHECK(ow.getForecast(forecast, "key", 0, -1, "metric", "en"));
+  CHECK(requestHead(client).find("lat=0.0000&lon=-1.0000&") != std::string::npos);
+  delete forecast;
+
+  // A full sketch url is sent as a path too
+  client.responses.push_back(httpResponse(body));
+  CHECK(ow.parseRequest("https://api.openweathermap.org/data/2.5/forecast?lat=1&lon=2&appid=k"));
+  CHECK(requestHead(client) ==
+        "GET /data/2.5/forecast?lat=1&lon=2&appid=k HTTP/1.1\r\nHost: api.openweathermap.org");
+
+  client.responses.push_back(httpResponse(body));
+  CHECK(ow.parseRequest("http://api.openweathermap.org"));
+  CHECK(requestHead(client) == "GET / HTTP/1.1\r\nHost: api.openweathermap.org");
+
+  // A path is sent unchanged, even with a url in the query
+  client.responses.push_back(httpResponse(body));
+  CHECK(ow.parseRequest("/data/2.5/forecast?next=http://x/y"));
+  CHECK(requestHead(client) == "GET /data/2.5/forecast?next=http://x/y HTTP/1.1\r\nHost: api.openweathermap.org");
+
+  // The Host header follows setServer(), with the port if it is not the default
+  ow.setServer("127.0.0.1", 8080);
+  client.responses.push_back(httpResponse(body));
+  CHECK(ow.parseRequest("/data/2.5/forecast?lat=1&lon=2"));
+  CHECK(requestHead(client) == "GET /data/2.5/forecast?lat=1&lon=2 HTTP/1.1\r\nHost: 127.0.0.1:8080");
+
+  // Nothing is added after text that did not fit
+  char text[8];
+  OW_RequestBuilder builder(text, sizeof(text));
+  builder.add("abc").add("defgh").add('x').addEncoded("y");
+  CHECK(!builder.fits() && strcmp(text, "abc") == 0 && builder.length() == 3);
+
+  // Numbers, rounded, no sign when zero, not finite or too big dropped
+  const struct { float value; const char *text; bool fits; } numbers[] = {
+    { 1.23456f, "1.2346", true }, { -1.23456f, "-1.2346", true }, { -0.00001f, "0.0000", true },
+    { -0.0f, "0.0000", true }, { -0.00006f, "-0.0001", true }, { 1e10f, "", false },
+    { NAN, "", false }, { INFINITY, "", false }, { -INFINITY, "", false },
+  };
+  for (const auto &number : numbers) {
+    char digits[16];
+    bool fits = OW_RequestBuilder(digits, sizeof(digits)).addNumber(number.value, 4).fits();
+    if (strcmp(digits, number.text) != 0 || fits != number.fits) {
+      ::printf("addNumber(%g) gave \"%s\"\n", number.value, digits);
+      ++testFailures();
+    }
+  }
+
+  // A location that is not a number fails the request without connecting
+  int connects = client.connects;
+  forecast = new OW_forecast;
+  CHECK(!ow.getForecast(forecast, "key", NAN, 0, "metric", "en"));
+  CHECK(!ow.getForecast(forecast, "key", "", "", "metric", "en"));
+  CHECK(client.connects == connects);
+  delete forecast;
+
+  return testResult("test_request");
+}
@@ -0,0 +1,254 @@
+// Phase timeouts, the request deadline and retries, see setTimeouts() and setRetry()
+
+// A local MockServer stalls part way through the response header or body, or sends it
+// slowly but steadily. A stalled connect is made to a listener with a full accept
+// queue. Each stall must fail the request after its own timeout, or at the deadline if
+// that is sooner, while a slow response that keeps arriving must not be timed out
+// until the deadline. The rest of a body read only to keep the connection open is given
+// up after the idle timeout. Failed requests are retried up to the limit, with waits
+// inside the jitter bounds, and a client error response is not retried.
+
+#include <Arduino.h>
+#include <OpenWeather.h>
+
+#include "mock_server.h"
+#include "test_util.h"
+
+// Listener that never accepts, with its queue filled so a new connect is not answered
+class FullListener {
+
+  public:
+    FullListener() {
+      listener = socket(AF_INET, SOCK_STREAM, 0);
+      sockaddr_in address = {};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      socklen_t size = sizeof(address);
+      bind(listener, (sockaddr *)&address, size);
+      listen(listener, 0);
+      getsockname(listener, (sockaddr *)&address, &size);
+      listenPort = ntohs(address.sin_port);
+
+      queued = socket(AF_INET, SOCK_STREAM, 0);
+      connect(queued, (sockaddr *)&address, size);
+    }
+
+    ~FullListener() {
+      close(queued);
+      close(listener);
+    }
+
+    uint16_t port() const { return listenPort; }
+
+  private:
+    int listener, queued;
+    uint16_t listenPort;
+};
+
+struct Forecast {
+  uint32_t dt[MAX_3HRS];
+  uint32_t sunrise;
+};
+
+static const OW_Field forecastFields[] = {
+  OW_FIELD(Forecast, dt,      LIST, LIST, DT),
+  OW_FIELD(Forecast, sunrise, CITY, CITY, SUNRISE),
+};
+
+struct Current {
+  uint32_t dt;
+};
+
+static const OW_Field currentFields[] = {
+  OW_FIELD(Current, dt, CURRENT, CURRENT, DT),
+};
+
+static uint32_t elapsed; // Time taken by the last fetch
+
+static bool fetch(OW_Weather &ow, Forecast *forecast)
+{
+  memset(forecast, 0, sizeof(Forecast));
+  uint32_t start = millis();
+  bool ok = ow.getForecast(OW_dataSet(forecast, forecastFields), "key", "0", "0", "metric", "en", false);
+  elapsed = millis() - start;
+  return ok;
+}
+
+// Current values only, the rest of the onecall body is read after the parse
+static bool fetchCurrent(OW_Weather &ow, Current *current)
+{
+  current->dt = 0;
+  uint32_t start = millis();
+  bool ok = ow.getForecast(OW_dataSet(current, currentFields), OW_dataSet(), OW_dataSet(),
+                           "key", "0", "0", "metric", "en", false);
+  elapsed = millis() - start;
+  return ok;
+}
+
+// Timeouts, all long unless set
+static OW_Timeouts timeouts(uint32_t connect, uint32_t header, uint32_t idle, uint32_t deadline)
+{
+  OW_Timeouts t;
+  t.connect = connect;
+  t.header = header;
+  t.idle = idle;
+  t.deadline = deadline;
+  return t;
+}
+
+// The fetch took from at least ms to well before the other timeouts
+#define TOOK(ms) CHECK(elapsed >= (ms) && elapsed < (ms) + 400)
+
+#define LONG 5000
+
+int main()
+{
+  Serial.quiet = true;
+
+  std::string body = readFile("forecast.json");
+  std::string response = httpResponse(body);
+  size_t header = response.size() - body.size();
+  std::string onecall = httpResponse(readFile("onecall.json"));
+
+  MockServer server;
+  OW_PosixClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+  ow.setServer("127.0.0.1", server.port());
+  Forecast *forecast = new Forecast;
+  Current *current = new Current;
+
+  // Connect timeout, and the deadline if sooner
+  {
+    FullListener full;
+    ow.setServer("127.0.0.1", full.port());
+    ow.setTimeouts(timeouts(200, LONG, LONG, LONG));
+    CHECK(!fetch(ow, forecast));
+    TOOK(200);
+    ow.setTimeouts(timeouts(LONG, LONG, LONG, 150));
+    CHECK(!fetch(ow, forecast));
+    TOOK(150);
+    CHECK(ow.lastResponse().status == 0);
+    ow.setServer("127.0.0.1", server.port());
+  }
+
+  // Header timeout, the server stops in the status line
+  server.pace(SIZE_MAX, 0, 5);
+  ow.setTimeouts(timeouts(LONG, 200, LONG, LONG));
+  CHECK(!fetch(ow, forecast));
+  TOOK(200);
+  CHECK(ow.lastResponse().status == 0);
+
+  // Body idle timeout, the server stops part way through the body
+  server.pace(SIZE_MAX, 0, header + 1000);
+  ow.setTimeouts(timeouts(LONG, LONG, 200, LONG));
+  CHECK(!fetch(ow, forecast));
+  TOOK(200);
+  CHECK(ow.lastResponse().status == 200);
+
+  // Deadline, sooner than the stalled phase's own timeout
+  ow.setTimeouts(timeouts(LONG, LONG, LONG, 250));
+  CHECK(!fetch(ow, forecast));
+  TOOK(250);
+
+  // A slow response that keeps arriving is not timed out by the phase timeouts, each
+  // 1000 byte piece comes 40 ms after the last
+  server.pace(1000, 40);
+  ow.setTimeouts(timeouts(LONG, 100, 100, LONG));
+  CHECK(fetch(ow, forecast));
+  CHECK(elapsed >= 40 * (body.size() / 1000 - 2));
+  CHECK(forecast->dt[MAX_3HRS - 1] != 0 && forecast->sunrise != 0);
+
+  // but it is by the deadline
+  ow.setTimeouts(timeouts(LONG, 100, 100, 300));
+  CHECK(!fetch(ow, forecast));
+  TOOK(300);
+
+  // The rest of a body read only to keep the connection open is given up after the idle
+  // timeout, or at the deadline if sooner. The values were parsed so the request is OK,
+  // and a new connection is used for the next one.
+  server.respond([onecall](const std::string &) { return onecall; });
+  server.pace(SIZE_MAX, 0, onecall.size() - 1000);
+  ow.keepAlive(true);
+  ow.setTimeouts(timeouts(LONG, LONG, 200, LONG));
+  CHECK(fetchCurrent(ow, current));
+  TOOK(200);
+  CHECK(current->dt == 1700000000);
+
+  ow.setTimeouts(timeouts(LONG, LONG, LONG, 250));
+  int connections = server.connections();
+  CHECK(fetchCurrent(ow, current));
+  TOOK(250);
+  CHECK(server.connections() == connections + 1);
+
+  // Slow but steady, the whole body is read and the connection is used again
+  server.pace(2000, 20);
+  ow.setTimeouts(timeouts(LONG, 100, 100, LONG));
+  connections = server.connections();
+  for (int i = 0; i < 2; i++) CHECK(fetchCurrent(ow, current));
+  CHECK(server.connections() == connections + 1);
+  ow.keepAlive(false);
+  server.pace(SIZE_MAX, 0);
+
+  // Retries, each wait is half the backoff plus a random part up to the other half, the
+  // backoff doubling up to the limit: 10-20, 20-40, 40-80 and 40-80 ms
+  std::string unavailable = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 11\r\n\r\n{\"cod\":503}";
+  server.respond([unavailable](const std::string &) { return unavailable; });
+  ow.setTimeouts(OW_Timeouts());
+  ow.setRetry(4, 20, 80);
+  uint16_t retries = ow.connectStats().retries;
+  size_t requests = server.requests().size();
+  CHECK(!fetch(ow, forecast));
+  CHECK(ow.connectStats().retries == retries + 4);
+  CHECK(server.requests().size() == requests + 5);
+  CHECK(ow.lastResponse().status == 503);
+  CHECK(elapsed >= 10 + 20 + 40 + 40 && elapsed < 20 + 40 + 80 + 80 + 400);
+
+  // Each wait within its bounds, and not all the same
+  ow.setRetry(1, 40, 40);
+  uint32_t shortest = UINT32_MAX, longest = 0;
+  for (int i = 0; i < 20; i++) {
+    CHECK(!fetch(ow, forecast));
+    shortest = std::min(shortest, elapsed);
+    longest = std::max(longest, elapsed);
+  }
+  CHECK(shortest >= 20 && longest < 40 + 100);
+  CHECK(longest - shortest >= 5);
+
+  // No retry that would end after the deadline
+  ow.setTimeouts(timeouts(LONG, LONG, LONG, 100));
+  ow.setRetry(5, 40, 40);
+  retries = ow.connectStats().retries;
+  CHECK(!fetch(ow, forecast));
+  retries = ow.connectStats().retries - retries;
+  CHECK(retries >= 2 && retries <= 4);
+  CHECK(elapsed < 100 + 50);
+
+  // A client error is not retried, except 408 and 429
+  ow.setTimeouts(OW_Timeouts());
+  ow.setRetry(3, 10, 10);
+  const char *statuses[] = { "400 Bad Request", "401 Unauthorized", "404 Not Found", "408 Request Timeout",
+                             "429 Too Many Requests" };
+  for (const char *status : statuses) {
+    std::string reply = std::string("HTTP/1.1 ") + status + "\r\nContent-Length: 2\r\n\r\n{}";
+    server.respond([reply](const std::string &) { return reply; });
+    retries = ow.connectStats().retries;
+    requests = server.requests().size();
+    CHECK(!fetch(ow, forecast));
+    bool retried = atoi(status) == 408 || atoi(status) == 429;
+    CHECK(ow.connectStats().retries == retries + (retried ? 3 : 0));
+    CHECK(server.requests().size() == requests + (retried ? 4 : 1));
+  }
+
+  // A retry that succeeds
+  std::atomic<int> failures(2);
+  server.respond([&](const std::string &) { return failures-- > 0 ? unavailable : response; });
+  retries = ow.connectStats().retries;
+  CHECK(fetch(ow, forecast));
+  CHECK(ow.connectStats().retries == retries + 2);
+  CHECK(forecast->sunrise != 0);
+
+  delete forecast;
+  delete current;
+  return testResult("test_retry");
+}
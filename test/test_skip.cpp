@@ -0,0 +1,118 @@
+// Skipping of unwanted values in front of the JSON_Decoder
+
+// Unwanted members that are hard to skip are added to the forecast response: nested
+// objects and arrays, strings holding brackets, escaped quotes and backslashes, and
+// skipped values that end an object or array. Each response must parse to the same
+// values as the original, read in blocks of 1 byte up, so the skip state is carried
+// between reads. A struct holding fewer list slots than sent has the rest of the array
+// skipped, which must end at the right bracket for the city values after it.
+// Run with the real JSON_Decoder when CMake finds it, see CMakeLists.txt.
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+
+#include "test_util.h"
+
+template <int N> struct Forecast {
+  uint32_t dt[N];
+  float    temp[N];
+  String   description[N];
+  float    pop[N];
+  String   dt_txt[N];
+  String   city_name;
+  uint32_t sunrise;
+  uint32_t sunset;
+};
+
+#define FORECAST_FIELDS(S) {                      \
+  OW_FIELD(S, dt,          LIST, LIST, DT),       \
+  OW_FIELD(S, temp,        LIST, MAIN, TEMP),     \
+  OW_FIELD(S, description, LIST, WEATHER, DESCRIPTION), \
+  OW_FIELD(S, pop,         LIST, LIST, POP),      \
+  OW_FIELD(S, dt_txt,      LIST, LIST, DT_TXT),   \
+  OW_FIELD(S, city_name,   CITY, CITY, NAME),     \
+  OW_FIELD(S, sunrise,     CITY, CITY, SUNRISE),  \
+  OW_FIELD(S, sunset,      CITY, CITY, SUNSET),   \
+}
+
+typedef Forecast<MAX_3HRS> FullForecast;
+typedef Forecast<10>       ShortForecast;
+static const OW_Field fullFields[]  = FORECAST_FIELDS(FullForecast);
+static const OW_Field shortFields[] = FORECAST_FIELDS(ShortForecast);
+
+template <int N> static bool operator==(const Forecast<N> &a, const Forecast<N> &b)
+{
+  for (int i = 0; i < N; i++) {
+    if (a.dt[i] != b.dt[i] || a.temp[i] != b.temp[i] || a.pop[i] != b.pop[i] ||
+        a.description[i] != b.description[i] || a.dt_txt[i] != b.dt_txt[i]) return false;
+  }
+  return a.city_name == b.city_name && a.sunrise == b.sunrise && a.sunset == b.sunset;
+}
+
+static MockClient client;
+static OW_Weather ow;
+
+template <int N> static bool parse(const std::string &body, Forecast<N> &forecast, const OW_Field (&fields)[8])
+{
+  client.responses.push_back(httpResponse(body));
+  return ow.getForecast(OW_dataSet(&forecast, fields), "key", "0", "0", "metric", "en");
+}
+
+// Check the junk response gives the same values as the clean one, for each read size
+template <int N> static void compare(const std::string &clean, const std::string &junk, const OW_Field (&fields)[8])
+{
+  Forecast<N> *expected = new Forecast<N>;
+  client.maxRead = SIZE_MAX;
+  CHECK(parse(clean, *expected, fields));
+  CHECK(expected->dt[N - 1] != 0 && expected->sunset != 0);
+
+  for (size_t readSize : { 1, 2, 3, 5, 7, 13, 64, 511, 100000 }) {
+    Forecast<N> *parsed = new Forecast<N>;
+    client.maxRead = readSize;
+    bool ok = parse(junk, *parsed, fields);
+    if (!ok || !(*parsed == *expected)) {
+      ::printf("%d slots, read size %zu: ok %d\n", N, readSize, ok);
+      ++testFailures();
+    }
+    delete parsed;
+  }
+  delete expected;
+}
+
+int main()
+{
+  Serial.quiet = true;
+  ow.setClient(&client);
+
+  std::string clean = readFile("forecast.json");
+
+  // A nested object with bracket and quote characters in strings, last in "sys"
+  std::string junk = replaceAll(clean, "\"pod\": \"d\"}",
+    "\"pod\": \"d\", \"junk\": {\"s\": \"a\\\"}]{[\\\\\", \"n\": [1, [2, {\"x\": \"}\"}], null, true], \"e\": {}}}");
+
+  // A string and an array ending in an object, last in a "weather" array element
+  junk = replaceAll(junk, "\"}], \"clouds\"",
+    "\", \"note\": \"q\\\"]}\", \"codes\": [3, \"]\", -1.5e-3, {\"a\": [4, \"\\\\\"]}]}], \"clouds\"");
+
+  // Top level values of every kind before the city, and an empty string, object and array
+  junk = replaceAll(junk, "\"city\":",
+    "\"junk\": [1, [2, {\"x\": \"}\"}], null, true, false, \"]\", \"\"], \"o\": {}, \"a\": [], \"city\":");
+
+  // Unwanted scalars ending objects
+  junk = replaceAll(junk, "\"population\": 1000000,", "\"population\": 1000000, \"n\": null, \"t\": true,");
+  junk = replaceAll(junk, "\"sunset\": 1699978000}", "\"sunset\": 1699978000, \"zone\": \"GMT\\\"\\\\\", \"last\": 12.5e1}");
+
+  CHECK(junk.size() > clean.size() + 1000);
+
+  compare<MAX_3HRS>(clean, junk, fullFields);
+  compare<10>(clean, junk, shortFields);
+
+  // A truncated response fails
+  client.maxRead = SIZE_MAX;
+  FullForecast *forecast = new FullForecast;
+  CHECK(!parse(clean.substr(0, clean.size() / 3), *forecast, fullFields));
+  delete forecast;
+
+  return testResult("test_skip");
+}
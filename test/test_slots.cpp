@@ -0,0 +1,234 @@
+// Per slot callback, see OW_Weather::onSlot()
+
+// The sample responses are first parsed without a callback into a struct holding every
+// slot the server sends, with a table for each section giving the same JSON paths as
+// OW_slotFields. With a callback set each "list", "hourly" and "daily" element must give
+// one call, in order, with the record holding that element's values and values missing
+// from an element zero. A struct with fewer slots than sent keeps the first slots and
+// nothing is written past its arrays, and with no struct at all only the callback is fed.
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+#include <vector>
+
+#include "test_util.h"
+
+#define MAX_SLOTS 48
+
+// Values of every element of one section, as the callback records should hold them
+struct Slots {
+  uint32_t dt[MAX_SLOTS];
+  float    temp[MAX_SLOTS];
+  float    temp_min[MAX_SLOTS];
+  float    temp_max[MAX_SLOTS];
+  float    feels_like[MAX_SLOTS];
+  float    pressure[MAX_SLOTS];
+  uint8_t  humidity[MAX_SLOTS];
+  uint8_t  clouds[MAX_SLOTS];
+  float    wind_speed[MAX_SLOTS];
+  uint16_t wind_deg[MAX_SLOTS];
+  float    wind_gust[MAX_SLOTS];
+  float    pop[MAX_SLOTS];
+  float    rain[MAX_SLOTS];
+  float    snow[MAX_SLOTS];
+  uint32_t visibility[MAX_SLOTS];
+  uint16_t id[MAX_SLOTS];
+  uint8_t  night[OW_BITS(MAX_SLOTS)];
+};
+
+static const OW_Field listFields[] = {
+  OW_FIELD(Slots, dt,         LIST, LIST,    DT),
+  OW_FIELD(Slots, temp,       LIST, MAIN,    TEMP),
+  OW_FIELD(Slots, temp_min,   LIST, MAIN,    TEMP_MIN),
+  OW_FIELD(Slots, temp_max,   LIST, MAIN,    TEMP_MAX),
+  OW_FIELD(Slots, feels_like, LIST, MAIN,    FEELS_LIKE),
+  OW_FIELD(Slots, pressure,   LIST, MAIN,    PRESSURE),
+  OW_FIELD(Slots, humidity,   LIST, MAIN,    HUMIDITY),
+  OW_FIELD(Slots, clouds,     LIST, CLOUDS,  ALL),
+  OW_FIELD(Slots, wind_speed, LIST, WIND,    SPEED),
+  OW_FIELD(Slots, wind_deg,   LIST, WIND,    DEG),
+  OW_FIELD(Slots, wind_gust,  LIST, WIND,    GUST),
+  OW_FIELD(Slots, pop,        LIST, LIST,    POP),
+  OW_FIELD(Slots, rain,       LIST, RAIN,    3H),
+  OW_FIELD(Slots, snow,       LIST, SNOW,    3H),
+  OW_FIELD(Slots, visibility, LIST, LIST,    VISIBILITY),
+  OW_FIELD(Slots, id,         LIST, WEATHER, ID),
+  OW_FIELD_NIGHT(Slots, night, MAX_SLOTS, LIST, WEATHER),
+};
+
+static const OW_Field hourlyFields[] = {
+  OW_FIELD(Slots, dt,         HOURLY, HOURLY,  DT),
+  OW_FIELD(Slots, temp,       HOURLY, HOURLY,  TEMP),
+  OW_FIELD(Slots, feels_like, HOURLY, HOURLY,  FEELS_LIKE),
+  OW_FIELD(Slots, pressure,   HOURLY, HOURLY,  PRESSURE),
+  OW_FIELD(Slots, humidity,   HOURLY, HOURLY,  HUMIDITY),
+  OW_FIELD(Slots, clouds,     HOURLY, HOURLY,  CLOUDS),
+  OW_FIELD(Slots, wind_speed, HOURLY, HOURLY,  WIND_SPEED),
+  OW_FIELD(Slots, wind_deg,   HOURLY, HOURLY,  WIND_DEG),
+  OW_FIELD(Slots, wind_gust,  HOURLY, HOURLY,  WIND_GUST),
+  OW_FIELD(Slots, pop,        HOURLY, HOURLY,  POP),
+  OW_FIELD(Slots, rain,       HOURLY, RAIN,    1H),
+  OW_FIELD(Slots, snow,       HOURLY, SNOW,    1H),
+  OW_FIELD(Slots, visibility, HOURLY, HOURLY,  VISIBILITY),
+  OW_FIELD(Slots, id,         HOURLY, WEATHER, ID),
+  OW_FIELD_NIGHT(Slots, night, MAX_SLOTS, HOURLY, WEATHER),
+};
+
+static const OW_Field dailyFields[] = {
+  OW_FIELD(Slots, dt,         DAILY, DAILY,      DT),
+  OW_FIELD(Slots, temp,       DAILY, TEMP,       DAY),
+  OW_FIELD(Slots, temp_min,   DAILY, TEMP,       MIN),
+  OW_FIELD(Slots, temp_max,   DAILY, TEMP,       MAX),
+  OW_FIELD(Slots, feels_like, DAILY, FEELS_LIKE, DAY),
+  OW_FIELD(Slots, pressure,   DAILY, DAILY,      PRESSURE),
+  OW_FIELD(Slots, humidity,   DAILY, DAILY,      HUMIDITY),
+  OW_FIELD(Slots, clouds,     DAILY, DAILY,      CLOUDS),
+  OW_FIELD(Slots, wind_speed, DAILY, DAILY,      WIND_SPEED),
+  OW_FIELD(Slots, wind_deg,   DAILY, DAILY,      WIND_DEG),
+  OW_FIELD(Slots, wind_gust,  DAILY, DAILY,      WIND_GUST),
+  OW_FIELD(Slots, pop,        DAILY, DAILY,      POP),
+  OW_FIELD(Slots, rain,       DAILY, DAILY,      RAIN),
+  OW_FIELD(Slots, snow,       DAILY, DAILY,      SNOW),
+  OW_FIELD(Slots, visibility, DAILY, DAILY,      VISIBILITY),
+  OW_FIELD(Slots, id,         DAILY, WEATHER,    ID),
+  OW_FIELD_NIGHT(Slots, night, MAX_SLOTS, DAILY, WEATHER),
+};
+
+// A struct holding fewer slots than sent, with a guard after its arrays
+#define SHORT_SLOTS 4
+#define GUARD 0xA5A5A5A5UL
+
+struct Short {
+  uint32_t dt[SHORT_SLOTS];
+  float    temp[SHORT_SLOTS];
+  uint32_t guard[8];
+};
+
+static const OW_Field shortFields[] = {
+  OW_FIELD(Short, dt,   LIST, LIST, DT),
+  OW_FIELD(Short, temp, LIST, MAIN, TEMP),
+};
+
+static std::vector<OW_slot> records;
+
+static void slotCallback(const OW_slot &slot)
+{
+  records.push_back(slot);
+}
+
+// Each record is the element it was called for, with the values of that element
+static int compare(uint8_t section, const Slots *expected, size_t count, size_t first = 0)
+{
+  int failed = 0;
+  for (size_t i = 0; i < count; i++) {
+    const OW_slot &s = records[first + i];
+    bool ok =
+      s.section    == section                  && s.index      == i                       &&
+      s.dt         == expected->dt[i]          && s.temp       == expected->temp[i]       &&
+      s.temp_min   == expected->temp_min[i]    && s.temp_max   == expected->temp_max[i]   &&
+      s.feels_like == expected->feels_like[i]  && s.pressure   == expected->pressure[i]   &&
+      s.humidity   == expected->humidity[i]    && s.clouds     == expected->clouds[i]     &&
+      s.wind_speed == expected->wind_speed[i]  && s.wind_deg   == expected->wind_deg[i]   &&
+      s.wind_gust  == expected->wind_gust[i]   && s.pop        == expected->pop[i]        &&
+      s.rain       == expected->rain[i]        && s.snow       == expected->snow[i]       &&
+      s.visibility == expected->visibility[i]  && s.id         == expected->id[i]         &&
+      s.night      == OW_isNight(expected->night, i);
+    if (!ok && failed++ < 5) ::printf("section %u slot %zu differs\n", section, i);
+  }
+  return failed;
+}
+
+int main()
+{
+  Serial.quiet = true;
+
+  std::string forecastResponse = httpResponse(readFile("forecast.json"));
+  std::string onecallResponse = httpResponse(readFile("onecall.json"));
+
+  MockClient client;
+  OW_Weather ow;
+  ow.setClient(&client);
+
+  // Every element of each section, parsed without a callback
+  Slots *list   = new Slots;
+  Slots *hourly = new Slots;
+  Slots *daily  = new Slots;
+  memset(list, 0, sizeof(Slots));
+  memset(hourly, 0, sizeof(Slots));
+  memset(daily, 0, sizeof(Slots));
+  client.responses.push_back(forecastResponse);
+  CHECK(ow.getForecast(OW_dataSet(list, listFields), "key", "0", "0", "metric", "en"));
+  client.responses.push_back(onecallResponse);
+  CHECK(ow.getForecast(OW_dataSet(), OW_dataSet(hourly, hourlyFields), OW_dataSet(daily, dailyFields),
+                       "key", "0", "0", "metric", "en"));
+  CHECK(list->dt[39] != 0 && hourly->dt[47] != 0 && daily->dt[7] != 0);
+
+  // Forecast API, one call for each of the 40 "list" elements, none from "city"
+  ow.onSlot(slotCallback);
+  OW_forecast *forecast = new OW_forecast;
+  client.responses.push_back(forecastResponse);
+  CHECK(ow.getForecast(forecast, "key", "0", "0", "metric", "en"));
+  CHECK(records.size() == 40);
+  if (records.size() == 40) CHECK(compare(OW_KEY_LIST, list, 40) == 0);
+
+  // The struct is filled as well, for the slots it holds
+  int failed = 0;
+  for (int i = 0; i < MAX_3HRS; i++) {
+    if (forecast->dt[i] != list->dt[i] || forecast->temp[i] != list->temp[i] ||
+        forecast->id[i] != list->id[i]) failed++;
+  }
+  CHECK(failed == 0);
+  CHECK(forecast->city_name == "London");
+
+  // Onecall API, the callback is given all 48 hourly and 8 daily elements even with
+  // no struct for them, so hourly and daily are not excluded from the request
+  records.clear();
+  OW_current *current = new OW_current;
+  client.sent.clear();
+  client.responses.push_back(onecallResponse);
+  CHECK(ow.getForecast(current, nullptr, nullptr, "key", "0", "0", "metric", "en"));
+  CHECK(client.sent.find("exclude=minutely,alerts&") != std::string::npos);
+  CHECK(records.size() == 48 + 8);
+  if (records.size() == 48 + 8) {
+    CHECK(compare(OW_KEY_HOURLY, hourly, 48) == 0);
+    CHECK(compare(OW_KEY_DAILY, daily, 8, 48) == 0);
+  }
+  CHECK(current->dt == 1700000000);
+
+  // A struct with fewer slots than the callback is given, only its slots are stored
+  records.clear();
+  Short *small = new Short;
+  memset(small, 0, sizeof(Short));
+  for (uint32_t &g : small->guard) g = GUARD;
+  client.responses.push_back(forecastResponse);
+  CHECK(ow.getForecast(OW_dataSet(small, shortFields), "key", "0", "0", "metric", "en"));
+  CHECK(records.size() == 40);
+  for (int i = 0; i < SHORT_SLOTS; i++) CHECK(small->dt[i] == list->dt[i] && small->temp[i] == list->temp[i]);
+  for (uint32_t g : small->guard) CHECK(g == GUARD);
+  if (records.size() == 40) CHECK(compare(OW_KEY_LIST, list, 40) == 0);
+
+  // Only the callback, no struct
+  records.clear();
+  client.responses.push_back(forecastResponse);
+  CHECK(ow.getForecast(OW_dataSet(), "key", "0", "0", "metric", "en"));
+  CHECK(records.size() == 40);
+  if (records.size() == 40) CHECK(compare(OW_KEY_LIST, list, 40) == 0);
+
+  // No calls once the callback is removed, and the early end is back
+  ow.onSlot(nullptr);
+  records.clear();
+  client.sent.clear();
+  client.responses.push_back(onecallResponse);
+  CHECK(ow.getForecast(current, nullptr, nullptr, "key", "0", "0", "metric", "en"));
+  CHECK(client.sent.find("exclude=minutely,alerts,hourly,daily&") != std::string::npos);
+  CHECK(records.empty());
+
+  delete list;
+  delete hourly;
+  delete daily;
+  delete forecast;
+  delete current;
+  delete small;
+  return testResult("test_slots");
+}
@@ -0,0 +1,70 @@
+// Helpers shared by the host tests
+
+#ifndef test_util_h
+#define test_util_h
+
+#include <Arduino.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Count a failed check and report where it is, the test exits with failures() as status
+#define CHECK(condition) \
+  do { if (!(condition)) { ++testFailures(); ::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); } } while (0)
+
+inline int &testFailures() { static int failures = 0; return failures; }
+
+inline int testResult(const char *name) {
+  ::printf("%s: %s\n", name, testFailures() ? "FAILED" : "passed");
+  return testFailures() ? 1 : 0;
+}
+
+// Sample response body from the test/data folder
+inline std::string readFile(const char *name) {
+  std::ifstream file(std::string(OW_TEST_DATA "/") + name, std::ios::binary);
+  if (!file) { ::printf("Can not read %s\n", name); exit(1); }
+  std::stringstream text;
+  text << file.rdbuf();
+  return text.str();
+}
+
+// Body with a response header, like the server sends without compression. headers are
+// added lines, each ending "\r\n", e.g. "Content-Encoding: gzip\r\n"
+inline std::string httpResponse(const std::string &body, const std::string &headers = "") {
+  return "HTTP/1.1 200 OK\r\nContent-Type: application/json; charset=utf-8\r\n" + headers +
+         "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+// Body sent in chunks of random size 1 to maxChunk, with random hex case, leading zeros,
+// chunk extensions and, for an odd seed, trailers
+inline std::string chunkedResponse(const std::string &body, unsigned seed, size_t maxChunk,
+                                   const std::string &headers = "") {
+  srand(seed);
+  std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n" + headers +
+                         "Transfer-Encoding: chunked\r\n\r\n";
+
+  for (size_t pos = 0; pos < body.size(); ) {
+    size_t n = std::min(1 + rand() % maxChunk, body.size() - pos);
+    char size[24];
+    snprintf(size, sizeof(size), (rand() & 1) ? "%zx" : "%zX", n);
+    if (rand() % 8 == 0) response += "0"; // Leading zero
+    response += size;
+    if (rand() % 5 == 0) response += ";name=\"value\"";
+    response += "\r\n" + body.substr(pos, n) + "\r\n";
+    pos += n;
+  }
+
+  response += "0\r\n";
+  if (seed & 1) response += "X-Trailer: yes\r\nX-Other: 1\r\n";
+  return response + "\r\n";
+}
+
+// Replace every copy of from in text
+inline std::string replaceAll(std::string text, const std::string &from, const std::string &to) {
+  for (size_t i = text.find(from); i != std::string::npos; i = text.find(from, i + to.size()))
+    text.replace(i, from.size(), to);
+  return text;
+}
+
+#endif
@@ -0,0 +1,266 @@
+// OW_Worker fetching queued OW_Job requests on its own thread, against a local MockServer
+
+// The server answers by latitude: 1 the forecast response, 2 a 404, 3 the onecall
+// response, 4 a 500. It can hold a response back, so jobs are queued behind a running
+// one and end() or the destructor is called while a job is in flight. Each job must
+// finish once, with one callback giving its result and response header, in the order
+// submitted. All jobs of a worker use one connection, and the worker's parser is used
+// for forecast and onecall jobs in turn. A job filling an OW_DoubleBuffer publishes
+// only if it parsed OK. The values parsed with MockClient are the reference.
+
+#include <Arduino.h>
+#include <MockClient.h>
+#include <OpenWeather.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "mock_server.h"
+#include "test_util.h"
+
+// Values compared with memcmp, so no String members
+struct Forecast {
+  uint32_t dt[MAX_3HRS];
+  float    temp[MAX_3HRS];
+  uint16_t id[MAX_3HRS];
+  uint32_t sunrise;
+};
+
+static const OW_Field forecastFields[] = {
+  OW_FIELD(Forecast, dt,      LIST, LIST, DT),
+  OW_FIELD(Forecast, temp,    LIST, MAIN, TEMP),
+  OW_FIELD(Forecast, id,      LIST, WEATHER, ID),
+  OW_FIELD(Forecast, sunrise, CITY, CITY, SUNRISE),
+};
+
+struct Current {
+  uint32_t dt;
+  float    temp;
+  uint16_t id;
+};
+
+static const OW_Field currentFields[] = {
+  OW_FIELD(Current, dt,   CURRENT, CURRENT, DT),
+  OW_FIELD(Current, temp, CURRENT, CURRENT, TEMP),
+  OW_FIELD(Current, id,   CURRENT, WEATHER, ID),
+};
+
+// Latitude of each kind of response
+#define FORECAST "1"
+#define NOT_FOUND "2"
+#define ONECALL "3"
+#define SERVER_ERROR "4"
+
+static std::atomic<bool> hold(false); // Server waits before answering while set
+
+// One callback, as the worker thread runs it
+struct Call {
+  int      job;
+  bool     ok;
+  uint16_t status;
+};
+
+static std::mutex callLock;
+static std::vector<Call> calls;
+
+static void jobDone(OW_Job &job, bool ok)
+{
+  std::lock_guard<std::mutex> guard(callLock);
+  calls.push_back({ *(int *)job.context, ok, job.response.status });
+}
+
+// Callbacks so far, safe to read from the test thread
+static std::vector<Call> callsMade()
+{
+  std::lock_guard<std::mutex> guard(callLock);
+  return calls;
+}
+
+static void clearCalls()
+{
+  std::lock_guard<std::mutex> guard(callLock);
+  calls.clear();
+}
+
+// Wait up to a second for the job to be taken by the worker
+static bool running(OW_Job &job)
+{
+  for (int i = 0; i < 1000 && job.jobState() != OW_JOB_RUNNING; i++) delay(1);
+  return job.jobState() == OW_JOB_RUNNING;
+}
+
+int main()
+{
+  Serial.quiet = true;
+
+  std::string forecastBody = readFile("forecast.json");
+  std::string onecallBody = readFile("onecall.json");
+  std::string notFound = "{\"cod\":\"404\",\"message\":\"city not found\"}";
+
+  MockServer server;
+  server.respond([&](const std::string &head) {
+    while (hold) delay(1);
+    if (head.find("lat=" FORECAST "&") != std::string::npos) return httpResponse(forecastBody);
+    if (head.find("lat=" ONECALL "&") != std::string::npos)  return httpResponse(onecallBody);
+    if (head.find("lat=" NOT_FOUND "&") != std::string::npos) {
+      return "HTTP/1.1 404 Not Found\r\nContent-Length: " + std::to_string(notFound.size()) + "\r\n\r\n" + notFound;
+    }
+    return std::string("HTTP/1.1 500 Internal Server Error\r\nContent-Length: 11\r\n\r\n{\"cod\":500}");
+  });
+
+  // Reference values
+  Forecast *expected = new Forecast;
+  Current  *expectedCurrent = new Current;
+  {
+    MockClient client;
+    OW_Weather ow;
+    ow.setClient(&client);
+    client.responses.push_back(httpResponse(forecastBody));
+    CHECK(ow.getForecast(OW_dataSet(expected, forecastFields), "key", "0", "0", "metric", "en"));
+    client.responses.push_back(httpResponse(onecallBody));
+    CHECK(ow.getForecast(OW_dataSet(expectedCurrent, currentFields), OW_dataSet(), OW_dataSet(),
+                         "key", "0", "0", "metric", "en"));
+    CHECK(expected->sunrise != 0 && expectedCurrent->dt != 0);
+  }
+
+  OW_PosixClient client;
+  OW_Worker worker;
+  worker.weather().setClient(&client);
+  worker.weather().setServer("127.0.0.1", server.port());
+
+  OW_Job job;
+  CHECK(!worker.submit(job)); // Not started
+  CHECK(worker.begin());
+
+  // Several jobs queued behind a held one, one callback each in the order submitted
+  const int JOBS = 1 + OW_WORKER_QUEUE;
+  const char *lat[JOBS] = { FORECAST, NOT_FOUND, ONECALL, SERVER_ERROR, FORECAST };
+  const uint16_t status[JOBS] = { 200, 404, 200, 500, 200 };
+  OW_Job jobs[JOBS];
+  int ids[JOBS];
+  Forecast *forecasts = new Forecast[JOBS];
+  Current  *currents = new Current[JOBS];
+  memset(forecasts, 0, sizeof(Forecast) * JOBS);
+  memset(currents, 0, sizeof(Current) * JOBS);
+
+  for (int i = 0; i < JOBS; i++) {
+    ids[i] = i;
+    jobs[i].context = &ids[i];
+    jobs[i].callback = jobDone;
+    if (!strcmp(lat[i], ONECALL)) {
+      jobs[i].oneCall(OW_dataSet(&currents[i], currentFields), OW_dataSet(), OW_dataSet(),
+                      "key", lat[i], "0", "metric", "en", false);
+    }
+    else jobs[i].forecast(OW_dataSet(&forecasts[i], forecastFields), "key", lat[i], "0", "metric", "en", false);
+  }
+
+  hold = true;
+  CHECK(worker.submit(jobs[0]));
+  CHECK(running(jobs[0]));
+  for (int i = 1; i < JOBS; i++) CHECK(worker.submit(jobs[i]));
+  CHECK(jobs[JOBS - 1].jobState() == OW_JOB_QUEUED);
+  CHECK(!worker.submit(jobs[1]));  // Already queued
+  CHECK(!worker.submit(job));      // Queue full
+  CHECK(!jobs[0].wait(20));        // Still held
+  CHECK(callsMade().empty());
+  hold = false;
+
+  for (int i = 0; i < JOBS; i++) CHECK(jobs[i].wait(5000));
+  std::vector<Call> made = callsMade();
+  CHECK(made.size() == JOBS);
+  for (size_t i = 0; i < made.size(); i++) {
+    CHECK(made[i].job == (int)i);
+    CHECK(made[i].ok == (status[i] == 200));
+    CHECK(made[i].status == status[i]);
+  }
+  for (int i = 0; i < JOBS; i++) {
+    CHECK(jobs[i].ok() == (status[i] == 200));
+    CHECK(jobs[i].jobState() == (status[i] == 200 ? OW_JOB_DONE : OW_JOB_ERROR));
+    CHECK(jobs[i].response.status == status[i]);
+  }
+  CHECK(memcmp(&forecasts[0], expected, sizeof(Forecast)) == 0);
+  CHECK(memcmp(&forecasts[4], expected, sizeof(Forecast)) == 0);
+  CHECK(memcmp(&currents[2], expectedCurrent, sizeof(Current)) == 0);
+
+  // A finished job can be submitted again, and wait() returns at once once finished
+  clearCalls();
+  memset(&forecasts[0], 0, sizeof(Forecast));
+  CHECK(worker.submit(jobs[0]));
+  CHECK(jobs[0].wait(5000));
+  CHECK(jobs[0].wait(0));
+  CHECK(jobs[0].ok() && memcmp(&forecasts[0], expected, sizeof(Forecast)) == 0);
+  CHECK(callsMade().size() == 1);
+
+  // Forecast and onecall jobs in turn on the kept open connection, the onecall body is
+  // only partly parsed so is read to its end for the next job
+  for (int i = 0; i < 6; i++) {
+    OW_Job &j = jobs[(i & 1) ? 2 : 0];
+    CHECK(worker.submit(j));
+    CHECK(j.wait(5000) && j.ok());
+  }
+  CHECK(memcmp(&forecasts[0], expected, sizeof(Forecast)) == 0);
+  CHECK(memcmp(&currents[2], expectedCurrent, sizeof(Current)) == 0);
+  CHECK(server.connections() == 1);
+
+  // Publish to a double buffer only if parsed OK
+  OW_DoubleBuffer<Forecast> buffer;
+  OW_Job published;
+  published.forecast(buffer, forecastFields, "key", FORECAST, "0", "metric", "en", false);
+  CHECK(worker.submit(published));
+  CHECK(published.wait(5000) && published.ok());
+  const Forecast *front = buffer.acquire();
+  CHECK(memcmp(front, expected, sizeof(Forecast)) == 0);
+  buffer.release(front);
+
+  published.forecast(buffer, forecastFields, "key", NOT_FOUND, "0", "metric", "en", false);
+  CHECK(worker.submit(published));
+  CHECK(published.wait(5000) && !published.ok());
+  front = buffer.acquire();
+  CHECK(memcmp(front, expected, sizeof(Forecast)) == 0);
+  buffer.release(front);
+
+  // end() with a job in flight and one queued, both finish before it returns
+  clearCalls();
+  hold = true;
+  CHECK(worker.submit(jobs[0]));
+  CHECK(running(jobs[0]));
+  CHECK(worker.submit(jobs[1]));
+  std::thread release([] { delay(50); hold = false; });
+  worker.end();
+  release.join();
+  CHECK(jobs[0].finished() && jobs[0].ok());
+  CHECK(jobs[1].finished() && !jobs[1].ok());
+  CHECK(callsMade().size() == 2);
+  CHECK(!worker.submit(jobs[0])); // Stopped
+
+  // Started again on a new connection
+  int connections = server.connections();
+  CHECK(worker.begin());
+  CHECK(worker.submit(jobs[2]));
+  CHECK(jobs[2].wait(5000) && jobs[2].ok());
+  CHECK(server.connections() == connections + 1);
+  worker.end();
+
+  // Destroyed with a job in flight
+  clearCalls();
+  std::thread unhold;
+  {
+    OW_Worker scoped;
+    scoped.weather().setClient(&client);
+    scoped.weather().setServer("127.0.0.1", server.port());
+    CHECK(scoped.begin());
+    hold = true;
+    CHECK(scoped.submit(jobs[4]));
+    CHECK(running(jobs[4]));
+    unhold = std::thread([] { delay(50); hold = false; });
+  }
+  unhold.join();
+  CHECK(jobs[4].finished() && jobs[4].ok());
+  CHECK(callsMade().size() == 1);
+
+  delete expected;
+  delete expectedCurrent;
+  delete[] forecasts;
+  delete[] currents;
+  return testResult("test_worker");
+}